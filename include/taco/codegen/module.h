@@ -2,6 +2,7 @@
 #define TACO_MODULE_H
 
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
@@ -12,6 +13,8 @@
 namespace taco {
 namespace ir {
 
+class TCCCompiler;
+
 class Module {
 public:
   /// Create a module for some target
@@ -21,10 +24,19 @@ public:
     setJITTmpdir();
   }
 
+  /// Unload the compiled library, if any
+  ~Module();
+
   void reset();
 
-  /// Compile the source into a library, returning its full path
+  /// Compile the source into a library, returning its full path. If the
+  /// target uses the in-process libtcc backend and libtcc accepts the code, the
+  /// code is compiled into memory instead and the empty string is returned.
   std::string compile();
+
+  /// Compile like `compile`, but if the compiler fails or the library cannot
+  /// be loaded, describe the failure in `error` instead of reporting it.
+  std::string compile(std::string* error);
   
   /// Compile the module into a source file located at the specified location
   /// path and prefix.  The generated source will be path/prefix.{.c|.bc, .h}
@@ -39,6 +51,10 @@ public:
 
   /// Get the source of the module as a string */
   std::string getSource();
+
+  /// True if the functions added to the module have loops that run on
+  /// multiple threads
+  bool hasParallelLoops() const;
   
   /// Get a function pointer to a compiled function. This returns a void*
   /// pointer, which the caller is required to cast to the correct function type
@@ -48,6 +64,9 @@ public:
 
   /// Call a raw function in this module and return the result
   int callFuncPackedRaw(std::string name, void** args);
+
+  /// Call a raw function, obtained from `getFuncPtr`, and return the result
+  static int callFuncPackedRaw(void* funcPtr, void** args);
   
   /// Call a raw function in this module and return the result
   int callFuncPackedRaw(std::string name, std::vector<void*> args) {
@@ -73,6 +92,7 @@ private:
   std::string libname;
   std::string tmpdir;
   void* lib_handle;
+  std::shared_ptr<TCCCompiler> tcc;
   std::vector<Stmt> funcs;
   
   // true iff the module was created from user-provided source
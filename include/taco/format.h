@@ -65,6 +65,13 @@ public:
   /// Sets the types of the coordinate arrays for each level
   void setLevelArrayTypes(std::vector<std::vector<Datatype>> levelArrayTypes);
 
+  /// Gets the type of positions in the levels of the format, which is the
+  /// widest type of the position arrays of its sparse levels and at least
+  /// Int32. Kernels use this type to iterate over the tensor's components,
+  /// and tensors whose position type is 64-bit are packed from buffers with
+  /// 64-bit positions, so that they can hold more than 2^31 components.
+  Datatype getPositionType() const;
+
 private:
   std::vector<ModeFormatPack> modeFormatPacks;
   std::vector<int> modeOrdering;
@@ -91,6 +98,9 @@ public:
   static ModeFormat Compressed;  /// alias for compressed
   static ModeFormat Sparse;      /// alias for compressed
   static ModeFormat Singleton;   /// alias for singleton
+  static ModeFormat Tile;        /// dense tile of a block-sparse format
+  static ModeFormat Hashed;      /// hash table per parent position
+  static ModeFormat Bitmap;      /// bitmap per parent position
 
   /// Properties of a mode format
   enum Property {
@@ -134,6 +144,13 @@ public:
   bool hasInsert() const;
   bool hasAppend() const;
 
+  /// Returns true if the mode's size is a constant in generated code, which is
+  /// the case for the tiles of block-sparse formats.
+  bool hasFixedSize() const;
+
+  /// Returns the number of slots of each hash table of a hashed mode format.
+  int getTableSize() const;
+
   /// Returns true if mode format is defined, false otherwise. An undefined mode
   /// type can be used to indicate a mode whose format is not (yet) known.
   bool defined() const;
@@ -175,6 +192,9 @@ extern const ModeFormat Dense;
 extern const ModeFormat Compressed;
 extern const ModeFormat Sparse;
 extern const ModeFormat Singleton;
+extern const ModeFormat Tile;
+extern const ModeFormat Hashed;
+extern const ModeFormat Bitmap;
 
 extern const ModeFormat dense;
 extern const ModeFormat compressed;
@@ -186,6 +206,21 @@ extern const Format CSC;
 extern const Format DCSR;
 extern const Format DCSC;
 
+/// Block compressed sparse row: a 4-order tensor B(ib,jb,ii,ji) holds the
+/// nonzero blocks of a matrix, where element (ii,ji) of block (ib,jb) is
+/// component (ib*r+ii, jb*c+ji) of the matrix with r×c blocks. The block size
+/// is given by the dimensions of the last two modes.
+extern const Format BCSR;
+
+/// Sliced ELLPACK (SELL-C-σ): a 4-order tensor S(s,k,r,j) holds a matrix whose
+/// rows are grouped into slices of C rows. Lane r of slice s stores one row of
+/// the matrix, and entry (s,k,r) is the k-th nonzero of that row with column
+/// j, where shorter rows are padded with zeros to the longest row in their
+/// slice. The C lanes are stored next to each other, so a loop over them
+/// processes C rows in lockstep. The slice size C is given by the dimension of
+/// the third mode. Use `makeSELL` to construct SELL tensors.
+extern const Format SELL;
+
 const Format COO(int order, bool isUnique = true, bool isOrdered = true, 
                  bool isAoS = false, const std::vector<int>& modeOrdering = {});
 /// @}
@@ -193,5 +228,15 @@ const Format COO(int order, bool isUnique = true, bool isOrdered = true,
 /// True if all modes are dense.
 bool isDense(const Format&);
 
+/// Returns the format with the narrowest coordinate array types for a tensor
+/// with the given dimensions. The coordinate arrays of modes with at most 256
+/// coordinates store UInt8 coordinates, those of modes with at most 65536
+/// coordinates store UInt16 coordinates, and the others Int32 coordinates.
+/// Narrow coordinates reduce the memory traffic of kernels that stream over
+/// the coordinate arrays, such as SpMV. Position arrays, the coordinate
+/// arrays of hashed modes, which mark empty slots with -1, and the arrays of
+/// bitmap modes keep their types.
+Format narrowCoordinateTypes(Format format, const std::vector<int>& dimensions);
+
 }
 #endif
@@ -167,6 +167,10 @@ public:
 /// Check if two index expressions are isomorphic.
 bool isomorphic(IndexExpr, IndexExpr);
 
+/// Hash the structure of an index expression. Isomorphic index expressions
+/// have the same structural hash.
+size_t structuralHash(IndexExpr);
+
 /// Compare two index expressions by value.
 bool equals(IndexExpr, IndexExpr);
 
@@ -640,11 +644,21 @@ public:
   /// integer number of iterations
   /// Preconditions: unrollFactor is a positive nonzero integer
   IndexStmt unroll(IndexVar i, size_t unrollFactor) const;
+
+  /// The mergeby primitive selects how the loop over i co-iterates its
+  /// operands. MergeStrategy::BlockIntersect skips unmatched coordinates of
+  /// two-way intersections in blocks, which pays off when the operands'
+  /// coordinates rarely coincide.
+  IndexStmt mergeby(IndexVar i, MergeStrategy strategy) const;
 };
 
 /// Check if two index statements are isomorphic.
 bool isomorphic(IndexStmt, IndexStmt);
 
+/// Hash the structure of an index statement. Isomorphic index statements have
+/// the same structural hash.
+size_t structuralHash(IndexStmt);
+
 /// Compare two index statments by value.
 bool equals(IndexStmt, IndexStmt);
 
@@ -718,7 +732,8 @@ public:
   Forall() = default;
   Forall(const ForallNode*);
   Forall(IndexVar indexVar, IndexStmt stmt);
-  Forall(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor = 0);
+  Forall(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor = 0,
+         MergeStrategy merge_strategy = MergeStrategy::TwoFinger);
 
   IndexVar getIndexVar() const;
   IndexStmt getStmt() const;
@@ -728,12 +743,15 @@ public:
 
   size_t getUnrollFactor() const;
 
+  MergeStrategy getMergeStrategy() const;
+
   typedef ForallNode Node;
 };
 
 /// Create a forall index statement.
 Forall forall(IndexVar i, IndexStmt stmt);
-Forall forall(IndexVar i, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor = 0);
+Forall forall(IndexVar i, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor = 0,
+              MergeStrategy merge_strategy = MergeStrategy::TwoFinger);
 
 
 /// A where statment has a producer statement that binds a tensor variable in
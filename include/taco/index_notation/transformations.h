@@ -1,6 +1,7 @@
 #ifndef TACO_TRANSFORMATIONS_H
 #define TACO_TRANSFORMATIONS_H
 
+#include <map>
 #include <memory>
 #include <string>
 #include <ostream>
@@ -205,7 +206,13 @@ IndexStmt scalarPromote(IndexStmt stmt);
 /**
  * Insert where statements with temporaries into the following statements kinds:
  * 1. The result is a is scattered into but does not support random insert.
+ *
+ * The temporaries are dense, unless they are large and expected to be
+ * sparsely filled, which is estimated from the numbers of `nonzeros` of the
+ * tensors the statement reads, in which case they are hash tables of the
+ * coordinates they hold.
  */
-IndexStmt insertTemporaries(IndexStmt stmt);
+IndexStmt insertTemporaries(IndexStmt stmt,
+                            const std::map<TensorVar,size_t>& nonzeros = {});
 }
 #endif
@@ -1,6 +1,7 @@
 #ifndef TACO_IR_H
 #define TACO_IR_H
 
+#include <atomic>
 #include <vector>
 #include <typeinfo>
 #include <utility>
@@ -90,7 +91,9 @@ struct IRNode : private util::Uncopyable {
    */
   virtual IRNodeType type_info() const = 0;
 
-  mutable long ref = 0;
+  /// Atomic, since the IR of a kernel that is compiled in the background is
+  /// shared with the thread that interprets it in the meantime.
+  mutable std::atomic<long> ref{0};
   friend void acquire(const IRNode* node) {
     ++(node->ref);
   }
@@ -751,6 +754,10 @@ struct GetProperty : public ExprNode<GetProperty> {
   static Expr make(Expr tensor, TensorProperty property, int mode=0);
   static Expr make(Expr tensor, TensorProperty property, int mode,
                    int index, std::string name);
+
+  /// Make an index array property whose elements have the given type.
+  static Expr make(Expr tensor, TensorProperty property, int mode,
+                   int index, std::string name, Datatype type);
   
   static const IRNodeType _type_info = IRNodeType::GetProperty;
 };
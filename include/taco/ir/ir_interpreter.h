@@ -0,0 +1,23 @@
+#ifndef TACO_IR_INTERPRETER_H
+#define TACO_IR_INTERPRETER_H
+
+#include "taco/ir/ir.h"
+
+namespace taco {
+namespace ir {
+
+/// Returns true iff `func` is a function that the IR interpreter can execute.
+/// Functions that yield results (coroutines) and functions that call external
+/// code other than the math library and taco's helper functions are not
+/// supported.
+bool canInterpret(const Stmt& func);
+
+/// Execute a lowered function directly, without generating and compiling
+/// code. The arguments are packed as for `Module::callFuncPacked`: outputs
+/// followed by inputs, where tensors are passed as `taco_tensor_t*`. The
+/// interpreter is much slower than compiled code, but it needs no setup, so
+/// it is useful while kernels compile or when they only run on tiny inputs.
+int interpret(const Stmt& func, void** args);
+
+}}
+#endif
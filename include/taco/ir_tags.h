@@ -16,6 +16,8 @@ extern const char *ParallelUnit_NAMES[];
 /// OutputRaceStrategy::NoRaces raises a compile-time error if an output race exists
 /// OutputRaceStrategy::Atomics replace racing instructions with atomics
 /// OutputRaceStrategy::Temporary uses a temporary array for outputs that is serially reduced
+/// (on CPU threads, dense outputs are privatized per thread and reduced in parallel, or
+/// updated with atomics if they are too large to privatize)
 /// OutputRaceStrategy::ParallelReduction uses reduction operations across a warp/vector
 /// OutputRaceStrategy::IgnoreRaces allows the user to specify that races can be safely ignored
 enum class OutputRaceStrategy {
@@ -23,6 +25,15 @@ enum class OutputRaceStrategy {
 };
 extern const char *OutputRaceStrategy_NAMES[];
 
+/// MergeStrategy::TwoFinger co-iterates operands one coordinate at a time
+/// MergeStrategy::BlockIntersect lowers intersections of two sorted, unique
+/// position iterators to a loop that skips over unmatched coordinates by
+/// comparing blocks of them at once (other merges fall back to TwoFinger)
+enum class MergeStrategy {
+  TwoFinger, BlockIntersect
+};
+extern const char *MergeStrategy_NAMES[];
+
 enum class BoundType {
   MinExact, MinConstraint, MaxExact, MaxConstraint
 };
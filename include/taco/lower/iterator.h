@@ -156,6 +156,13 @@ public:
   ir::Stmt getAppendFinalizeLevel(const ir::Expr& szPrev, 
       const ir::Expr& sz) const;
 
+  /// Return code for level functions that append coordinates of different
+  /// parent positions in parallel.
+  bool hasParallelAppend() const;
+  ir::Expr getAppendBegin(const ir::Expr& pPrev) const;
+  ir::Stmt getAppendScanLevel(const ir::Expr& szPrev) const;
+  ir::Stmt getAppendFillCoord(const ir::Expr& p, const ir::Expr& i) const;
+
   /// Returns true if the iterator is defined, false otherwise.
   bool defined() const;
 
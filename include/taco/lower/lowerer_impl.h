@@ -5,6 +5,7 @@
 #include <map>
 #include <set>
 #include <memory>
+#include <functional>
 #include <taco/index_notation/index_notation.h>
 
 #include "taco/lower/iterator.h"
@@ -68,6 +69,35 @@ protected:
   /// Lower a forall statement.
   virtual ir::Stmt lowerForall(Forall forall);
 
+  /// Lower the loops of a forall, which iterate over the merge lattice of the
+  /// forall's index variable.
+  ir::Stmt lowerForallLoops(Forall forall, MergeLattice lattice,
+                            std::set<Access> reducedAccesses,
+                            ir::Stmt recoveryStmt);
+
+  /// Returns the leaf levels of result tensors that a parallel forall can
+  /// append to in parallel, by assembling them in two passes. These are
+  /// levels whose ancestors all support insert, below a top-level forall that
+  /// CPU threads iterate over without races.
+  std::vector<Iterator> getParallelAppenders(Forall forall,
+                                             MergeLattice lattice);
+
+  /// Lower a parallel forall that appends to the given levels of the result
+  /// tensors. The assembly loops first count the coordinates of each parent
+  /// position of the levels, the counts are scanned into positions, and the
+  /// loops are then repeated to store the coordinates and values at the
+  /// positions, so that every iteration writes to its own part of the levels.
+  ir::Stmt lowerForallAppendInParallel(Forall forall, MergeLattice lattice,
+                                       std::set<Access> reducedAccesses,
+                                       ir::Stmt recoveryStmt,
+                                       std::vector<Iterator> appenders);
+
+  /// Privatize the results that the iterations of a parallel CPU forall race
+  /// on. Every thread reduces into its own zeroed copy of the results' values,
+  /// and the copies are reduced into the results in parallel after the loops.
+  ir::Stmt privatizeResults(Forall forall, std::vector<Access> resultAccesses,
+                            ir::Stmt loops);
+
   /// Lower a forall that needs to be cloned so that one copy does not have guards
   /// used for vectorized and unrolled loops
   virtual ir::Stmt lowerForallCloned(Forall forall);
@@ -81,6 +111,26 @@ protected:
                                         std::set<Access> reducedAccesses,
                                         ir::Stmt recoveryStmt);
 
+  /// Lower a forall over a dimension whose coordinates are determined by
+  /// bitmap locate iterators, by iterating over the words of the intersection
+  /// or union of the bitmaps. Returns an undefined statement if the bitmaps
+  /// do not determine the coordinates that contribute to the result.
+  ir::Stmt lowerForallBitmap(Forall forall, std::vector<Iterator> locators,
+                             std::vector<Iterator> inserters,
+                             std::vector<Iterator> appenders,
+                             std::set<Access> reducedAccesses,
+                             ir::Stmt recoveryStmt);
+
+  /// Lower a forall over the coordinates of a hashed workspace, by iterating
+  /// over the list of coordinates inserted into the workspace, which is sorted
+  /// first if the forall appends to ordered result levels. Returns an
+  /// undefined statement if the forall does not consume a hashed workspace.
+  ir::Stmt lowerForallHashed(Forall forall, std::vector<Iterator> locators,
+                             std::vector<Iterator> inserters,
+                             std::vector<Iterator> appenders,
+                             std::set<Access> reducedAccesses,
+                             ir::Stmt recoveryStmt);
+
   /// Lower a forall that iterates over the coordinates in the iterator, and
   /// locates tensor positions from the locate iterators.
   virtual ir::Stmt lowerForallCoordinate(Forall forall, Iterator iterator,
@@ -139,6 +189,14 @@ protected:
 
   virtual ir::Stmt resolveCoordinate(std::vector<Iterator> mergers, ir::Expr coordinate, bool emitVarDecl);
 
+  /// Lower a merge lattice that intersects two sorted, unique position
+  /// iterators to a loop in which the iterator that lags behind skips to the
+  /// other's coordinate by comparing blocks of coordinates at once. Returns an
+  /// undefined statement if the lattice is not such an intersection.
+  ir::Stmt lowerBlockIntersection(MergeLattice lattice, IndexVar coordinateVar,
+                                  IndexStmt statement,
+                                  const std::set<Access>& reducedAccesses);
+
     /**
      * Lower the merge point at the top of the given lattice to code that iterates
      * until one region of the sparse iteration space of coordinates and computes
@@ -173,6 +231,17 @@ protected:
   /// Lower a where statement.
   virtual ir::Stmt lowerWhere(Where where);
 
+  /// Lower an assignment to a hashed workspace, which inserts the coordinate
+  /// into the workspace's hash table and coordinate list if it is not there
+  /// yet, and accumulates into its value when computing.
+  ir::Stmt lowerHashedAssignment(Assignment assignment);
+
+  /// Allocates the `keys` of a hash table of a hashed workspace with `capacity`
+  /// slots, all empty, and (when computing) its `values` with a zero past the
+  /// last slot.
+  ir::Stmt allocateHashTable(TensorVar workspace, ir::Expr keys,
+                             ir::Expr values, ir::Expr capacity);
+
   /// Lower a sequence statement.
   virtual ir::Stmt lowerSequence(Sequence sequence);
 
@@ -310,8 +379,23 @@ protected:
    */
   ir::Stmt zeroInitValues(ir::Expr tensor, ir::Expr begin, ir::Expr size);
 
-  /// Declare position variables and initialize them with a locate.
-  ir::Stmt declLocatePosVars(std::vector<Iterator> iterators);
+  /// Declare position variables and initialize them with a locate. Locates
+  /// into modes that do not store every coordinate, such as hashed and bitmap
+  /// modes, may fail. If `found` is not null, the locate iterators that may
+  /// fail are added to it with the conditions that hold iff they succeed.
+  /// Inserters pass null, since inserting always succeeds.
+  ir::Stmt declLocatePosVars(std::vector<Iterator> iterators,
+                             std::vector<std::pair<Iterator,ir::Expr>>* found
+                                 = nullptr);
+
+  /// Lower a statement in the scope of locates that may fail. The statement is
+  /// zero where a locate into an operand whose access zeroes it fails, so
+  /// these locates are conjoined into `guard`. Where other locates fail, the
+  /// statement is lowered with their accesses zeroed.
+  ir::Stmt lowerLocated(IndexStmt stmt,
+                        std::vector<std::pair<Iterator,ir::Expr>> locates,
+                        std::function<ir::Stmt(IndexStmt)> lowerStmt,
+                        ir::Expr* guard);
 
   /// Emit loops to reduce duplicate coordinates.
   ir::Stmt reduceDuplicateCoordinates(ir::Expr coordinate, 
@@ -371,12 +455,37 @@ private:
   };
   std::map<TensorVar, TemporaryArrays> temporaryArrays;
 
+  /// Workspaces that are open-addressing hash tables of the coordinates
+  /// inserted into them, along with lists of those coordinates, instead of
+  /// dense arrays as large as their dimensions.
+  struct HashedWorkspace {
+    int tableSize;        // initial number of slots
+    ir::Expr keys;        // coordinate stored in each slot, or -1 if empty
+    ir::Expr values;      // value of each slot, followed by a zero
+    ir::Expr capacity;    // number of slots, a power of two
+    ir::Expr shift;       // 32 - log2(capacity)
+    ir::Expr coords;      // inserted coordinates
+    ir::Expr coordsCapacity;
+    ir::Expr size;        // number of inserted coordinates
+    ir::Expr slot;        // slot of the coordinate being consumed
+  };
+  std::map<TensorVar, HashedWorkspace> hashedWorkspaces;
+
   /// Map from result tensors to variables tracking values array capacity.
   std::map<ir::Expr, ir::Expr> capacityVars;
 
   /// Map from index variables to their dimensions, currently [0, expr).
   std::map<IndexVar, ir::Expr> dimensions;
 
+  /// Index variables that access tile modes, which have constant dimensions
+  /// and whose loops are unrolled.
+  std::set<IndexVar> tileIndexVars;
+
+  /// Locates computed by the loops that iterate over their coordinates, like
+  /// those of bitmap operands whose words are merged, which replace the locate
+  /// functions of the iterators' mode formats.
+  std::map<Iterator, ModeFunction> loopLocates;
+
   /// Map from index variables to their bounds, currently also [0, expr) but allows adding minimum in future too
   std::map<IndexVar, std::vector<ir::Expr>> underivedBounds;
 
@@ -402,6 +511,15 @@ private:
 
   int inParallelLoopDepth = 0;
 
+  /// Pass of the assembly of levels that are appended to in parallel.
+  enum class AppendPhase {Serial, Count, Fill};
+  AppendPhase appendPhase = AppendPhase::Serial;
+
+  /// Levels that the enclosing parallel forall appends to in parallel, and the
+  /// levels whose positions have been scanned after their count pass.
+  std::vector<Iterator> parallelAppenders;
+  std::set<Iterator> scannedAppenders;
+
   std::map<ParallelUnit, ir::Expr> parallelUnitSizes;
   std::map<ParallelUnit, IndexVar> parallelUnitIndexVars;
 
@@ -76,12 +76,21 @@ public:
   ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor, int mode, 
            int level);
 
+  /// Construct a mode pack whose i-th index array has elements of type
+  /// `arrayTypes[i]`, and whose positions have type `positionType`.
+  ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor, int mode, 
+           int level, const std::vector<Datatype>& arrayTypes,
+           Datatype positionType);
+
   /// Returns number of tensor modes belonging to mode pack.
   size_t getNumModes() const;
 
   /// Returns arrays shared by tensor modes.
   ir::Expr getArray(size_t i) const;
 
+  /// Returns the type of positions in the modes, and of their capacities.
+  Datatype getPositionType() const;
+
 private:
   struct Content;
   std::shared_ptr<Content> content;
@@ -0,0 +1,70 @@
+#ifndef TACO_MODE_FORMAT_BITMAP_H
+#define TACO_MODE_FORMAT_BITMAP_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// A bitmap mode stores the coordinates of each parent position as a bitmap
+/// of 64-bit words, and the positions of the mode are the ranks of the set
+/// bits, so values are stored compactly. A rank array with the position of the
+/// first coordinate stored in each word lets locate compute positions in O(1)
+/// with a popcount. Bitmaps take less memory traffic than coordinate arrays for
+/// medium-density tensors, and loops over bitmap operands can merge whole
+/// words at a time.
+class BitmapModeFormat : public ModeFormatImpl {
+public:
+  BitmapModeFormat();
+  BitmapModeFormat(long long allocSize);
+
+  ~BitmapModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction locate(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                      Mode mode) const override;
+
+  ir::Stmt getAppendCoord(ir::Expr pos, ir::Expr coord,
+                          Mode mode) const override;
+  ir::Stmt getAppendEdges(ir::Expr parentPos, ir::Expr posBegin,
+                          ir::Expr posEnd, Mode mode) const override;
+  ir::Expr getSize(ir::Expr parentSize, Mode mode) const override;
+  ir::Stmt getAppendInitEdges(ir::Expr parentPosBegin,
+                              ir::Expr parentPosEnd, Mode mode) const override;
+  ir::Stmt getAppendInitLevel(ir::Expr parentSize, ir::Expr size,
+                              Mode mode) const override;
+  ir::Stmt getAppendFinalizeLevel(ir::Expr parentSize, ir::Expr size,
+                                  Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// Returns the number of words of the bitmap of each parent position.
+  ir::Expr getNumWords(Mode mode) const;
+
+  /// Returns the `word`-th word of the bitmap of a parent position, whose bits
+  /// are set for coordinates 64*word to 64*word+63.
+  ir::Expr getWord(ir::Expr parentPos, ir::Expr word, Mode mode) const;
+
+  /// Returns the position of the first coordinate stored in the `word`-th
+  /// word of the bitmap of a parent position.
+  ir::Expr getRank(ir::Expr parentPos, ir::Expr word, Mode mode) const;
+
+protected:
+  ir::Expr getRankArray(ModePack pack) const;
+  ir::Expr getBitmapArray(ModePack pack) const;
+  ir::Expr getDimension(ModePack pack) const;
+
+  /// Coordinates appended to the mode are buffered until the bitmaps of their
+  /// parent positions are built.
+  ir::Expr getCoordBuffer(Mode mode) const;
+  ir::Expr getCoordBufferCapacity(Mode mode) const;
+
+  bool equals(const ModeFormatImpl& other) const override;
+
+  const long long allocSize;
+};
+
+}
+
+#endif
@@ -33,6 +33,12 @@ public:
   ir::Stmt getAppendFinalizeLevel(ir::Expr parentSize, ir::Expr size, 
                                   Mode mode) const override;
 
+  bool hasParallelAppend(Mode mode) const override;
+  ir::Expr getAppendBegin(ir::Expr parentPos, Mode mode) const override;
+  ir::Stmt getAppendScanLevel(ir::Expr parentSize, Mode mode) const override;
+  ir::Stmt getAppendFillCoord(ir::Expr pos, ir::Expr coord,
+                              Mode mode) const override;
+
   std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode, 
                                   int level) const override;
 
@@ -43,6 +49,10 @@ protected:
   ir::Expr getPosCapacity(Mode mode) const;
   ir::Expr getCoordCapacity(Mode mode) const;
 
+  /// Scans the counts of the parent positions stored in the pos array into
+  /// positions, with the blocks of the pos array scanned in parallel.
+  ir::Stmt scanCountsInParallel(ir::Expr szPrev, Mode mode) const;
+
   bool equals(const ModeFormatImpl& other) const override;
 
   const long long allocSize;
@@ -0,0 +1,61 @@
+#ifndef TACO_MODE_FORMAT_HASHED_H
+#define TACO_MODE_FORMAT_HASHED_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// A hashed mode stores the coordinates of each parent position in an
+/// open-addressing hash table with a fixed number of slots, and the positions
+/// of the mode are the slots of the tables. Empty slots store the coordinate
+/// -1. Hashed modes support O(1) locate and insert, so they can be used as
+/// random-access operands and as sparse results without dense workspaces. The
+/// tables must have more slots than the number of coordinates stored in any of
+/// them.
+class HashedModeFormat : public ModeFormatImpl {
+public:
+  HashedModeFormat();
+  HashedModeFormat(int tableSize);
+  HashedModeFormat(bool isOrdered, bool isUnique, int tableSize);
+
+  ~HashedModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  ModeFunction locate(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                      Mode mode) const override;
+
+  ir::Stmt getInsertCoord(ir::Expr p, const std::vector<ir::Expr>& i,
+                          Mode mode) const override;
+  ir::Expr getWidth(Mode mode) const override;
+  ir::Stmt getInsertInitCoords(ir::Expr pBegin, ir::Expr pEnd,
+                               Mode mode) const override;
+  ir::Stmt getInsertInitLevel(ir::Expr szPrev, ir::Expr sz,
+                              Mode mode) const override;
+  ir::Stmt getInsertFinalizeLevel(ir::Expr szPrev, ir::Expr sz,
+                                  Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// Returns the number of slots of each hash table.
+  int getTableSize() const;
+
+protected:
+  ir::Expr getCoordArray(ModePack pack) const;
+
+  /// Returns the slot of the hash table where the probe for `coord` starts.
+  ir::Expr hash(ir::Expr coord, Datatype type) const;
+
+  bool equals(const ModeFormatImpl& other) const override;
+
+  const int tableSize;
+};
+
+}
+
+#endif
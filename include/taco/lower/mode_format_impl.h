@@ -148,10 +148,30 @@ public:
   getAppendFinalizeLevel(ir::Expr szPrev, ir::Expr sz, Mode mode) const;
   /// @}
 
+  /// Level functions that let the coordinates of different parent positions
+  /// be appended in parallel. A first pass over the parent positions counts
+  /// their coordinates and stores the counts with `getAppendEdges`, then
+  /// `getAppendScanLevel` turns the counts into positions and sizes the level,
+  /// and a second pass appends the coordinates of each parent position from
+  /// `getAppendBegin` on with `getAppendFillCoord`.
+  /// @{
+  virtual bool hasParallelAppend(Mode mode) const;
+
+  virtual ir::Expr getAppendBegin(ir::Expr pPrev, Mode mode) const;
+
+  virtual ir::Stmt getAppendScanLevel(ir::Expr szPrev, Mode mode) const;
+
+  virtual ir::Stmt getAppendFillCoord(ir::Expr p, ir::Expr i, Mode mode) const;
+  /// @}
+
   /// Returns arrays associated with a tensor mode
   virtual std::vector<ir::Expr>
   getArrays(ir::Expr tensor, int mode, int level) const = 0;
 
+  /// Returns true if the size of the mode is a constant in generated code,
+  /// which lets the lowerer unroll loops over the mode.
+  virtual bool hasFixedSize() const;
+
   friend bool operator==(const ModeFormatImpl&, const ModeFormatImpl&);
   friend bool operator!=(const ModeFormatImpl&, const ModeFormatImpl&);
 
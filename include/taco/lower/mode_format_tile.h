@@ -0,0 +1,28 @@
+#ifndef TACO_MODE_FORMAT_TILE_H
+#define TACO_MODE_FORMAT_TILE_H
+
+#include "taco/lower/mode_format_dense.h"
+
+namespace taco {
+
+/// A dense mode whose size is baked into the generated code, for the dense
+/// tiles of block-sparse formats such as BCSR.  Tile modes are stored exactly
+/// like dense modes, but loops over them have constant bounds and are
+/// unrolled, so the C compiler can keep a tile in registers.
+class TileModeFormat : public DenseModeFormat {
+public:
+  TileModeFormat();
+  TileModeFormat(const bool isOrdered, const bool isUnique);
+
+  ~TileModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ir::Expr getWidth(Mode mode) const override;
+
+  bool hasFixedSize() const override;
+};
+
+}
+
+#endif
@@ -16,7 +16,9 @@ public:
   /// The memory reclamation policy of Array objects. UserOwns means the Array
   /// object will not free its data, free means it will reclaim data  with the
   /// C free function and delete means it will reclaim data with delete[].
-  enum Policy {UserOwns, Free, Delete};
+  /// Mmap means the data lies in a memory-mapped file, which the Array object
+  /// does not own but keeps mapped until the last array into it is destroyed.
+  enum Policy {UserOwns, Free, Delete, Mmap};
 
   /// Construct an empty array of undefined elements.
   Array();
@@ -24,12 +26,21 @@ public:
   /// Construct an array of elements of the given type.
   Array(Datatype type, void* data, size_t size, Policy policy=Free);
 
+  /// Construct an array of elements of the given type that lie in a memory
+  /// mapping. The array has the Mmap policy and shares ownership of the
+  /// mapping.
+  Array(Datatype type, void* data, size_t size,
+        std::shared_ptr<void> mapping);
+
   /// Returns the type of the array elements
   const Datatype& getType() const;
 
   /// Returns the number of array elements
   size_t getSize() const;
 
+  /// Returns the memory reclamation policy of the array
+  Policy getPolicy() const;
+
   /// Returns the array data.
   /// @{
   const void* getData() const;
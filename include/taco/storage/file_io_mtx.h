@@ -11,7 +11,9 @@ namespace taco {
 class TensorBase;
 class Format;
 
-/// Read an mtx matrix from a file.
+/// Read an mtx matrix from a file. The file is memory mapped and its lines are
+/// parsed in parallel. Real, integer and pattern fields are supported, and
+/// symmetric and skew-symmetric matrices are expanded to all components.
 TensorBase readMTX(std::string filename, const ModeFormat& modetype, 
                    bool pack=true);
 
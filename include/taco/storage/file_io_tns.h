@@ -11,7 +11,9 @@ namespace taco {
 class TensorBase;
 class Format;
 
-/// Read a tns tensor from a file.
+/// Read a tns tensor from a file. The file is memory mapped and parsed in
+/// blocks, whose lines are parsed in parallel, so files larger than memory can
+/// be read as long as the tensor fits. Lines starting with '#' are comments.
 TensorBase readTNS(std::string filename, const ModeFormat& modetype, 
                    bool pack=true);
 
@@ -0,0 +1,40 @@
+#ifndef TACO_FILE_IO_TTB_H
+#define TACO_FILE_IO_TTB_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "taco/format.h"
+
+namespace taco {
+class TensorBase;
+class Format;
+
+/// Read a ttb tensor from a file. A ttb file is a versioned binary container
+/// that stores the format, the dimensions and the index and value arrays of a
+/// packed tensor as they are laid out in memory. The file is memory mapped and
+/// the arrays of the tensor point into the mapping, so the tensor is loaded
+/// without parsing or packing and its pages are read as kernels touch them.
+/// Writes to the arrays are private to the tensor. The tensor must be read in
+/// the format it was written in, and is always returned packed.
+TensorBase readTTB(std::string filename, const ModeFormat& modetype);
+
+/// Read a ttb tensor from a file.
+TensorBase readTTB(std::string filename, const Format& format);
+
+/// Read a ttb tensor from a stream. The arrays are read into memory.
+TensorBase readTTB(std::istream& stream, const ModeFormat& modetype);
+
+/// Read a ttb tensor from a stream.
+TensorBase readTTB(std::istream& stream, const Format& format);
+
+/// Write a ttb tensor to a file.
+void writeTTB(std::string filename, const TensorBase& tensor);
+
+/// Write a ttb tensor to a stream.
+void writeTTB(std::ostream& stream, const TensorBase& tensor);
+
+}
+
+#endif
@@ -27,6 +27,37 @@ TensorStorage pack(Datatype                             datatype,
                    const std::vector<TypedIndexVector>& coordinates,
                    const void*                          values);
 
+/// Sort the components of a coordinate buffer, where each of the
+/// `numComponents` components consists of `modeOrdering.size()` int
+/// coordinates followed by a `valueSize`-byte value, and split them into one
+/// coordinate array per storage mode and a value array. Components are sorted
+/// lexicographically by their coordinates permuted into the storage order given
+/// by `modeOrdering`, and components with equal coordinates keep their
+/// relative order. The sort is a radix sort that runs on all OpenMP threads.
+void sortCoordinates(const char* components, size_t numComponents,
+                     const std::vector<int>& modeOrdering, size_t valueSize,
+                     const std::vector<int*>& coordinates, char* values);
+
+/// Sort and split components like above, where the components are given as
+/// one coordinate array per mode and an array of values. Components that are
+/// known to be sorted by the last `numSortedModes` modes of `modeOrdering` are
+/// only sorted by the other modes, since the sort is stable.
+void sortCoordinates(const std::vector<const int*>& componentCoordinates,
+                     const char* componentValues, size_t numComponents,
+                     const std::vector<int>& modeOrdering, size_t valueSize,
+                     const std::vector<int*>& coordinates, char* values,
+                     size_t numSortedModes=0);
+
+/// Copy the components given as one coordinate array per mode and an array of
+/// values of type `type` into `coordinates` and `values`, without the
+/// components whose values are zero, and return the number of components
+/// copied. The components keep their order, and are copied on all OpenMP
+/// threads.
+size_t removeZeroComponents(
+    const std::vector<const int*>& componentCoordinates,
+    const char* componentValues, size_t numComponents, Datatype type,
+    const std::vector<int*>& coordinates, char* values);
+
 
 template<typename V, size_t O, typename C>
 TensorStorage pack(std::vector<int> dimensions, Format format,
@@ -18,6 +18,13 @@ struct Target {
   std::string compiler_env = "TACO_CC";
 
   std::string compiler = "cc";
+
+  /// Backend used to compile generated C code at runtime. `External` runs the
+  /// compiler given by `compiler_env` or `compiler` in a separate process and
+  /// loads the resulting shared library. `LibTCC` compiles in-process with
+  /// libtcc if it can be loaded, falling back to `External` for code libtcc
+  /// cannot compile.
+  enum JIT {External=0, LibTCC} jit = External;
   
   // As we support them, we'll stick in optional features into the target as
   // well, including things like parallelism model (e.g. openmp, cilk) for
@@ -38,7 +45,8 @@ struct Target {
 };
 
   /// Gets the target from the environment.  If this is not set in the
-  /// environment, it uses the default C99 backend with the current OS
+  /// environment, it uses the default C99 backend with the current OS.  The
+  /// in-process libtcc backend is selected by setting TACO_JIT=tcc.
   Target getTargetFromEnvironment();
 
 } // namespace taco
@@ -1,6 +1,7 @@
 #ifndef TACO_TENSOR_H
 #define TACO_TENSOR_H
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -8,6 +9,7 @@
 #include <utility>
 #include <array>
 #include <mutex>
+#include <future>
 
 #include "taco/type.h"
 #include "taco/format.h"
@@ -39,6 +41,21 @@ struct AccessTensorNode;
 template <typename CType>
 struct ScalarAccess;
 
+/// How the kernels that compute a tensor's expression are executed.
+enum class ExecutionMode {
+  /// Generate C code, compile it, and run the compiled code (the default).
+  Compiled,
+
+  /// Interpret the lowered kernels. Interpreted kernels start immediately but
+  /// run orders of magnitude slower than compiled kernels.
+  Interpreted,
+
+  /// Interpret the kernels if the operands and result have at most
+  /// TACO_INTERPRET_THRESHOLD components in total (10000 by default) when they
+  /// are first assembled or computed, and compile them otherwise.
+  Auto
+};
+
 /// TensorBase is the super-class for all tensors. You can use it directly to
 /// avoid templates, or you can use the templated `Tensor<T>` that inherits from
 /// `TensorBase`.
@@ -134,6 +151,15 @@ public:
   template <typename CType>
   void insert(const std::vector<int>& coordinate, CType value);
 
+  /// Insert many values into the tensor at once. The components are given as
+  /// one Int32 coordinate array per mode and an array of values of the
+  /// component type, which must all have the same size. The components do not
+  /// have to be sorted, and duplicates are summed when the tensor is packed.
+  /// Arrays with the `UserOwns` policy are copied, while the tensor takes
+  /// ownership of arrays with other policies until it is packed.
+  void insertComponents(const std::vector<Array>& coordinates,
+                        const Array& values);
+
   /// Fill the tensor with the list of components defined by the iterator range (begin, end).
   ///
   /// The input list of triplets does not have to be sorted, and can contains duplicated elements.
@@ -149,9 +175,20 @@ public:
 
   /* --- Read Methods        --- */
 
+  /// Returns the component at the coordinate, or zero if it is not stored.
+  /// The component is found by descending the levels of the tensor's format:
+  /// dense levels are indexed, compressed and singleton levels are binary
+  /// searched, and hashed and bitmap levels are located into.
   template <typename CType>  
   CType at(const std::vector<int>& coordinate);
 
+  /// Returns the components at the coordinates. The coordinates are looked up
+  /// in sorted order, so lookups reuse the positions of the levels where their
+  /// coordinates agree with the previous lookup, and binary searches resume
+  /// from the previous lookup's position.
+  template <typename CType>
+  std::vector<CType> at(const std::vector<std::vector<int>>& coordinates);
+
   template<typename T, typename CType>
   class const_iterator {
   public:
@@ -413,6 +450,18 @@ public:
 
   void compile(IndexStmt stmt, bool assembleWhileCompute=false);
 
+  /// Compile the tensor expression in a background thread. Until the compiled
+  /// kernels are ready, assemble and compute interpret the lowered kernels
+  /// instead of waiting for the C compiler, and the compiled kernels are
+  /// swapped in for the first call after they become ready. The returned
+  /// future becomes ready when compilation finishes. If the kernels fail to
+  /// compile, its `get` throws a TacoException, and the next assemble or
+  /// compute reports the error like `compile` does.
+  std::shared_future<std::shared_ptr<ir::Module>> compileAsync();
+
+  std::shared_future<std::shared_ptr<ir::Module>>
+  compileAsync(IndexStmt stmt, bool assembleWhileCompute=false);
+
   /// Assemble the tensor storage, including index and value arrays.
   void assemble();
 
@@ -437,6 +486,14 @@ public:
   /// Set to true to perform the assemble and compute stages simultaneously.
   void setAssembleWhileCompute(bool assembleWhileCompute);
 
+  /// Set how the kernels are executed. Takes effect when the tensor's
+  /// expression is next compiled. Kernels that the interpreter does not
+  /// support, and kernels compiled with `compileAsync`, are always compiled.
+  void setExecutionMode(ExecutionMode mode);
+
+  /// Get how the kernels are executed.
+  ExecutionMode getExecutionMode() const;
+
   /// Get the source code of the kernel functions.
   std::string getSource() const;
 
@@ -484,6 +541,19 @@ public:
   friend std::ostream& operator<<(std::ostream&, const TensorBase&);
   friend std::ostream& operator<<(std::ostream&, TensorBase&);
 
+  /// Compile the expressions of several tensors into one module.
+  friend void compile(std::vector<TensorBase> tensors);
+
+  /// Convert a tensor to another format.
+  friend TensorBase convert(const TensorBase& tensor,
+                            const std::vector<int>& modeOrdering,
+                            const Format& format);
+
+  /// Copy a tensor into a format without its explicit zeros.
+  friend TensorBase removeExplicitZeros(const TensorBase& tensor,
+                                        const Format& format);
+
+  friend class PreparedKernel;
   friend struct AccessTensorNode;
   std::vector<TensorBase> getDependentTensors();
 private:
@@ -494,6 +564,14 @@ private:
                                  const std::shared_ptr<ir::Module> kernel);
 
   /* --- Compiler Methods --- */
+  void compile(IndexStmt stmt, bool assembleWhileCompute, bool inBackground);
+  bool lowerKernels(IndexStmt stmt, bool assembleWhileCompute,
+                    std::shared_ptr<ir::Module> module,
+                    const std::string& suffix, bool useCache=true);
+  void finishCompile();
+  void selectKernelExecution();
+  void callKernel(const std::string& name, void** arguments);
+
   bool neverPacked();
 
   void unsetNeverPacked();
@@ -508,6 +586,19 @@ private:
 
   void syncValues();
 
+  /// True if the levels of the tensor's format can be searched for the
+  /// positions of components.
+  bool hasSearchableFormat() const;
+
+  /// Returns the position of the component at the coordinate in the values
+  /// array, or -1 if it is not stored.
+  ptrdiff_t findValue(const std::vector<int>& coordinate) const;
+
+  /// Returns the positions of the components at the coordinates in the values
+  /// array, or -1 for those that are not stored.
+  std::vector<ptrdiff_t>
+  findValues(const std::vector<std::vector<int>>& coordinates) const;
+
   template<typename CType>
   iterator_wrapper<int,CType> iteratorPacked();
   
@@ -524,6 +615,11 @@ private:
   template <typename CType>
   void reinsertPackedComponents();
 
+  /// Pack components that are sorted in the storage order of the tensor, given
+  /// as one coordinate array per level and an array of values.
+  void packSortedComponents(const std::vector<int*>& coordinates,
+                            const char* values, size_t numComponents);
+
   struct Content;
   std::shared_ptr<Content> content;
 
@@ -533,11 +629,6 @@ private:
                                  std::shared_ptr<ir::Module>>> HelperFuncsCache;
   static HelperFuncsCache helperFunctions;
   static std::mutex helperFunctionsMutex;
-
-  typedef std::vector<std::pair<IndexStmt, 
-                                std::shared_ptr<ir::Module>>> KernelsCache;
-  static KernelsCache computeKernels;
-  static std::mutex computeKernelsMutex;
 };
 
 /// A reference to a tensor. Tensor object copies copies the reference, and
@@ -580,6 +671,8 @@ public:
 
   CType at(const std::vector<int>& coordinate);
 
+  std::vector<CType> at(const std::vector<std::vector<int>>& coordinates);
+
   /// Simple transpose that packs a new tensor from the values in the current tensor.
   Tensor<CType> transpose(std::string name, std::vector<int> newModeOrdering) const;
   Tensor<CType> transpose(std::vector<int> newModeOrdering) const;
@@ -656,6 +749,75 @@ struct ScalarAccess {
 // Utility functions
 // ------------------------------------------------------------
 
+/// Compile the expressions of several tensors into a single module, with one
+/// invocation of the C compiler and one shared library. Each tensor's kernels
+/// get unique names within the module. Compiling a pipeline of expressions
+/// this way is much faster than compiling each tensor on its own.
+void compile(std::vector<TensorBase> tensors);
+
+/// Convert a tensor to another format. Conversions that keep the order in
+/// which the modes are stored run a compiled copy kernel. Other conversions,
+/// such as CSR to CSC, extract the components with a compiled kernel, sort
+/// them by the new mode ordering with a parallel radix sort that only sorts on
+/// the modes whose order changes (a histogram, prefix sum and scatter per
+/// digit), and pack them with the format's compiled pack kernel.
+TensorBase convert(const TensorBase& tensor, const Format& format);
+
+/// Convert a tensor to another format and permute its modes, so that mode `m`
+/// of the result is mode `modeOrdering[m]` of the tensor.
+TensorBase convert(const TensorBase& tensor,
+                   const std::vector<int>& modeOrdering, const Format& format);
+
+/// Copy a tensor into a format without the components whose values are zero.
+/// The components are extracted and packed with compiled kernels like in
+/// `convert`, and the zeros are dropped in parallel in between.
+TensorBase removeExplicitZeros(const TensorBase& tensor, const Format& format);
+
+/// The compiled kernels of a tensor's expression, prepared to be called
+/// repeatedly with little overhead. The kernel functions and the layout of
+/// their arguments are resolved once, so `assemble` and `compute` directly call
+/// the compiled functions. Unlike the methods of `TensorBase`, they do not
+/// check or synchronize the operands, which are only packed or computed when
+/// they are bound. Operands that are modified afterwards must be bound again.
+class PreparedKernel {
+public:
+  /// Prepare the kernels of the expression assigned to `result`, compiling
+  /// them if needed. Kernels are always compiled, even if `result` is set to
+  /// interpret them.
+  explicit PreparedKernel(TensorBase result);
+
+  /// Bind `tensor` to the result or to an operand of the expression, in place
+  /// of the tensor it is currently bound to. The tensor must have the same
+  /// format, component type and dimensions as the tensor variable.
+  void bind(const TensorVar& tensorVar, const TensorBase& tensor);
+
+  /// Get the tensor that is bound to the result or to an operand.
+  TensorBase getTensor(const TensorVar& tensorVar) const;
+
+  /// Assemble the index and value arrays of the result.
+  void assemble();
+
+  /// Compute the result's values.
+  void compute();
+
+private:
+  size_t getArgumentIndex(const TensorVar& tensorVar) const;
+  void call(void* kernel);
+  void unpackResult();
+
+  /// The tensor variables and tensors of the result and the operands, in the
+  /// order the kernels take them as arguments.
+  std::vector<TensorVar>  tensorVars;
+  std::vector<TensorBase> tensors;
+  std::vector<void*>      arguments;
+
+  std::shared_ptr<ir::Module> module;
+  void* assembleFunc;
+  void* computeFunc;
+  bool  assembleWhileCompute;
+  bool  parallel;
+};
+
 /// The file formats supported by the taco file readers and writers.
 enum class FileType {
   /// .tns - The frostt sparse tensor format.  It consists of zero or more
@@ -676,7 +838,12 @@ enum class FileType {
   ttx,
 
   /// .rb  - The rutherford-boeing sparse matrix format.
-  rb
+  rb,
+
+  /// .ttb - The taco binary tensor format. It stores the format, dimensions
+  ///        and arrays of a packed tensor as they are laid out in memory, and
+  ///        is read by memory mapping the arrays without parsing or packing.
+  ttb
 };
 
 /// Read a tensor from a file. The file format is inferred from the filename
@@ -767,6 +934,17 @@ void getCSRArrays(const TensorBase& tensor,
   *vals   = static_cast<T*>(storage.getValues().getData());
 }
 
+/// Factory function to construct a sliced ELLPACK (SELL-C-σ) tensor from a CSR
+/// matrix. The rows of the matrix are sorted by decreasing number of nonzeros
+/// within windows of `sigma` rows, which reduces padding, and grouped into
+/// slices of `chunkSize` rows. If `rows` is not null, it is set to the row of
+/// the matrix stored in each lane: lane r of slice s stores row
+/// `(*rows)[s*chunkSize + r]`, or padding if that is not less than the number
+/// of rows. Multiplying the result by a vector, y(s,r) = S(s,k,r,j) * x(j),
+/// therefore computes the rows of the matrix-vector product in that order.
+TensorBase makeSELL(const std::string& name, const TensorBase& matrix,
+                    int chunkSize, int sigma, std::vector<int>* rows = nullptr);
+
 /// Factory function to construct a compressed sparse columns (CSC) matrix. The
 /// arrays remain owned by the user and will not be freed by taco.
 template<typename T>
@@ -854,10 +1032,29 @@ struct TensorBase::Content {
   bool               assembleWhileCompute;
   std::shared_ptr<ir::Module> module;
 
+  /// Names of the kernels in `module`, which are unique within modules that
+  /// hold the kernels of several tensors.
+  std::string        assembleFuncName;
+  std::string        computeFuncName;
+
+  /// The statement the kernels were lowered from, which keys the kernel cache.
+  IndexStmt          kernelStmt;
+
+  /// The requested execution mode, and the mode of the current kernels
+  /// (`Auto` until it is decided at their first call).
+  ExecutionMode      executionMode;
+  ExecutionMode      kernelExecution;
+
+  /// Set while `module` is compiled in the background.
+  std::shared_future<std::shared_ptr<ir::Module>> pendingModule;
+
   size_t             coordinateBufferUsed;
   size_t             coordinateSize;
   std::shared_ptr<std::vector<char>> coordinateBuffer;
 
+  /// Components inserted in bulk, as coordinate arrays and a value array.
+  std::vector<std::pair<std::vector<Array>, Array>> componentArrays;
+
   bool               neverPacked;
   bool               needsPack;
   bool               needsCompile;
@@ -984,6 +1181,12 @@ CType TensorBase::at(const std::vector<int>& coordinate) {
     "from a tensor with component type " << getComponentType();
   syncValues();
 
+  if (hasSearchableFormat()) {
+    ptrdiff_t position = findValue(coordinate);
+    return (position < 0) ? 0 : static_cast<const CType*>(
+        getStorage().getValues().getData())[position];
+  }
+
   for (auto& value : iterate<CType>(*this)) {
     if (value.first.toVector() == coordinate) {
       return value.second;
@@ -992,6 +1195,44 @@ CType TensorBase::at(const std::vector<int>& coordinate) {
   return 0;
 }
 
+template <typename CType>
+std::vector<CType>
+TensorBase::at(const std::vector<std::vector<int>>& coordinates) {
+  taco_uassert(getComponentType() == type<CType>()) <<
+    "Cannot get a value of type '" << type<CType>() << "' " <<
+    "from a tensor with component type " << getComponentType();
+  syncValues();
+
+  std::vector<CType> values(coordinates.size(), 0);
+  if (hasSearchableFormat()) {
+    const std::vector<ptrdiff_t> positions = findValues(coordinates);
+    const CType* vals =
+        static_cast<const CType*>(getStorage().getValues().getData());
+    for (size_t i = 0; i < coordinates.size(); i++) {
+      if (positions[i] >= 0) {
+        values[i] = vals[positions[i]];
+      }
+    }
+    return values;
+  }
+
+  std::map<std::vector<int>, std::vector<size_t>> queries;
+  for (size_t i = 0; i < coordinates.size(); i++) {
+    taco_uassert(coordinates[i].size() == (size_t)getOrder()) <<
+      "Wrong number of indices";
+    queries[coordinates[i]].push_back(i);
+  }
+  for (auto& value : iterate<CType>(*this)) {
+    auto query = queries.find(value.first.toVector());
+    if (query != queries.end()) {
+      for (size_t i : query->second) {
+        values[i] = value.second;
+      }
+    }
+  }
+  return values;
+}
+
 template<typename CType>
 TensorBase::iterator_wrapper<int,CType> TensorBase::iterator() const {
   return TensorBase::iterator_wrapper<int,CType>(this);
@@ -1059,6 +1300,12 @@ CType Tensor<CType>::at(const std::vector<int>& coordinate) {
   return TensorBase::at<CType>(coordinate);
 }
 
+template <typename CType>
+std::vector<CType>
+Tensor<CType>::at(const std::vector<std::vector<int>>& coordinates) {
+  return TensorBase::at<CType>(coordinates);
+}
+
 template <typename CType>
 Access Tensor<CType>::operator()() {
   return TensorBase::operator()();
@@ -1113,34 +1360,14 @@ Tensor<CType> Tensor<CType>::transpose(std::vector<int> newModeOrdering, Format
 
 template <typename CType>
 Tensor<CType> Tensor<CType>::transpose(std::string name, std::vector<int> newModeOrdering, Format format) const {
-  // Reorder dimensions to match new mode ordering
-  std::vector<int> newDimensions;
-  for (int mode : newModeOrdering) {
-    newDimensions.push_back(getDimensions()[mode]);
-  }
-
-  Tensor<CType> newTensor(name, newDimensions, format);
-  for (auto& value : *this) {
-    std::vector<int> newCoordinate;
-    for (int mode : newModeOrdering) {
-      newCoordinate.push_back(value.first[mode]);
-    }
-    newTensor.insert(newCoordinate, value.second);
-  }
-  newTensor.pack();
+  Tensor<CType> newTensor = convert(*this, newModeOrdering, format);
+  newTensor.setName(name);
   return newTensor;
 }
 
 template <typename CType>
 Tensor<CType> Tensor<CType>::removeExplicitZeros(Format format) const {
-  Tensor<CType> newTensor(getDimensions(), format);
-  for (const auto& elem : *this) {
-    if (elem.second != static_cast<CType>(0)) {
-      newTensor.insertUnchecked<int,CType>(elem.first, elem.second);
-    }
-  }
-  newTensor.pack();
-  return newTensor;
+  return taco::removeExplicitZeros(*this, format);
 }
 
 template <typename CType>
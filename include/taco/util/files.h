@@ -4,6 +4,8 @@
 #include <string>
 #include <fstream>
 
+#include "taco/util/uncopyable.h"
+
 namespace taco {
 namespace util {
 
@@ -11,5 +13,37 @@ std::string sanitizePath(std::string path);
 
 void openStream(std::fstream& stream, std::string path, std::fstream::openmode mode);
 
+/// A read-only memory mapping of a window of a file. Files are mapped one
+/// window at a time, so files larger than the address space or the physical
+/// memory can be read in chunks.
+class MappedFile : Uncopyable {
+public:
+  /// Open the file at `path`.
+  explicit MappedFile(std::string path);
+  ~MappedFile();
+
+  /// Returns the size of the file in bytes.
+  size_t getSize() const;
+
+  /// Map the `size` bytes of the file starting at `offset`, and return a
+  /// pointer to them. The previously mapped window is unmapped.
+  const char* map(size_t offset, size_t size);
+
+  /// Map the bytes like `map`, but the window may be written to. Writes are
+  /// private to the process and are not carried through to the file.
+  char* mapPrivate(size_t offset, size_t size);
+
+  /// Unmap the mapped window.
+  void unmap();
+
+private:
+  char* mapWindow(size_t offset, size_t size, int protection);
+
+  int fd;
+  size_t size;
+  void* window;
+  size_t windowSize;
+};
+
 }}
 #endif
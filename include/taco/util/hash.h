@@ -0,0 +1,43 @@
+#ifndef TACO_UTIL_HASH_H
+#define TACO_UTIL_HASH_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace taco {
+namespace util {
+
+/// 64-bit FNV-1a hash of a byte range. Unlike std::hash the result is stable
+/// across processes and builds, so it can be used to name files on disk.
+inline uint64_t fnv1a(const void* data, size_t size,
+                      uint64_t seed=0xcbf29ce484222325ULL) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  uint64_t hash = seed;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/// 64-bit FNV-1a hash of a string.
+inline uint64_t fnv1a(const std::string& str,
+                      uint64_t seed=0xcbf29ce484222325ULL) {
+  return fnv1a(str.data(), str.size(), seed);
+}
+
+/// Fibonacci hash of a coordinate: the top `32 - shift` bits of the
+/// coordinate times 2^32/phi, which is a slot of a table with 2^(32 - shift)
+/// slots. Generated code computes the same hash with the TACO_HASH macro.
+inline int32_t fibonacciHash(int32_t coord, int shift) {
+  return (int32_t)(((uint32_t)coord * 2654435769u) >> shift);
+}
+
+/// Mix `value` into the running hash `seed`.
+inline void hashCombine(size_t& seed, size_t value) {
+  seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+}}
+#endif
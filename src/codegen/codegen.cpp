@@ -194,6 +194,12 @@ string CodeGen::printContextDeclAndInit(map<Expr, string, ExprCompare> varMap,
   return ret.str();
 }
 
+string CodeGen::printIndexArrayType(Datatype type) {
+  // 32-bit index arrays are declared as int arrays, like the helper functions
+  // in the C header that take them
+  return (type == Int32) ? "int*" : printType(type, true);
+}
+
 string CodeGen::printTensorProperty(string varname, const GetProperty* op, bool is_ptr) {
   stringstream ret;
   string star = is_ptr ? "*" : "";
@@ -222,7 +228,7 @@ string CodeGen::printTensorProperty(string varname, const GetProperty* op, bool
     ret << tp << " " << varname;
   } else {
     taco_iassert(op->property == TensorProperty::Indices);
-    tp = "int*" + star;
+    tp = printIndexArrayType(op->type) + star;
     ret << tp << " " << varname;
   }
 
@@ -257,10 +263,10 @@ string CodeGen::unpackTensorProperty(string varname, const GetProperty* op,
         << "->dimensions[" << op->mode << "]);\n";
   } else {
     taco_iassert(op->property == TensorProperty::Indices);
-    tp = "int*";
+    tp = printIndexArrayType(op->type);
     auto nm = op->index;
     ret << tp << " " << restrictKeyword() << " " << varname << " = ";
-    ret << "(int*)(" << tensor->name << "->indices[" << op->mode;
+    ret << "(" << tp << ")(" << tensor->name << "->indices[" << op->mode;
     ret << "][" << nm << "]);\n";
   }
 
@@ -423,8 +429,6 @@ string CodeGen::printPack(map<tuple<Expr, TensorProperty, int, int>,
 
 // seed the unique names with all C99 keywords
 // from: http://en.cppreference.com/w/c/keyword
-map<string, int> uniqueNameCounters;
-
 void CodeGen::resetUniqueNameCounters() {
   uniqueNameCounters =
           {{"auto", 0},
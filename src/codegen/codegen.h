@@ -1,6 +1,7 @@
 #ifndef TACO_CODEGEN_H
 #define TACO_CODEGEN_H
 
+#include <map>
 #include <memory>
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_printer.h"
@@ -59,8 +60,12 @@ protected:
   CodeGenType codeGenType;
 
 private:
+  // Per code generator, so that kernels can be generated on several threads
+  std::map<std::string, int> uniqueNameCounters;
+
   virtual std::string restrictKeyword() const { return ""; }
 
+  std::string printIndexArrayType(Datatype type);
   std::string printTensorProperty(std::string varname, const GetProperty* op, bool is_ptr);
   std::string unpackTensorProperty(std::string varname, const GetProperty* op,
                               bool is_output_prop);
@@ -32,11 +32,37 @@ const string cHeaders =
   "#include <stdint.h>\n"
   "#include <stdbool.h>\n"
   "#include <math.h>\n"
+  "#ifndef __TINYC__\n"
   "#include <complex.h>\n"
+  "#endif\n"
   "#include <string.h>\n"
   "#define TACO_MIN(_a,_b) ((_a) < (_b) ? (_a) : (_b))\n"
   "#define TACO_MAX(_a,_b) ((_a) > (_b) ? (_a) : (_b))\n"
   "#define TACO_DEREF(_a) (((___context___*)(*__ctx__))->_a)\n"
+  "#if defined(__GNUC__) && !defined(__TINYC__)\n"
+  "#define TACO_POPCOUNT(_a) __builtin_popcountll(_a)\n"
+  "#define TACO_CTZ(_a) __builtin_ctzll(_a)\n"
+  "#else\n"
+  "static inline int taco_popcount(unsigned long long a) {\n"
+  "  a = a - ((a >> 1) & 0x5555555555555555ULL);\n"
+  "  a = (a & 0x3333333333333333ULL) + ((a >> 2) & 0x3333333333333333ULL);\n"
+  "  a = (a + (a >> 4)) & 0x0f0f0f0f0f0f0f0fULL;\n"
+  "  return (int)((a * 0x0101010101010101ULL) >> 56);\n"
+  "}\n"
+  "#define TACO_POPCOUNT(_a) taco_popcount(_a)\n"
+  "#define TACO_CTZ(_a) taco_popcount(((_a) & -(_a)) - 1)\n"
+  "#endif\n"
+  "#define TACO_BITMASK(_b) (1ULL << (_b))\n"
+  "#define TACO_BIT(_a,_b) ((int)(((_a) >> (_b)) & 1))\n"
+  "#define TACO_RANK(_a,_b) TACO_POPCOUNT((_a) & (TACO_BITMASK(_b) - 1))\n"
+  "#ifdef _OPENMP\n"
+  "#include <omp.h>\n"
+  "#define TACO_NUM_THREADS() omp_get_max_threads()\n"
+  "#define TACO_THREAD_ID() omp_get_thread_num()\n"
+  "#else\n"
+  "#define TACO_NUM_THREADS() 1\n"
+  "#define TACO_THREAD_ID() 0\n"
+  "#endif\n"
   "#ifndef TACO_TENSOR_T_DEFINED\n"
   "#define TACO_TENSOR_T_DEFINED\n"
   "typedef enum { taco_mode_dense, taco_mode_sparse } taco_mode_t;\n"
@@ -54,48 +80,103 @@ const string cHeaders =
   "int cmp(const void *a, const void *b) {\n"
   "  return *((const int*)a) - *((const int*)b);\n"
   "}\n"
-  "int taco_binarySearchAfter(int *array, int arrayStart, int arrayEnd, int target) {\n"
-  "  if (array[arrayStart] >= target) {\n"
-  "    return arrayStart;\n"
-  "  }\n"
-  "  int lowerBound = arrayStart; // always < target\n"
-  "  int upperBound = arrayEnd; // always >= target\n"
-  "  while (upperBound - lowerBound > 1) {\n"
-  "    int mid = (upperBound + lowerBound) / 2;\n"
-  "    int midValue = array[mid];\n"
-  "    if (midValue < target) {\n"
-  "      lowerBound = mid;\n"
-  "    }\n"
-  "    else if (midValue > target) {\n"
-  "      upperBound = mid;\n"
-  "    }\n"
-  "    else {\n"
-  "      return mid;\n"
+  "#define TACO_HASH(_c,_s) ((int32_t)(((uint32_t)(_c) * 2654435769u) >> (_s)))\n"
+  "int taco_hashLookup(int32_t *keys, int32_t capacity, int32_t shift, int32_t c) {\n"
+  "  int32_t h = TACO_HASH(c, shift);\n"
+  "  while (keys[h] != c) {\n"
+  "    if (keys[h] < 0) {\n"
+  "      return capacity;\n"
   "    }\n"
+  "    h = (h + 1) & (capacity - 1);\n"
   "  }\n"
-  "  return upperBound;\n"
+  "  return h;\n"
   "}\n"
-  "int taco_binarySearchBefore(int *array, int arrayStart, int arrayEnd, int target) {\n"
-  "  if (array[arrayEnd] <= target) {\n"
-  "    return arrayEnd;\n"
+  "int taco_sortCoordinates(int *coords, int size) {\n"
+  "  if (size > 32) {\n"
+  "    qsort(coords, size, sizeof(int), cmp);\n"
+  "    return size;\n"
   "  }\n"
-  "  int lowerBound = arrayStart; // always <= target\n"
-  "  int upperBound = arrayEnd; // always > target\n"
-  "  while (upperBound - lowerBound > 1) {\n"
-  "    int mid = (upperBound + lowerBound) / 2;\n"
-  "    int midValue = array[mid];\n"
-  "    if (midValue < target) {\n"
-  "      lowerBound = mid;\n"
-  "    }\n"
-  "    else if (midValue > target) {\n"
-  "      upperBound = mid;\n"
-  "    }\n"
-  "    else {\n"
-  "      return mid;\n"
+  "  for (int i = 1; i < size; i++) {\n"
+  "    int c = coords[i];\n"
+  "    int j = i;\n"
+  "    for (; j > 0 && coords[j - 1] > c; j--) {\n"
+  "      coords[j] = coords[j - 1];\n"
   "    }\n"
+  "    coords[j] = c;\n"
   "  }\n"
-  "  return lowerBound;\n"
+  "  return size;\n"
   "}\n"
+  "#ifndef __TINYC__\n"
+  "#define TACO_PRAGMA(_p) _Pragma(#_p)\n"
+  "#else\n"
+  "#define TACO_PRAGMA(_p)\n"
+  "#endif\n"
+  "#ifndef TACO_INTERSECT_WIDTH\n"
+  "#define TACO_INTERSECT_WIDTH 8\n"
+  "#endif\n"
+  "#define TACO_DEFINE_SEARCHES(_suffix, _type) \\\n"
+  "int64_t taco_binarySearchAfter##_suffix(_type *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayStart] >= target) { \\\n"
+  "    return arrayStart; \\\n"
+  "  } \\\n"
+  "  int64_t lowerBound = arrayStart; /* always < target */ \\\n"
+  "  int64_t upperBound = arrayEnd; /* always >= target */ \\\n"
+  "  while (upperBound - lowerBound > 1) { \\\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2; \\\n"
+  "    int64_t midValue = array[mid]; \\\n"
+  "    if (midValue < target) { \\\n"
+  "      lowerBound = mid; \\\n"
+  "    } \\\n"
+  "    else if (midValue > target) { \\\n"
+  "      upperBound = mid; \\\n"
+  "    } \\\n"
+  "    else { \\\n"
+  "      return mid; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return upperBound; \\\n"
+  "} \\\n"
+  "int64_t taco_binarySearchBefore##_suffix(_type *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayEnd] <= target) { \\\n"
+  "    return arrayEnd; \\\n"
+  "  } \\\n"
+  "  int64_t lowerBound = arrayStart; /* always <= target */ \\\n"
+  "  int64_t upperBound = arrayEnd; /* always > target */ \\\n"
+  "  while (upperBound - lowerBound > 1) { \\\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2; \\\n"
+  "    int64_t midValue = array[mid]; \\\n"
+  "    if (midValue < target) { \\\n"
+  "      lowerBound = mid; \\\n"
+  "    } \\\n"
+  "    else if (midValue > target) { \\\n"
+  "      upperBound = mid; \\\n"
+  "    } \\\n"
+  "    else { \\\n"
+  "      return mid; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return lowerBound; \\\n"
+  "} \\\n"
+  "int64_t taco_intersectAdvance##_suffix(_type *crd, int64_t pos, int64_t end, int64_t target) { \\\n"
+  "  for (; pos + TACO_INTERSECT_WIDTH <= end; pos += TACO_INTERSECT_WIDTH) { \\\n"
+  "    int smaller = 0; \\\n"
+  "    TACO_PRAGMA(omp simd reduction(+:smaller)) \\\n"
+  "    for (int k = 0; k < TACO_INTERSECT_WIDTH; k++) { \\\n"
+  "      smaller += crd[pos + k] < target; \\\n"
+  "    } \\\n"
+  "    if (smaller < TACO_INTERSECT_WIDTH) { \\\n"
+  "      return pos + smaller; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  while (pos < end && crd[pos] < target) { \\\n"
+  "    pos++; \\\n"
+  "  } \\\n"
+  "  return pos; \\\n"
+  "}\n"
+  "TACO_DEFINE_SEARCHES(, int)\n"
+  "TACO_DEFINE_SEARCHES(_uint8, uint8_t)\n"
+  "TACO_DEFINE_SEARCHES(_uint16, uint16_t)\n"
+  "TACO_DEFINE_SEARCHES(_int64, int64_t)\n"
   "taco_tensor_t* init_taco_tensor_t(int32_t order, int32_t csize,\n"
   "                                  int32_t* dimensions, int32_t* mode_ordering,\n"
   "                                  taco_mode_t* mode_types) {\n"
@@ -359,6 +440,159 @@ static string genVectorizePragma(int width) {
   return ret.str();
 }
 
+/// Finds whether the iterations of a vectorized loop are independent of each
+/// other, apart from scalars that they add to, so that the loop can be
+/// vectorized with `#pragma omp simd` and a reduction clause for the scalars.
+/// Iterations are dependent if they use atomics or allocate memory, store to
+/// locations other than the loop variable plus a loop-invariant offset, read
+/// arrays they store to at other locations than they store to, or update or
+/// read scalars declared outside the loop in other ways.
+struct FindSimdReductions : IRVisitor {
+  set<Expr> localVars;
+  set<Expr> dependentVars;
+  set<Expr> offsetVars;
+  set<Expr> outerReads;
+  map<Expr,vector<Expr>> stores;
+  vector<pair<Expr,Expr>> loads;
+  vector<Expr> reductions;
+  bool independent = true;
+
+  using IRVisitor::visit;
+
+  bool dependsOnLoop(Expr expr) {
+    struct FindDependentVars : IRVisitor {
+      const set<Expr>& dependentVars;
+      bool depends = false;
+
+      using IRVisitor::visit;
+
+      FindDependentVars(const set<Expr>& dependentVars)
+          : dependentVars(dependentVars) {}
+
+      void visit(const Var* op) {
+        depends = depends || util::contains(dependentVars, Expr(op));
+      }
+    };
+    FindDependentVars findDependentVars(dependentVars);
+    expr.accept(&findDependentVars);
+    return findDependentVars.depends;
+  }
+
+  /// Whether `expr` is the loop variable plus a loop-invariant offset.
+  bool isLoopOffset(Expr expr) {
+    if (util::contains(offsetVars, expr)) {
+      return true;
+    }
+    if (const Add* add = expr.as<Add>()) {
+      return (isLoopOffset(add->a) && !dependsOnLoop(add->b)) ||
+             (isLoopOffset(add->b) && !dependsOnLoop(add->a));
+    }
+    if (const Sub* sub = expr.as<Sub>()) {
+      return isLoopOffset(sub->a) && !dependsOnLoop(sub->b);
+    }
+    return false;
+  }
+
+  void visit(const Var* op) {
+    if (!util::contains(localVars, Expr(op))) {
+      outerReads.insert(op);
+    }
+  }
+
+  void visit(const VarDecl* op) {
+    op->rhs.accept(this);
+    localVars.insert(op->var);
+    if (dependsOnLoop(op->rhs)) {
+      dependentVars.insert(op->var);
+    }
+    if (isLoopOffset(op->rhs)) {
+      offsetVars.insert(op->var);
+    }
+  }
+
+  void visit(const For* op) {
+    op->start.accept(this);
+    op->end.accept(this);
+    op->increment.accept(this);
+    // Inner loop variables vary within each iteration, so locations offset by
+    // them may overlap those of other iterations
+    localVars.insert(op->var);
+    dependentVars.insert(op->var);
+    op->contents.accept(this);
+  }
+
+  void visit(const Allocate* op) {
+    independent = false;
+  }
+
+  void visit(const Load* op) {
+    loads.push_back({op->arr, op->loc});
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Store* op) {
+    if (op->use_atomics || !isLoopOffset(op->loc)) {
+      independent = false;
+    }
+    stores[op->arr].push_back(op->loc);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Assign* op) {
+    if (op->use_atomics) {
+      independent = false;
+    }
+    if (util::contains(localVars, op->lhs)) {
+      op->rhs.accept(this);
+      if (dependsOnLoop(op->rhs)) {
+        dependentVars.insert(op->lhs);
+      }
+      offsetVars.erase(op->lhs);
+      return;
+    }
+
+    // Scalars declared outside the loop may only be added to
+    const Var* var = op->lhs.as<Var>();
+    const Add* add = op->rhs.as<Add>();
+    Datatype type = op->lhs.type();
+    if (var == nullptr || var->is_ptr || add == nullptr ||
+        !(type.isInt() || type.isUInt() || type.isFloat()) ||
+        (add->a != op->lhs && add->b != op->lhs)) {
+      independent = false;
+      return;
+    }
+    (add->a == op->lhs ? add->b : add->a).accept(this);
+    if (!util::contains(reductions, op->lhs)) {
+      reductions.push_back(op->lhs);
+    }
+  }
+
+  bool findReductions(const For* op) {
+    localVars.insert(op->var);
+    dependentVars.insert(op->var);
+    offsetVars.insert(op->var);
+    op->contents.accept(this);
+    for (auto& reduction : reductions) {
+      if (util::contains(outerReads, reduction)) {
+        return false;
+      }
+    }
+    // An iteration may only read the elements of the arrays it stores to
+    // that it stores to itself
+    for (auto& load : loads) {
+      if (!util::contains(stores, load.first)) {
+        continue;
+      }
+      for (auto& loc : stores.at(load.first)) {
+        if (loc != load.second) {
+          return false;
+        }
+      }
+    }
+    return independent;
+  }
+};
+
 static string getParallelizePragma(LoopKind kind) {
   stringstream ret;
   ret << "#pragma omp parallel for schedule";
@@ -381,8 +615,10 @@ static string getParallelizePragma(LoopKind kind) {
   return ret.str();
 }
 
+// GCC ignores `#pragma unroll`, while both GCC and Clang accept `#pragma GCC
+// unroll`
 static string getUnrollPragma(size_t unrollFactor) {
-  return "#pragma unroll " + std::to_string(unrollFactor);
+  return "#pragma GCC unroll " + std::to_string(unrollFactor);
 }
 
 static string getAtomicPragma() {
@@ -396,11 +632,32 @@ static string getAtomicPragma() {
 // http://clang.llvm.org/docs/LanguageExtensions.html#extensions-for-loop-hint-optimizations
 void CodeGen_C::visit(const For* op) {
   switch (op->kind) {
-    case LoopKind::Vectorized:
+    case LoopKind::Vectorized: {
+      // Loops whose iterations are independent are vectorized explicitly,
+      // which GCC honors as well, while others only get Clang's hint
       doIndent();
-      out << genVectorizePragma(op->vec_width);
+      FindSimdReductions findReductions;
+      if (findReductions.findReductions(op)) {
+        out << "#pragma omp simd";
+        if (op->vec_width) {
+          out << " simdlen(" << op->vec_width << ")";
+        }
+        if (!findReductions.reductions.empty()) {
+          out << " reduction(+:";
+          string delimiter = "";
+          for (auto& reduction : findReductions.reductions) {
+            out << delimiter << varMap[reduction];
+            delimiter = ",";
+          }
+          out << ")";
+        }
+      }
+      else {
+        out << genVectorizePragma(op->vec_width);
+      }
       out << "\n";
       break;
+    }
     case LoopKind::Static:
     case LoopKind::Dynamic:
     case LoopKind::Runtime:
@@ -410,7 +667,8 @@ void CodeGen_C::visit(const For* op) {
       out << "\n";
       break;
     default:
-      if (op->unrollFactor > 0) {
+      // Coroutines jump into loops, which then cannot be unrolled
+      if (op->unrollFactor > 0 && !emittingCoroutine) {
         doIndent();
         out << getUnrollPragma(op->unrollFactor) << endl;
       }
@@ -38,6 +38,12 @@ const string cHeaders =
   "#define TACO_MIN(_a,_b) ((_a) < (_b) ? (_a) : (_b))\n"
   "#define TACO_MAX(_a,_b) ((_a) > (_b) ? (_a) : (_b))\n"
   "#define TACO_DEREF(_a) (((___context___*)(*__ctx__))->_a)\n"
+  "#define TACO_POPCOUNT(_a) __popcll(_a)\n"
+  "#define TACO_CTZ(_a) (__ffsll(_a) - 1)\n"
+  "#define TACO_BITMASK(_b) (1ULL << (_b))\n"
+  "#define TACO_BIT(_a,_b) ((int)(((_a) >> (_b)) & 1))\n"
+  "#define TACO_RANK(_a,_b) TACO_POPCOUNT((_a) & (TACO_BITMASK(_b) - 1))\n"
+  "#define TACO_HASH(_c,_s) ((int32_t)(((uint32_t)(_c) * 2654435769u) >> (_s)))\n"
   "#ifndef TACO_TENSOR_T_DEFINED\n"
   "#define TACO_TENSOR_T_DEFINED\n"
   "typedef enum { taco_mode_dense, taco_mode_sparse } taco_mode_t;\n"
@@ -64,14 +70,14 @@ const string gpuAssertMacro =
   "    if (abort) exit(code);\n"
   "  }\n"
   "}\n"
-  "__device__ __host__ int taco_binarySearchAfter(int *array, int arrayStart, int arrayEnd, int target) {\n"
+  "__device__ __host__ int64_t taco_binarySearchAfter(int *array, int64_t arrayStart, int64_t arrayEnd, int target) {\n"
   "  if (array[arrayStart] >= target) {\n"
   "    return arrayStart;\n"
   "  }\n"
-  "  int lowerBound = arrayStart; // always < target\n"
-  "  int upperBound = arrayEnd; // always >= target\n"
+  "  int64_t lowerBound = arrayStart; // always < target\n"
+  "  int64_t upperBound = arrayEnd; // always >= target\n"
   "  while (upperBound - lowerBound > 1) {\n"
-  "    int mid = (upperBound + lowerBound) / 2;\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2;\n"
   "    int midValue = array[mid];\n"
   "    if (midValue < target) {\n"
   "      lowerBound = mid;\n"
@@ -85,14 +91,14 @@ const string gpuAssertMacro =
   "  }\n"
   "  return upperBound;\n"
   "}\n"
-  "__device__ __host__ int taco_binarySearchBefore(int *array, int arrayStart, int arrayEnd, int target) {\n"
+  "__device__ __host__ int64_t taco_binarySearchBefore(int *array, int64_t arrayStart, int64_t arrayEnd, int target) {\n"
   "  if (array[arrayEnd] <= target) {\n"
   "    return arrayEnd;\n"
   "  }\n"
-  "  int lowerBound = arrayStart; // always <= target\n"
-  "  int upperBound = arrayEnd; // always > target\n"
+  "  int64_t lowerBound = arrayStart; // always <= target\n"
+  "  int64_t upperBound = arrayEnd; // always > target\n"
   "  while (upperBound - lowerBound > 1) {\n"
-  "    int mid = (upperBound + lowerBound) / 2;\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2;\n"
   "    int midValue = array[mid];\n"
   "    if (midValue < target) {\n"
   "      lowerBound = mid;\n"
@@ -2,18 +2,28 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <dlfcn.h>
+#include <dirent.h>
 #include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
 #if USE_OPENMP
 #include <omp.h>
 #endif
 
 #include "taco/tensor.h"
 #include "taco/error.h"
+#include "taco/ir/ir_visitor.h"
 #include "taco/util/strings.h"
 #include "taco/util/env.h"
+#include "taco/util/files.h"
+#include "taco/util/hash.h"
 #include "codegen/codegen_c.h"
 #include "codegen/codegen_cuda.h"
+#include "codegen/tcc_compiler.h"
 #include "taco/cuda.h"
 
 using namespace std;
@@ -21,6 +31,12 @@ using namespace std;
 namespace taco {
 namespace ir {
 
+Module::~Module() {
+  if (lib_handle) {
+    dlclose(lib_handle);
+  }
+}
+
 void Module::setJITTmpdir() {
   tmpdir = util::getTmpdir();
 }
@@ -45,6 +61,24 @@ void Module::addFunction(Stmt func) {
   funcs.push_back(func);
 }
 
+bool Module::hasParallelLoops() const {
+  struct FindParallelLoops : IRVisitor {
+    using IRVisitor::visit;
+    bool parallel = false;
+
+    void visit(const For* op) {
+      parallel = parallel || (op->kind != LoopKind::Serial &&
+                              op->kind != LoopKind::Vectorized);
+      IRVisitor::visit(op);
+    }
+  };
+  FindParallelLoops findParallelLoops;
+  for (auto& func : funcs) {
+    func.accept(&findParallelLoops);
+  }
+  return findParallelLoops.parallel;
+}
+
 void Module::compileToSource(string path, string prefix) {
   if (!moduleFromUserSource) {
   
@@ -88,7 +122,7 @@ void Module::compileToStaticLibrary(string path, string prefix) {
   
 namespace {
 
-void writeShims(vector<Stmt> funcs, string path, string prefix) {
+string writeShims(vector<Stmt> funcs, string path, string prefix) {
   stringstream shims;
   for (auto func: funcs) {
     if (should_use_CUDA_codegen()) {
@@ -109,11 +143,166 @@ void writeShims(vector<Stmt> funcs, string path, string prefix) {
   shims_file << "#include \"" << path << prefix << ".h\"\n";
   shims_file << shims.str();
   shims_file.close();
+
+  return shims.str();
+}
+
+/// Bump whenever the layout of generated libraries changes in a way that is
+/// not reflected in their source, to invalidate stale cache entries.
+const string kernelCacheVersion = "taco-kernel-cache-1";
+
+/// Temporary files of stores older than this (in seconds) were left behind by
+/// processes that died while storing a library.
+const time_t staleTmpFileAge = 60 * 60;
+
+/// Creates the directory at `path` and any missing parents. Returns false if
+/// one of them could not be created.
+bool createDirectories(const string& path) {
+  for (size_t end = path.find('/', 1); end != string::npos;
+       end = path.find('/', end + 1)) {
+    string parent = path.substr(0, end);
+    if (mkdir(parent.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+  }
+  return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+/// Returns the directory of the persistent kernel cache, or the empty string if
+/// the cache is disabled (the default).  The cache is enabled by pointing the
+/// TACO_CACHE_DIR environment variable at a writable directory.
+string getKernelCacheDir() {
+  string cachedir = util::sanitizePath(util::getFromEnv("TACO_CACHE_DIR", ""));
+  if (cachedir.empty()) {
+    return "";
+  }
+  if (cachedir.back() != '/') {
+    cachedir += '/';
+  }
+  if (!createDirectories(cachedir)) {
+    return "";
+  }
+  return (access(cachedir.c_str(), W_OK) == 0) ? cachedir : "";
+}
+
+/// Computes the content address of a library, which covers everything that
+/// goes into building it except for the (randomly named) temporary paths.
+string getKernelCacheKey(const Target& target, const string& cc,
+                         const string& cflags, const string& source,
+                         const string& header, const string& shims) {
+  uint64_t hash = util::fnv1a(kernelCacheVersion);
+  for (const string& str : {cc, cflags, source, header, shims}) {
+    hash = util::fnv1a(str, hash);
+    hash = util::fnv1a("\0", 1, hash);
+  }
+  hash = util::fnv1a(&target.arch, sizeof(target.arch), hash);
+  hash = util::fnv1a(&target.os, sizeof(target.os), hash);
+
+  stringstream key;
+  key << hex;
+  key.width(16);
+  key.fill('0');
+  key << hash;
+  return key.str();
+}
+
+/// Copies a freshly compiled library into the cache. The library is first
+/// written to a unique temporary file and then renamed into place, so
+/// concurrent readers never observe a partially written file.
+void storeInKernelCache(const string& libpath, const string& cachepath) {
+  // mkstemp picks a name no other thread or process is using
+  string tmppath = cachepath + ".tmpXXXXXX";
+  int fd = mkstemp(&tmppath[0]);
+  if (fd == -1) {
+    return;
+  }
+  fchmod(fd, 0644);
+  close(fd);
+  {
+    ifstream src(libpath, ios::binary);
+    ofstream dst(tmppath, ios::binary | ios::trunc);
+    if (!src.is_open() || !dst.is_open()) {
+      remove(tmppath.c_str());
+      return;
+    }
+    dst << src.rdbuf();
+    if (!dst) {
+      dst.close();
+      remove(tmppath.c_str());
+      return;
+    }
+  }
+  if (rename(tmppath.c_str(), cachepath.c_str()) != 0) {
+    remove(tmppath.c_str());
+  }
+}
+
+/// Removes the least recently used libraries from the cache until its total
+/// size is below the limit given by TACO_CACHE_SIZE (in megabytes, defaults
+/// to 1024), and removes stale temporary files. Entries removed concurrently
+/// by other processes are skipped.
+void evictFromKernelCache(const string& cachedir) {
+  const long long maxSize =
+      atoll(util::getFromEnv("TACO_CACHE_SIZE", "1024").c_str()) << 20;
+
+  DIR* dir = opendir(cachedir.c_str());
+  if (!dir) {
+    return;
+  }
+  struct Entry {
+    string path;
+    time_t lastUsed;
+    long long size;
+  };
+  vector<Entry> entries;
+  long long totalSize = 0;
+  const time_t now = time(nullptr);
+  while (struct dirent* dirent = readdir(dir)) {
+    string name = dirent->d_name;
+    struct stat st;
+    string path = cachedir + name;
+    if (name.find(".so.tmp") != string::npos) {
+      if (stat(path.c_str(), &st) == 0 && now - st.st_mtime > staleTmpFileAge) {
+        remove(path.c_str());
+      }
+      continue;
+    }
+    if (name.size() < 3 || name.compare(name.size() - 3, 3, ".so") != 0) {
+      continue;
+    }
+    if (stat(path.c_str(), &st) == 0) {
+      entries.push_back({path, st.st_mtime, (long long)st.st_size});
+      totalSize += st.st_size;
+    }
+  }
+  closedir(dir);
+
+  if (totalSize <= maxSize) {
+    return;
+  }
+  sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.lastUsed < b.lastUsed;
+  });
+  for (const Entry& entry : entries) {
+    if (totalSize <= maxSize) {
+      break;
+    }
+    remove(entry.path.c_str());
+    totalSize -= entry.size;
+  }
 }
 
 } // anonymous namespace
 
 string Module::compile() {
+  string error;
+  string path = compile(&error);
+  taco_uassert(error.empty()) << error;
+  return path;
+}
+
+string Module::compile(string* error) {
+  taco_iassert(error != nullptr);
   string prefix = tmpdir+libname;
   string fullpath = prefix + ".so";
   
@@ -131,7 +320,7 @@ string Module::compile() {
   else {
     cc = util::getFromEnv(target.compiler_env, target.compiler);
     cflags = util::getFromEnv("TACO_CFLAGS",
-    "-O3 -ffast-math -std=c99") + " -shared -fPIC";
+    "-O3 -ffast-math -std=c99 -fopenmp-simd") + " -shared -fPIC";
 #if USE_OPENMP
     cflags += " -fopenmp";
 #endif
@@ -147,19 +336,63 @@ string Module::compile() {
   compileToSource(tmpdir, libname);
   
   // write out the shims
-  writeShims(funcs, tmpdir, libname);
+  string shims = writeShims(funcs, tmpdir, libname);
+
+  if (lib_handle) {
+    dlclose(lib_handle);
+    lib_handle = nullptr;
+  }
+  tcc = nullptr;
+
+  // compile in-process if the target asks for it, falling back to the external
+  // compiler for code that libtcc cannot handle (e.g. complex arithmetic)
+  if (target.jit == Target::LibTCC && !should_use_CUDA_codegen() &&
+      TCCCompiler::isAvailable()) {
+    auto compiler = make_shared<TCCCompiler>();
+    if (compiler->compile(prefix + file_ending)) {
+      tcc = compiler;
+      return "";
+    }
+#ifdef TACO_DEBUG
+    std::cerr << "libtcc could not compile " << prefix << file_ending <<
+                 ", falling back to " << cc << ":" << endl <<
+                 compiler->getErrors();
+#endif
+  }
+
+  // reuse a library built by this or an earlier process if there is one
+  string cachedir = getKernelCacheDir();
+  string cachepath;
+  if (!cachedir.empty()) {
+    cachepath = cachedir + getKernelCacheKey(target, cc, cflags, source.str(),
+                                             header.str(), shims) + ".so";
+    lib_handle = dlopen(cachepath.data(), RTLD_NOW | RTLD_LOCAL);
+    if (lib_handle) {
+      // mark the entry as recently used for eviction
+      utime(cachepath.data(), nullptr);
+      return cachepath;
+    }
+  }
   
   // now compile it
   int err = system(cmd.data());
-  taco_uassert(err == 0) << "Compilation command failed:\n" << cmd
-    << "\nreturned " << err;
+  if (err != 0) {
+    *error = "Compilation command failed:\n" + cmd + "\nreturned " +
+             to_string(err);
+    return "";
+  }
 
-  // use dlsym() to open the compiled library
-  if (lib_handle) {
-    dlclose(lib_handle);
+  if (!cachepath.empty()) {
+    storeInKernelCache(fullpath, cachepath);
+    evictFromKernelCache(cachedir);
   }
+
+  // use dlsym() to open the compiled library
   lib_handle = dlopen(fullpath.data(), RTLD_NOW | RTLD_LOCAL);
-  taco_uassert(lib_handle) << "Failed to load generated code";
+  if (!lib_handle) {
+    *error = "Failed to load generated code";
+    return "";
+  }
 
   return fullpath;
 }
@@ -174,14 +407,20 @@ string Module::getSource() {
 }
 
 void* Module::getFuncPtr(std::string name) {
+  if (tcc) {
+    return tcc->getSymbol(name);
+  }
   return dlsym(lib_handle, name.data());
 }
 
 int Module::callFuncPackedRaw(std::string name, void** args) {
+  return callFuncPackedRaw(getFuncPtr(name), args);
+}
+
+int Module::callFuncPackedRaw(void* v_func_ptr, void** args) {
   typedef int (*fnptr_t)(void**);
   static_assert(sizeof(void*) == sizeof(fnptr_t),
     "Unable to cast dlsym() returned void pointer to function pointer");
-  void* v_func_ptr = getFuncPtr(name);
   fnptr_t func_ptr;
   *reinterpret_cast<void**>(&func_ptr) = v_func_ptr;
 
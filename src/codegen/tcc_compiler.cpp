@@ -0,0 +1,130 @@
+#include "codegen/tcc_compiler.h"
+
+#include <dlfcn.h>
+#include <mutex>
+
+#include "taco/error.h"
+#include "taco/util/env.h"
+
+using namespace std;
+
+namespace taco {
+namespace ir {
+
+namespace {
+
+// Output type that makes libtcc link into memory (TCC_OUTPUT_MEMORY)
+const int tccOutputMemory = 1;
+
+// Lets libtcc 0.9.27 and earlier allocate the memory for relocated code
+// (TCC_RELOCATE_AUTO)
+void* const tccRelocateAuto = (void*)1;
+
+// libtcc keeps global state in the releases taco supports, so compilation
+// contexts must not be used by several threads at once
+std::mutex tccMutex;
+
+/// The subset of the libtcc API used by taco, resolved at runtime.
+struct LibTCC {
+  void* handle;
+
+  void* (*tcc_new)();
+  void  (*tcc_delete)(void*);
+  void  (*tcc_set_error_func)(void*, void*, void (*)(void*, const char*));
+  int   (*tcc_set_output_type)(void*, int);
+  int   (*tcc_add_file)(void*, const char*);
+  int   (*tcc_add_library)(void*, const char*);
+  void* (*tcc_get_symbol)(void*, const char*);
+
+  // tcc_relocate takes the destination of the code as a second argument up to
+  // libtcc 0.9.27, and only the state in later versions, which also introduced
+  // _tcc_setjmp. Exactly one of these is resolved.
+  int   (*tcc_relocate)(void*, void*);
+  int   (*tcc_relocate_auto)(void*);
+
+  LibTCC() : tcc_relocate(nullptr), tcc_relocate_auto(nullptr) {
+    string path = util::getFromEnv("TACO_LIBTCC", "libtcc.so");
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+      return;
+    }
+    const bool relocatesInPlace = dlsym(handle, "_tcc_setjmp") != nullptr;
+    if (!(resolve(&tcc_new, "tcc_new") &&
+          resolve(&tcc_delete, "tcc_delete") &&
+          resolve(&tcc_set_error_func, "tcc_set_error_func") &&
+          resolve(&tcc_set_output_type, "tcc_set_output_type") &&
+          resolve(&tcc_add_file, "tcc_add_file") &&
+          resolve(&tcc_add_library, "tcc_add_library") &&
+          (relocatesInPlace ? resolve(&tcc_relocate_auto, "tcc_relocate")
+                            : resolve(&tcc_relocate, "tcc_relocate")) &&
+          resolve(&tcc_get_symbol, "tcc_get_symbol"))) {
+      dlclose(handle);
+      handle = nullptr;
+    }
+  }
+
+  int relocate(void* state) const {
+    return tcc_relocate_auto ? tcc_relocate_auto(state)
+                             : tcc_relocate(state, tccRelocateAuto);
+  }
+
+  template <typename FnPtr>
+  bool resolve(FnPtr* fn, const char* name) {
+    static_assert(sizeof(void*) == sizeof(FnPtr),
+      "Unable to cast dlsym() returned void pointer to function pointer");
+    void* sym = dlsym(handle, name);
+    *reinterpret_cast<void**>(fn) = sym;
+    return sym != nullptr;
+  }
+};
+
+const LibTCC& getLibTCC() {
+  static LibTCC libtcc;
+  return libtcc;
+}
+
+void appendError(void* errors, const char* msg) {
+  *static_cast<string*>(errors) += string(msg) + "\n";
+}
+
+} // anonymous namespace
+
+bool TCCCompiler::isAvailable() {
+  return getLibTCC().handle != nullptr;
+}
+
+TCCCompiler::TCCCompiler() : state(nullptr) {
+  taco_iassert(isAvailable()) << "libtcc is not available";
+  const LibTCC& libtcc = getLibTCC();
+  std::lock_guard<std::mutex> lock(tccMutex);
+  state = libtcc.tcc_new();
+  taco_uassert(state) << "Failed to create a libtcc compilation context";
+  libtcc.tcc_set_error_func(state, &errors, appendError);
+  libtcc.tcc_set_output_type(state, tccOutputMemory);
+}
+
+TCCCompiler::~TCCCompiler() {
+  std::lock_guard<std::mutex> lock(tccMutex);
+  getLibTCC().tcc_delete(state);
+}
+
+bool TCCCompiler::compile(const string& path) {
+  const LibTCC& libtcc = getLibTCC();
+  std::lock_guard<std::mutex> lock(tccMutex);
+  if (libtcc.tcc_add_file(state, path.c_str()) != 0) {
+    return false;
+  }
+  libtcc.tcc_add_library(state, "m");
+  return libtcc.relocate(state) >= 0;
+}
+
+void* TCCCompiler::getSymbol(const string& name) const {
+  std::lock_guard<std::mutex> lock(tccMutex);
+  return getLibTCC().tcc_get_symbol(state, name.c_str());
+}
+
+const string& TCCCompiler::getErrors() const {
+  return errors;
+}
+
+}}
@@ -0,0 +1,44 @@
+#ifndef TACO_TCC_COMPILER_H
+#define TACO_TCC_COMPILER_H
+
+#include <string>
+
+namespace taco {
+namespace ir {
+
+/// An in-process C compiler backed by libtcc. The library is loaded with
+/// dlopen the first time it is needed, so taco neither links against libtcc
+/// nor requires it to be installed. Code is compiled and linked directly into
+/// memory, without writing a shared library or starting a compiler process.
+/// Calls into libtcc are serialized, so compilers may be used from several
+/// threads.
+class TCCCompiler {
+public:
+  /// True iff libtcc could be loaded. The library is looked up as given by
+  /// the TACO_LIBTCC environment variable, and otherwise as libtcc.so.
+  static bool isAvailable();
+
+  TCCCompiler();
+  ~TCCCompiler();
+
+  /// Compile and link the C source file at `path`. Returns false if libtcc
+  /// rejected the code, in which case `getErrors` describes why.
+  bool compile(const std::string& path);
+
+  /// Get a pointer to a compiled function or global, or nullptr if no symbol
+  /// of this name exists.
+  void* getSymbol(const std::string& name) const;
+
+  /// Get the diagnostics libtcc emitted while compiling.
+  const std::string& getErrors() const;
+
+private:
+  void* state;
+  std::string errors;
+
+  TCCCompiler(const TCCCompiler&) = delete;
+  TCCCompiler& operator=(const TCCCompiler&) = delete;
+};
+
+}}
+#endif
@@ -9,6 +9,9 @@
 #include "taco/lower/mode_format_dense.h"
 #include "taco/lower/mode_format_compressed.h"
 #include "taco/lower/mode_format_singleton.h"
+#include "taco/lower/mode_format_tile.h"
+#include "taco/lower/mode_format_hashed.h"
+#include "taco/lower/mode_format_bitmap.h"
 
 #include "taco/error.h"
 #include "taco/util/strings.h"
@@ -87,7 +90,8 @@ Datatype Format::getCoordinateTypePos(size_t level) const {
 
 Datatype Format::getCoordinateTypeIdx(size_t level) const {
   if (level >= levelArrayTypes.size()) {
-    return Int32;
+    return (getModeFormats()[level].getName() == Bitmap.getName()) ? UInt64
+                                                                  : Int32;
   }
   if (getModeFormats()[level].getName() == Dense.getName()) {
     return levelArrayTypes[level][0];
@@ -99,6 +103,21 @@ void Format::setLevelArrayTypes(std::vector<std::vector<Datatype>> levelArrayTyp
   this->levelArrayTypes = levelArrayTypes;
 }
 
+Datatype Format::getPositionType() const {
+  Datatype positionType = Int32;
+  const auto modeFormats = getModeFormats();
+  for (size_t level = 0; level < levelArrayTypes.size(); level++) {
+    if (modeFormats[level].getName() == Dense.getName()) {
+      continue;
+    }
+    Datatype posType = getCoordinateTypePos(level);
+    if (posType.getNumBits() > positionType.getNumBits()) {
+      positionType = posType;
+    }
+  }
+  return positionType;
+}
+
 
 bool operator==(const Format& a, const Format& b){
   const auto aModeTypePacks = a.getModeFormatPacks();
@@ -120,6 +139,12 @@ bool operator==(const Format& a, const Format& b){
       return false;
     }
   } 
+  for (size_t level = 0; level < aModeOrdering.size(); level++) {
+    if (a.getCoordinateTypePos(level) != b.getCoordinateTypePos(level) ||
+        a.getCoordinateTypeIdx(level) != b.getCoordinateTypeIdx(level)) {
+      return false;
+    }
+  }
   return true;
 }
 
@@ -262,6 +287,19 @@ bool ModeFormat::hasAppend() const {
   return impl->hasAppend;
 }
 
+bool ModeFormat::hasFixedSize() const {
+  taco_iassert(defined());
+  return impl->hasFixedSize();
+}
+
+int ModeFormat::getTableSize() const {
+  taco_iassert(defined());
+  auto hashed = std::dynamic_pointer_cast<const HashedModeFormat>(impl);
+  taco_uassert(hashed != nullptr) << "The mode format " << getName() <<
+      " does not store hash tables";
+  return hashed->getTableSize();
+}
+
 bool ModeFormat::defined() const {
   return impl != nullptr;
 }
@@ -332,6 +370,9 @@ ModeFormat ModeFormat::Dense(std::make_shared<DenseModeFormat>());
 ModeFormat ModeFormat::Compressed(std::make_shared<CompressedModeFormat>());
 ModeFormat ModeFormat::Sparse = ModeFormat::Compressed;
 ModeFormat ModeFormat::Singleton(std::make_shared<SingletonModeFormat>());
+ModeFormat ModeFormat::Tile(std::make_shared<TileModeFormat>());
+ModeFormat ModeFormat::Hashed(std::make_shared<HashedModeFormat>());
+ModeFormat ModeFormat::Bitmap(std::make_shared<BitmapModeFormat>());
 
 ModeFormat ModeFormat::dense = ModeFormat::Dense;
 ModeFormat ModeFormat::compressed = ModeFormat::Compressed;
@@ -342,6 +383,9 @@ const ModeFormat Dense = ModeFormat::Dense;
 const ModeFormat Compressed = ModeFormat::Compressed;
 const ModeFormat Sparse = ModeFormat::Compressed;
 const ModeFormat Singleton = ModeFormat::Singleton;
+const ModeFormat Tile = ModeFormat::Tile;
+const ModeFormat Hashed = ModeFormat::Hashed;
+const ModeFormat Bitmap = ModeFormat::Bitmap;
 
 const ModeFormat dense = ModeFormat::Dense;
 const ModeFormat compressed = ModeFormat::Compressed;
@@ -352,6 +396,8 @@ const Format CSR({Dense, Sparse}, {0,1});
 const Format CSC({Dense, Sparse}, {1,0});
 const Format DCSR({Sparse, Sparse}, {0,1});
 const Format DCSC({Sparse, Sparse}, {1,0});
+const Format BCSR({Dense, Sparse, Tile, Tile}, {0,1,2,3});
+const Format SELL({Dense, Sparse, Tile, Singleton}, {0,1,2,3});
 
 const Format COO(int order, bool isUnique, bool isOrdered, bool isAoS, 
                  const std::vector<int>& modeOrdering) {
@@ -387,4 +433,33 @@ bool isDense(const Format& format) {
   return true;
 }
 
+Format narrowCoordinateTypes(Format format, const std::vector<int>& dimensions) {
+  taco_uassert((size_t)format.getOrder() == dimensions.size()) <<
+      "The number of format mode types (" << format.getOrder() << ") " <<
+      "must match the tensor order (" << dimensions.size() << ").";
+
+  std::vector<std::vector<Datatype>> levelArrayTypes;
+  const std::vector<ModeFormat> modeFormats = format.getModeFormats();
+  for (int level = 0; level < format.getOrder(); level++) {
+    Datatype posType = format.getCoordinateTypePos(level);
+    if (modeFormats[level].getName() == Dense.getName()) {
+      levelArrayTypes.push_back({posType});
+      continue;
+    }
+    // Hashed modes mark empty slots with negative coordinates, and bitmap
+    // modes store words rather than coordinates
+    if (modeFormats[level].getName() == Hashed.getName() ||
+        modeFormats[level].getName() == Bitmap.getName()) {
+      levelArrayTypes.push_back({posType, format.getCoordinateTypeIdx(level)});
+      continue;
+    }
+    const int dimension = dimensions[format.getModeOrdering()[level]];
+    Datatype crdType = (dimension <= (1 << 8))  ? UInt8  :
+                       (dimension <= (1 << 16)) ? UInt16 : Int32;
+    levelArrayTypes.push_back({posType, crdType});
+  }
+  format.setLevelArrayTypes(levelArrayTypes);
+  return format;
+}
+
 }
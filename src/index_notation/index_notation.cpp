@@ -6,6 +6,7 @@
 #include <vector>
 #include <utility>
 #include <set>
+#include <typeinfo>
 #include <taco/ir/simplify.h>
 #include "lower/mode_access.h"
 
@@ -28,6 +29,7 @@
 #include "taco/util/scopedmap.h"
 #include "taco/util/strings.h"
 #include "taco/util/collections.h"
+#include "taco/util/hash.h"
 
 using namespace std;
 
@@ -350,7 +352,8 @@ struct Isomorphic : public IndexNotationVisitorStrict {
         !check(anode->stmt, bnode->stmt) ||
         anode->parallel_unit != bnode->parallel_unit ||
         anode->output_race_strategy != bnode->output_race_strategy ||
-        anode->unrollFactor != bnode->unrollFactor) {
+        anode->unrollFactor != bnode->unrollFactor ||
+        anode->merge_strategy != bnode->merge_strategy) {
       eq = false;
       return;
     }
@@ -434,6 +437,210 @@ bool isomorphic(IndexStmt a, IndexStmt b) {
   return Isomorphic().check(a,b);
 }
 
+/// Computes a hash of the structure of an index expression or statement that
+/// is consistent with `isomorphic`: tensor and index variables are numbered in
+/// order of first appearance rather than hashed by identity, so isomorphic
+/// statements always hash to the same value.
+struct StructuralHash : public IndexNotationVisitorStrict {
+  size_t hash = 0;
+  std::map<TensorVar,size_t> tensorIds;
+  std::map<IndexVar,size_t> indexVarIds;
+
+  using IndexNotationVisitorStrict::visit;
+
+  size_t compute(IndexExpr expr) {
+    add(expr);
+    return hash;
+  }
+
+  size_t compute(IndexStmt stmt) {
+    add(stmt);
+    return hash;
+  }
+
+  void add(size_t value) {
+    util::hashCombine(hash, value);
+  }
+
+  void add(IndexExpr expr) {
+    add((size_t)expr.defined());
+    if (expr.defined()) {
+      expr.accept(this);
+    }
+  }
+
+  void add(IndexStmt stmt) {
+    add((size_t)stmt.defined());
+    if (stmt.defined()) {
+      stmt.accept(this);
+    }
+  }
+
+  void add(Datatype type) {
+    add((size_t)type.getKind());
+  }
+
+  void add(TensorVar tensor) {
+    if (!util::contains(tensorIds, tensor)) {
+      size_t id = tensorIds.size();
+      tensorIds.insert({tensor, id});
+      add(tensor.getType().getDataType());
+      for (const Dimension& dim : tensor.getType().getShape()) {
+        add(dim.isFixed() ? dim.getSize() : (size_t)-1);
+      }
+      const Format& format = tensor.getFormat();
+      for (const ModeFormat& modeFormat : format.getModeFormats()) {
+        add(std::hash<std::string>()(modeFormat.getName()));
+      }
+      for (int mode : format.getModeOrdering()) {
+        add((size_t)mode);
+      }
+    }
+    add(tensorIds.at(tensor));
+  }
+
+  void add(IndexVar var) {
+    if (!util::contains(indexVarIds, var)) {
+      size_t id = indexVarIds.size();
+      indexVarIds.insert({var, id});
+    }
+    add(indexVarIds.at(var));
+  }
+
+  template <class T>
+  void addNode(const T* node) {
+    add(typeid(T).hash_code());
+  }
+
+  void visit(const AccessNode* node) {
+    addNode(node);
+    add(node->tensorVar);
+    add(node->indexVars.size());
+    for (auto& indexVar : node->indexVars) {
+      add(indexVar);
+    }
+  }
+
+  void visit(const LiteralNode* node) {
+    addNode(node);
+    add(node->getDataType());
+    add((size_t)util::fnv1a(node->val, node->getDataType().getNumBytes()));
+  }
+
+  void visit(const NegNode* node) {
+    addNode(node);
+    add(node->a);
+  }
+
+  void visit(const SqrtNode* node) {
+    addNode(node);
+    add(node->a);
+  }
+
+  template <class T>
+  void visitBinary(const T* node) {
+    addNode(node);
+    add(node->a);
+    add(node->b);
+  }
+
+  void visit(const AddNode* node) {
+    visitBinary(node);
+  }
+
+  void visit(const SubNode* node) {
+    visitBinary(node);
+  }
+
+  void visit(const MulNode* node) {
+    visitBinary(node);
+  }
+
+  void visit(const DivNode* node) {
+    visitBinary(node);
+  }
+
+  void visit(const CastNode* node) {
+    addNode(node);
+    add(node->getDataType());
+    add(node->a);
+  }
+
+  void visit(const CallIntrinsicNode* node) {
+    addNode(node);
+    add(std::hash<std::string>()(node->func->getName()));
+    add(node->args.size());
+    for (auto& arg : node->args) {
+      add(arg);
+    }
+  }
+
+  void visit(const ReductionNode* node) {
+    addNode(node);
+    add(node->op);
+    add(node->var);
+    add(node->a);
+  }
+
+  void visit(const AssignmentNode* node) {
+    addNode(node);
+    add(node->lhs);
+    add(node->rhs);
+    add(node->op);
+  }
+
+  void visit(const YieldNode* node) {
+    addNode(node);
+    add(node->indexVars.size());
+    for (auto& indexVar : node->indexVars) {
+      add(indexVar);
+    }
+    add(node->expr);
+  }
+
+  void visit(const ForallNode* node) {
+    addNode(node);
+    add(node->indexVar);
+    add(node->stmt);
+    add((size_t)node->parallel_unit);
+    add((size_t)node->output_race_strategy);
+    add(node->unrollFactor);
+    add((size_t)node->merge_strategy);
+  }
+
+  void visit(const WhereNode* node) {
+    addNode(node);
+    add(node->consumer);
+    add(node->producer);
+  }
+
+  void visit(const SequenceNode* node) {
+    addNode(node);
+    add(node->definition);
+    add(node->mutation);
+  }
+
+  void visit(const MultiNode* node) {
+    addNode(node);
+    add(node->stmt1);
+    add(node->stmt2);
+  }
+
+  void visit(const SuchThatNode* node) {
+    addNode(node);
+    add(node->stmt);
+    add(node->predicate.size());
+  }
+};
+
+size_t structuralHash(IndexExpr expr) {
+  return StructuralHash().compute(expr);
+}
+
+size_t structuralHash(IndexStmt stmt) {
+  return StructuralHash().compute(stmt);
+}
+
 struct Equals : public IndexNotationVisitorStrict {
   bool eq = false;
   IndexExpr bExpr;
@@ -637,7 +844,8 @@ struct Equals : public IndexNotationVisitorStrict {
         !equals(anode->stmt, bnode->stmt) ||
         anode->parallel_unit != bnode->parallel_unit ||
         anode->output_race_strategy != bnode->output_race_strategy ||
-        anode->unrollFactor != bnode->unrollFactor) {
+        anode->unrollFactor != bnode->unrollFactor ||
+        anode->merge_strategy != bnode->merge_strategy) {
       eq = false;
       return;
     }
@@ -1523,7 +1731,7 @@ IndexStmt IndexStmt::unroll(IndexVar i, size_t unrollFactor) const {
 
     void visit(const ForallNode* node) {
       if (node->indexVar == i) {
-        stmt = Forall(i, rewrite(node->stmt), node->parallel_unit, node->output_race_strategy, unrollFactor);
+        stmt = Forall(i, rewrite(node->stmt), node->parallel_unit, node->output_race_strategy, unrollFactor, node->merge_strategy);
       }
       else {
         IndexNotationRewriter::visit(node);
@@ -1533,6 +1741,31 @@ IndexStmt IndexStmt::unroll(IndexVar i, size_t unrollFactor) const {
   return UnrollLoop(i, unrollFactor).rewrite(*this);
 }
 
+IndexStmt IndexStmt::mergeby(IndexVar i, MergeStrategy strategy) const {
+  struct MergeBy : IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+    IndexVar i;
+    MergeStrategy strategy;
+    bool found = false;
+    MergeBy(IndexVar i, MergeStrategy strategy) : i(i), strategy(strategy) {}
+
+    void visit(const ForallNode* node) {
+      if (node->indexVar == i) {
+        found = true;
+        stmt = Forall(i, rewrite(node->stmt), node->parallel_unit, node->output_race_strategy, node->unrollFactor, strategy);
+      }
+      else {
+        IndexNotationRewriter::visit(node);
+      }
+    }
+  };
+  MergeBy mergeBy(i, strategy);
+  IndexStmt transformed = mergeBy.rewrite(*this);
+  taco_uassert(mergeBy.found)
+      << "Index variable " << i << " is not bound by a forall in " << *this;
+  return transformed;
+}
+
 std::ostream& operator<<(std::ostream& os, const IndexStmt& expr) {
   if (!expr.defined()) return os << "IndexStmt()";
   IndexNotationPrinter printer(os);
@@ -1621,8 +1854,9 @@ Forall::Forall(IndexVar indexVar, IndexStmt stmt)
     : Forall(indexVar, stmt, ParallelUnit::NotParallel, OutputRaceStrategy::IgnoreRaces) {
 }
 
-Forall::Forall(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor)
-        : Forall(new ForallNode(indexVar, stmt, parallel_unit, output_race_strategy, unrollFactor)) {
+Forall::Forall(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor,
+               MergeStrategy merge_strategy)
+        : Forall(new ForallNode(indexVar, stmt, parallel_unit, output_race_strategy, unrollFactor, merge_strategy)) {
 }
 
 IndexVar Forall::getIndexVar() const {
@@ -1645,12 +1879,17 @@ size_t Forall::getUnrollFactor() const {
   return getNode(*this)->unrollFactor;
 }
 
+MergeStrategy Forall::getMergeStrategy() const {
+  return getNode(*this)->merge_strategy;
+}
+
 Forall forall(IndexVar i, IndexStmt stmt) {
   return Forall(i, stmt);
 }
 
-Forall forall(IndexVar i, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor) {
-  return Forall(i, stmt, parallel_unit, output_race_strategy, unrollFactor);
+Forall forall(IndexVar i, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor,
+              MergeStrategy merge_strategy) {
+  return Forall(i, stmt, parallel_unit, output_race_strategy, unrollFactor, merge_strategy);
 }
 
 template <> bool isa<Forall>(IndexStmt s) {
@@ -2698,7 +2937,10 @@ private:
 
   void visit(const YieldNode* op) {
     IndexExpr expr = rewrite(op->expr);
-    if (expr == op->expr) {
+    if (!expr.defined()) {
+      stmt = IndexStmt();
+    }
+    else if (expr == op->expr) {
       stmt = op;
     }
     else {
@@ -2715,7 +2957,7 @@ private:
       stmt = op;
     }
     else {
-      stmt = new ForallNode(op->indexVar, body, op->parallel_unit, op->output_race_strategy, op->unrollFactor);
+      stmt = new ForallNode(op->indexVar, body, op->parallel_unit, op->output_race_strategy, op->unrollFactor, op->merge_strategy);
     }
   }
 
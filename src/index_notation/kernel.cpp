@@ -64,13 +64,31 @@ void unpackResults(size_t numResults, const vector<void*> arguments,
         modeIndices.push_back(ModeIndex({size}));
         num *= ((int*)tensorData->indices[i][0])[0];
       } else if (modeType.getName() == Sparse.getName()) {
-        auto size = ((int*)tensorData->indices[i][0])[num];
-        Array pos = Array(type<int>(), tensorData->indices[i][0],
-                          num+1, Array::UserOwns);
-        Array idx = Array(type<int>(), tensorData->indices[i][1],
-                          size, Array::UserOwns);
+        Array pos = Array(format.getCoordinateTypePos(i),
+                          tensorData->indices[i][0], num+1, Array::UserOwns);
+        auto size = pos.get(num).getAsIndex();
+        Array idx = Array(format.getCoordinateTypeIdx(i),
+                          tensorData->indices[i][1], size, Array::UserOwns);
         modeIndices.push_back(ModeIndex({pos, idx}));
         num = size;
+      } else if (modeType.getName() == Hashed.getName()) {
+        int tableSize = *(int*)tensorData->indices[i][0];
+        size_t size = num * tableSize;
+        Array idx = Array(format.getCoordinateTypeIdx(i),
+                          tensorData->indices[i][1], size, Array::UserOwns);
+        modeIndices.push_back(ModeIndex({makeArray({tableSize}), idx}));
+        num = size;
+      } else if (modeType.getName() == Bitmap.getName()) {
+        int dimension = tensorData->dimensions[format.getModeOrdering()[i]];
+        size_t numWords = num * ((dimension + 63) / 64);
+        Array rank = Array(format.getCoordinateTypePos(i),
+                           tensorData->indices[i][0], numWords + 1,
+                           Array::UserOwns);
+        Array bitmap = Array(format.getCoordinateTypeIdx(i),
+                             tensorData->indices[i][1], numWords,
+                             Array::UserOwns);
+        modeIndices.push_back(ModeIndex({rank, bitmap}));
+        num = rank.get(numWords).getAsIndex();
       } else {
         taco_not_supported_yet;
       }
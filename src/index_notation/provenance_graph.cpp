@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <taco/ir/simplify.h>
 #include "lower/mode_access.h"
+#include "ir/ir_generators.h"
 
 #include "error/error_checks.h"
 #include "taco/error/error_messages.h"
@@ -368,13 +369,13 @@ std::vector<ir::Expr> PosRelNode::locateBounds(std::vector<ir::Expr> coordBounds
           coordBounds[1]
   };
 
-  ir::Expr start = ir::Call::make("taco_binarySearchAfter", binarySearchArgsStart, boundType);
+  ir::Expr start = ir::callSearchFunction("taco_binarySearchAfter", binarySearchArgsStart, boundType);
   // simplify start when this is 0
   ir::Expr simplifiedParentBound = ir::simplify(coordBounds[0]);
   if (isa<ir::Literal>(simplifiedParentBound) && to<ir::Literal>(simplifiedParentBound)->equalsScalar(0)) {
     start = segment_bounds[0];
   }
-  ir::Expr end = ir::Call::make("taco_binarySearchAfter", binarySearchArgsEnd, boundType);
+  ir::Expr end = ir::callSearchFunction("taco_binarySearchAfter", binarySearchArgsEnd, boundType);
   // simplify end -> A1_pos[1] when parentBound[1] is max coord dimension
   simplifiedParentBound = ir::simplify(coordBounds[1]);
   if (isa<ir::GetProperty>(simplifiedParentBound) && to<ir::GetProperty>(simplifiedParentBound)->property == ir::TensorProperty::Dimension) {
@@ -461,7 +462,7 @@ ir::Stmt PosRelNode::recoverChild(taco::IndexVar indexVar,
           segment_bounds[1], // arrayEnd
           variableNames[getParentVar()]
   };
-  return ir::VarDecl::make(posVarExpr, ir::Call::make("taco_binarySearchAfter", binarySearchArgs, posVarExpr.type()));
+  return ir::VarDecl::make(posVarExpr, ir::callSearchFunction("taco_binarySearchAfter", binarySearchArgs, posVarExpr.type()));
 }
 
 bool operator==(const PosRelNode& a, const PosRelNode& b) {
@@ -7,6 +7,7 @@
 #include "taco/util/collections.h"
 #include "taco/lower/iterator.h"
 #include "taco/lower/merge_lattice.h"
+#include "taco/lower/mode_format_hashed.h"
 
 #include <iostream>
 #include <algorithm>
@@ -473,6 +474,57 @@ OutputRaceStrategy Parallelize::getOutputRaceStrategy() const {
   return content->output_race_strategy;
 }
 
+/// The largest number of components of the results that parallel CPU loops
+/// privatize per thread. Zeroing and reducing larger private copies costs more
+/// than the atomic updates that privatization avoids.
+static const size_t MAX_PRIVATIZED_SIZE = 1 << 20;
+
+/// Returns true if the results that a parallel loop over the given underived
+/// index variables races on should be privatized per thread. Only dense
+/// results that are reduced into can be privatized.
+static bool shouldPrivatizeResults(IndexStmt stmt,
+                                   const vector<IndexVar>& underivedVars,
+                                   const ProvenanceGraph& provGraph) {
+  bool privatizable = true;
+  size_t privatizedSize = 0;
+  match(stmt,
+    function<void(const AssignmentNode*)>([&](const AssignmentNode* node) {
+      Assignment assignment(node);
+      for (auto& indexVar : assignment.getLhs().getIndexVars()) {
+        for (auto& underivedVar : provGraph.getUnderivedAncestors(indexVar)) {
+          if (util::contains(underivedVars, underivedVar)) {
+            return;
+          }
+        }
+      }
+
+      TensorVar result = assignment.getLhs().getTensorVar();
+      if (result.getOrder() == 0 || !assignment.getOperator().defined() ||
+          !isa<Add>(assignment.getOperator())) {
+        privatizable = false;
+        return;
+      }
+      for (auto& modeFormat : result.getFormat().getModeFormats()) {
+        if (modeFormat != Dense) {
+          privatizable = false;
+          return;
+        }
+      }
+
+      // Results with dimensions that are not known until runtime are assumed
+      // to be small enough to privatize
+      size_t resultSize = 1;
+      for (auto& dimension : result.getType().getShape()) {
+        if (dimension.isFixed()) {
+          resultSize *= dimension.getSize();
+        }
+      }
+      privatizedSize += resultSize;
+    })
+  );
+  return privatizable && privatizedSize <= MAX_PRIVATIZED_SIZE;
+}
+
 IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
   INIT_REASON(reason);
 
@@ -513,10 +565,20 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
           return;
         }
 
-        // Precondition 2: Every result iterator must have insert capability
+        // Precondition 2: Every result iterator must have insert capability,
+        // except for leaf levels below insert levels that a top-level loop
+        // of CPU threads can append to in parallel in two passes
+        bool canAppendInParallel =
+            definedIndexVars.size() == 1 && !should_use_CUDA_codegen() &&
+            parallelize.getParallelUnit() == ParallelUnit::CPUThread &&
+            parallelize.getOutputRaceStrategy() == OutputRaceStrategy::NoRaces;
         for (Iterator iterator : lattice.results()) {
+          bool isTopLevel = iterator.getParent().isRoot();
           while (true) {
-            if (!iterator.hasInsert()) {
+            if (!iterator.hasInsert() &&
+                !(canAppendInParallel && isTopLevel && iterator.isLeaf() &&
+                  !iterator.getParent().isRoot() && iterator.hasAppend() &&
+                  iterator.hasParallelAppend())) {
               reason = "Precondition failed: The output tensor must allow inserts";
               return;
             }
@@ -543,7 +605,20 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
         MergeLattice underivedLattice = MergeLattice::make(underivedForall, iterators, provGraph, definedIndexVars);
 
 
-        if(underivedLattice.results().empty() && parallelize.getOutputRaceStrategy() == OutputRaceStrategy::Temporary) {
+        // Results indexed by variables of inner loops are scattered into
+        // rather than reduced, and are privatized below
+        bool scatters = false;
+        match(foralli.getStmt(),
+              function<void(const AssignmentNode*)>([&](const AssignmentNode* node) {
+                for (auto& indexVar : node->lhs.getIndexVars()) {
+                  if (!util::contains(definedIndexVars, indexVar)) {
+                    scatters = true;
+                  }
+                }
+              })
+        );
+
+        if(underivedLattice.results().empty() && !scatters && parallelize.getOutputRaceStrategy() == OutputRaceStrategy::Temporary) {
           // Need to precompute reduction
 
           // Find all occurrences of reduction in expression
@@ -563,7 +638,7 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
           );
           taco_iassert(!precomputeAssignments.empty());
 
-          IndexStmt precomputed_stmt = forall(i, foralli.getStmt(), parallelize.getParallelUnit(), parallelize.getOutputRaceStrategy(), foralli.getUnrollFactor());
+          IndexStmt precomputed_stmt = forall(i, foralli.getStmt(), parallelize.getParallelUnit(), parallelize.getOutputRaceStrategy(), foralli.getUnrollFactor(), foralli.getMergeStrategy());
           for (auto assignment : precomputeAssignments) {
             // Construct temporary of correct type and size of outer loop
             TensorVar w(string("w_") + ParallelUnit_NAMES[(int) parallelize.getParallelUnit()], Type(assignment->lhs.getDataType(), {Dimension(i)}), taco::dense);
@@ -572,7 +647,7 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
             IndexStmt producer = ReplaceReductionExpr(map<Access, Access>({{assignment->lhs, w(i)}})).rewrite(precomputed_stmt);
             taco_iassert(isa<Forall>(producer));
             Forall producer_forall = to<Forall>(producer);
-            producer = forall(producer_forall.getIndexVar(), producer_forall.getStmt(), parallelize.getParallelUnit(), parallelize.getOutputRaceStrategy(), foralli.getUnrollFactor());
+            producer = forall(producer_forall.getIndexVar(), producer_forall.getStmt(), parallelize.getParallelUnit(), parallelize.getOutputRaceStrategy(), foralli.getUnrollFactor(), foralli.getMergeStrategy());
 
             // build consumer that writes from temporary to output, mark consumer as parallel reduction
             ParallelUnit reductionUnit = ParallelUnit::CPUThreadGroupReduction;
@@ -591,19 +666,30 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
           return;
         }
 
-        if (parallelize.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+        // CPU threads privatize the results they race on, unless the results
+        // are too large to copy per thread or cannot be privatized
+        OutputRaceStrategy outputRaceStrategy =
+            parallelize.getOutputRaceStrategy();
+        if (outputRaceStrategy == OutputRaceStrategy::Temporary &&
+            !should_use_CUDA_codegen() &&
+            !shouldPrivatizeResults(foralli.getStmt(), underivedAncestors,
+                                    provGraph)) {
+          outputRaceStrategy = OutputRaceStrategy::Atomics;
+        }
+
+        if (outputRaceStrategy == OutputRaceStrategy::Atomics) {
           // want to avoid extra atomics by accumulating variable and then 
           // reducing at end
           IndexStmt body = scalarPromote(foralli.getStmt(), provGraph, 
                                          false, true);
           stmt = forall(i, body, parallelize.getParallelUnit(), 
-                        parallelize.getOutputRaceStrategy(), 
-                        foralli.getUnrollFactor());
+                        outputRaceStrategy, foralli.getUnrollFactor(),
+                        foralli.getMergeStrategy());
           return;
         }
 
 
-        stmt = forall(i, foralli.getStmt(), parallelize.getParallelUnit(), parallelize.getOutputRaceStrategy(), foralli.getUnrollFactor());
+        stmt = forall(i, foralli.getStmt(), parallelize.getParallelUnit(), outputRaceStrategy, foralli.getUnrollFactor(), foralli.getMergeStrategy());
         return;
       }
 
@@ -783,6 +869,7 @@ IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
     IndexStmt innerBody;
     map <IndexVar, ParallelUnit> forallParallelUnit;
     map <IndexVar, OutputRaceStrategy> forallOutputRaceStrategy;
+    map <IndexVar, MergeStrategy> forallMergeStrategy;
     vector<IndexVar> indexVarOriginalOrder;
     Iterators iterators;
 
@@ -796,6 +883,7 @@ IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
       indexVarOriginalOrder.push_back(i);
       forallParallelUnit[i] = foralli.getParallelUnit();
       forallOutputRaceStrategy[i] = foralli.getOutputRaceStrategy();
+      forallMergeStrategy[i] = foralli.getMergeStrategy();
 
       // Iterator and if Iterator enforces constraints
       vector<pair<Iterator, bool>> depIterators;
@@ -878,12 +966,15 @@ IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
     IndexStmt innerBody;
     const map <IndexVar, ParallelUnit> forallParallelUnit;
     const map <IndexVar, OutputRaceStrategy> forallOutputRaceStrategy;
+    const map <IndexVar, MergeStrategy> forallMergeStrategy;
 
     TopoReorderRewriter(const vector<IndexVar>& sortedVars, IndexStmt innerBody,
                         const map <IndexVar, ParallelUnit> forallParallelUnit,
-                        const map <IndexVar, OutputRaceStrategy> forallOutputRaceStrategy)
+                        const map <IndexVar, OutputRaceStrategy> forallOutputRaceStrategy,
+                        const map <IndexVar, MergeStrategy> forallMergeStrategy)
         : sortedVars(sortedVars), innerBody(innerBody),
-        forallParallelUnit(forallParallelUnit), forallOutputRaceStrategy(forallOutputRaceStrategy)  {
+        forallParallelUnit(forallParallelUnit), forallOutputRaceStrategy(forallOutputRaceStrategy),
+        forallMergeStrategy(forallMergeStrategy)  {
     }
 
     void visit(const ForallNode* node) {
@@ -894,14 +985,16 @@ IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
       taco_iassert(util::contains(sortedVars, i));
       stmt = innerBody;
       for (auto it = sortedVars.rbegin(); it != sortedVars.rend(); ++it) {
-        stmt = forall(*it, stmt, forallParallelUnit.at(*it), forallOutputRaceStrategy.at(*it), foralli.getUnrollFactor());
+        stmt = forall(*it, stmt, forallParallelUnit.at(*it), forallOutputRaceStrategy.at(*it), foralli.getUnrollFactor(),
+                      forallMergeStrategy.at(*it));
       }
       return;
     }
 
   };
   TopoReorderRewriter rewriter(sortedVars, dagBuilder.innerBody, 
-                               dagBuilder.forallParallelUnit, dagBuilder.forallOutputRaceStrategy);
+                               dagBuilder.forallParallelUnit, dagBuilder.forallOutputRaceStrategy,
+                               dagBuilder.forallMergeStrategy);
   return rewriter.rewrite(stmt);
 }
 
@@ -1034,7 +1127,8 @@ IndexStmt scalarPromote(IndexStmt stmt, ProvenanceGraph provGraph,
       }
 
       stmt = forall(i, body, foralli.getParallelUnit(),
-                    foralli.getOutputRaceStrategy(), foralli.getUnrollFactor());
+                    foralli.getOutputRaceStrategy(), foralli.getUnrollFactor(),
+                    foralli.getMergeStrategy());
       for (const auto& consumer : consumers) {
         stmt = where(consumer, stmt);
       }
@@ -1052,8 +1146,44 @@ static bool compare(std::vector<IndexVar> vars1, std::vector<IndexVar> vars2) {
   return vars1 == vars2;
 }
 
+/// Workspaces at least this large are hashed if they are expected to be
+/// sparsely filled.
+static const size_t MIN_HASHED_WORKSPACE_SIZE = 1 << 16;
+
+/// Workspaces are sparsely filled if they are expected to hold at most one in
+/// this many of their components.
+static const size_t HASHED_WORKSPACE_SPARSITY = 16;
+
+/// Returns the format of a workspace of `size` components that is expected
+/// to hold `fill` nonzeros: a hash table with room for twice the expected
+/// nonzeros if the workspace is large and sparsely filled, and dense otherwise.
+static Format getWorkspaceFormat(size_t size, double fill) {
+  if (size < MIN_HASHED_WORKSPACE_SIZE ||
+      fill * HASHED_WORKSPACE_SPARSITY > size) {
+    return dense;
+  }
+  int tableSize = 16;
+  while (tableSize < 2 * fill) {
+    tableSize *= 2;
+  }
+  return Format({ModeFormat(std::make_shared<HashedModeFormat>(tableSize))});
+}
+
+/// Returns the expected number of nonzeros in each row of a matrix, or a
+/// negative number if it is not known.
+static double getRowFill(TensorVar matrix,
+                         const std::map<TensorVar,size_t>& nonzeros) {
+  Dimension rows = matrix.getType().getShape().getDimension(0);
+  if (!util::contains(nonzeros, matrix) || !rows.isFixed() ||
+      rows.getSize() == 0) {
+    return -1.0;
+  }
+  return (double)nonzeros.at(matrix) / rows.getSize();
+}
+
 // TODO Temporary function to insert workspaces into SpMM kernels
-static IndexStmt optimizeSpMM(IndexStmt stmt) {
+static IndexStmt optimizeSpMM(IndexStmt stmt,
+                              const std::map<TensorVar,size_t>& nonzeros) {
   if (!isa<Forall>(stmt)) {
     return stmt;
   }
@@ -1130,11 +1260,17 @@ static IndexStmt optimizeSpMM(IndexStmt stmt) {
     return stmt;
   }
 
-  // It's an SpMM statement so return an optimized SpMM statement
-  TensorVar w("w",
-              Type(A.getType().getDataType(), 
-              {A.getType().getShape().getDimension(1)}),
-              taco::dense);
+  // It's an SpMM statement so return an optimized SpMM statement, whose
+  // workspace is hashed if the rows of A are long and the products of the
+  // rows of B and C are expected to fill few of their components
+  Dimension columns = A.getType().getShape().getDimension(1);
+  Format format = taco::dense;
+  double rowFillB = getRowFill(B, nonzeros);
+  double rowFillC = getRowFill(C, nonzeros);
+  if (columns.isFixed() && rowFillB >= 0 && rowFillC >= 0) {
+    format = getWorkspaceFormat(columns.getSize(), rowFillB * rowFillC);
+  }
+  TensorVar w("w", Type(A.getType().getDataType(), {columns}), format);
   return forall(i,
                 where(forall(j,
                              A(i,j) = w(j)),
@@ -1143,9 +1279,10 @@ static IndexStmt optimizeSpMM(IndexStmt stmt) {
                                     w(j) += B(i,k) * C(k,j)))));
 }
 
-IndexStmt insertTemporaries(IndexStmt stmt)
+IndexStmt insertTemporaries(IndexStmt stmt,
+                            const std::map<TensorVar,size_t>& nonzeros)
 {
-  IndexStmt spmm = optimizeSpMM(stmt);
+  IndexStmt spmm = optimizeSpMM(stmt, nonzeros);
   if (spmm != stmt) {
     return spmm;
   }
@@ -801,6 +801,11 @@ Stmt Print::make(std::string fmt, std::vector<Expr> params) {
   
 Expr GetProperty::make(Expr tensor, TensorProperty property, int mode,
                        int index, std::string name) {
+  return make(tensor, property, mode, index, name, Int());
+}
+
+Expr GetProperty::make(Expr tensor, TensorProperty property, int mode,
+                       int index, std::string name, Datatype type) {
   GetProperty* gp = new GetProperty;
   gp->tensor = tensor;
   gp->property = property;
@@ -811,6 +816,8 @@ Expr GetProperty::make(Expr tensor, TensorProperty property, int mode,
   //TODO: deal with the fact that some of these are pointers
   if (property == TensorProperty::Values)
     gp->type = tensor.type();
+  else if (property == TensorProperty::Indices)
+    gp->type = type;
   else
     gp->type = Int();
   
@@ -1,6 +1,7 @@
 #include "ir_generators.h"
 
 #include "taco/ir/ir.h"
+#include "taco/cuda.h"
 #include "taco/error.h"
 #include "taco/util/strings.h"
 
@@ -37,7 +38,7 @@ Stmt doubleSizeIfFull(Expr a, Expr size, Expr needed) {
 }
 
 Stmt atLeastDoubleSizeIfFull(Expr a, Expr size, Expr needed) {
-  Expr newSizeVar = Var::make(util::toString(a) + "_new_size", Int());
+  Expr newSizeVar = Var::make(util::toString(a) + "_new_size", size.type());
   Expr newSize = Max::make(Mul::make(size, 2), Add::make(needed, 1));
   Stmt computeNewSize = VarDecl::make(newSizeVar, newSize);
   Stmt realloc = Allocate::make(a, newSizeVar, true, size);
@@ -46,4 +47,34 @@ Stmt atLeastDoubleSizeIfFull(Expr a, Expr size, Expr needed) {
   return IfThenElse::make(Lte::make(size, needed), ifBody);
 }
 
+/// Returns the suffix of the runtime search functions for arrays with elements
+/// of the given type, which the runtime header defines for these types only.
+static bool getSearchFunctionSuffix(Datatype arrayType, std::string* suffix) {
+  switch (arrayType.getKind()) {
+    case Datatype::Int32:  *suffix = "";        return true;
+    case Datatype::UInt8:  *suffix = "_uint8";  return true;
+    case Datatype::UInt16: *suffix = "_uint16"; return true;
+    case Datatype::Int64:  *suffix = "_int64";  return true;
+    default:               return false;
+  }
+}
+
+bool hasSearchFunctions(Datatype arrayType) {
+  std::string suffix;
+  // The CUDA runtime only searches int arrays
+  return getSearchFunctionSuffix(arrayType, &suffix) &&
+         (!should_use_CUDA_codegen() || suffix.empty());
+}
+
+Expr callSearchFunction(std::string name, std::vector<Expr> args,
+                        Datatype type) {
+  taco_iassert(!args.empty());
+  Datatype arrayType = args[0].type();
+  taco_uassert(hasSearchFunctions(arrayType))
+      << "Index arrays of type " << arrayType << " cannot be searched";
+  std::string suffix;
+  getSearchFunctionSuffix(arrayType, &suffix);
+  return Call::make(name + suffix, args, type);
+}
+
 }}
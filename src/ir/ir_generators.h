@@ -1,8 +1,10 @@
 #ifndef TACO_IR_CODEGEN_H
 #define TACO_IR_CODEGEN_H
 
+#include <string>
 #include <vector>
 #include "taco/ir_tags.h"
+#include "taco/type.h"
 
 namespace taco {
 
@@ -27,5 +29,15 @@ Stmt doubleSizeIfFull(Expr a, Expr size, Expr loc);
 /// least equal to `loc` if it is full (loc cannot be written to).
 Stmt atLeastDoubleSizeIfFull(Expr a, Expr size, Expr loc);
 
+/// True if the runtime functions that search sorted index arrays
+/// (taco_binarySearchAfter, taco_binarySearchBefore and taco_intersectAdvance)
+/// support arrays with elements of the given type.
+bool hasSearchFunctions(Datatype arrayType);
+
+/// Generate a call to the runtime function `name` that searches the sorted
+/// index array `args[0]`, specialized to the type of the array's elements.
+Expr callSearchFunction(std::string name, std::vector<Expr> args,
+                        Datatype type);
+
 }}
 #endif
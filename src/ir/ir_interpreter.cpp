@@ -0,0 +1,1055 @@
+#include "taco/ir/ir_interpreter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "taco/ir/ir_visitor.h"
+#include "taco/taco_tensor_t.h"
+#include "taco/error.h"
+#include "taco/util/collections.h"
+#include "taco/util/hash.h"
+
+using namespace std;
+
+namespace taco {
+namespace ir {
+
+namespace {
+
+/// A scalar or pointer value computed by the interpreter. Integers are held
+/// in 64 bits and floating point numbers in double precision, and results are
+/// rounded to the type of the IR node that computed them.
+struct Value {
+  enum Kind {Int, UInt, Float, Complex, Pointer};
+
+  Kind kind;
+  union {
+    int64_t i;
+    uint64_t u;
+    double f;
+    void* p;
+  };
+  complex<double> c;
+
+  Value() : kind(Int), i(0) {}
+
+  static Value makeInt(int64_t i) {
+    Value v;
+    v.kind = Int;
+    v.i = i;
+    return v;
+  }
+
+  static Value makeUInt(uint64_t u) {
+    Value v;
+    v.kind = UInt;
+    v.u = u;
+    return v;
+  }
+
+  static Value makeFloat(double f) {
+    Value v;
+    v.kind = Float;
+    v.f = f;
+    return v;
+  }
+
+  static Value makeComplex(complex<double> c) {
+    Value v;
+    v.kind = Complex;
+    v.c = c;
+    return v;
+  }
+
+  static Value makePointer(void* p) {
+    Value v;
+    v.kind = Pointer;
+    v.p = p;
+    return v;
+  }
+
+  int64_t toInt() const {
+    switch (kind) {
+      case Int:     return i;
+      case UInt:    return (int64_t)u;
+      case Float:   return (int64_t)f;
+      case Complex: return (int64_t)c.real();
+      case Pointer: return (int64_t)(intptr_t)p;
+    }
+    return 0;
+  }
+
+  uint64_t toUInt() const {
+    switch (kind) {
+      case Int:     return (uint64_t)i;
+      case UInt:    return u;
+      case Float:   return (uint64_t)f;
+      case Complex: return (uint64_t)c.real();
+      case Pointer: return (uint64_t)(uintptr_t)p;
+    }
+    return 0;
+  }
+
+  double toFloat() const {
+    switch (kind) {
+      case Int:     return (double)i;
+      case UInt:    return (double)u;
+      case Float:   return f;
+      case Complex: return c.real();
+      case Pointer: taco_ierror << "Pointer used as a number";
+    }
+    return 0.0;
+  }
+
+  complex<double> toComplex() const {
+    return (kind == Complex) ? c : complex<double>(toFloat(), 0.0);
+  }
+
+  void* toPointer() const {
+    switch (kind) {
+      case Int:     return (void*)(intptr_t)i;
+      case UInt:    return (void*)(uintptr_t)u;
+      case Pointer: return p;
+      default:      taco_ierror << "Number used as a pointer";
+    }
+    return nullptr;
+  }
+
+  bool toBool() const {
+    switch (kind) {
+      case Int:     return i != 0;
+      case UInt:    return u != 0;
+      case Float:   return f != 0.0;
+      case Complex: return c != complex<double>(0.0, 0.0);
+      case Pointer: return p != nullptr;
+    }
+    return false;
+  }
+};
+
+/// Convert a value to a scalar type, with the semantics of a C cast.
+Value cast(const Value& v, Datatype type) {
+  switch (type.getKind()) {
+    case Datatype::Bool:       return Value::makeInt(v.toBool());
+    case Datatype::UInt8:      return Value::makeUInt((uint8_t)v.toUInt());
+    case Datatype::UInt16:     return Value::makeUInt((uint16_t)v.toUInt());
+    case Datatype::UInt32:     return Value::makeUInt((uint32_t)v.toUInt());
+    case Datatype::UInt64:     return Value::makeUInt(v.toUInt());
+    case Datatype::Int8:       return Value::makeInt((int8_t)v.toInt());
+    case Datatype::Int16:      return Value::makeInt((int16_t)v.toInt());
+    case Datatype::Int32:      return Value::makeInt((int32_t)v.toInt());
+    case Datatype::Int64:      return Value::makeInt(v.toInt());
+    case Datatype::Float32:    return Value::makeFloat((float)v.toFloat());
+    case Datatype::Float64:    return Value::makeFloat(v.toFloat());
+    case Datatype::Complex64:
+      return Value::makeComplex(complex<float>(v.toComplex()));
+    case Datatype::Complex128: return Value::makeComplex(v.toComplex());
+    default:
+      taco_not_supported_yet << " (interpreting values of type " << type
+                             << ")";
+  }
+  return v;
+}
+
+Value load(const void* arr, int64_t loc, Datatype type) {
+  switch (type.getKind()) {
+    case Datatype::Bool:
+      return Value::makeInt(((const bool*)arr)[loc]);
+    case Datatype::UInt8:
+      return Value::makeUInt(((const uint8_t*)arr)[loc]);
+    case Datatype::UInt16:
+      return Value::makeUInt(((const uint16_t*)arr)[loc]);
+    case Datatype::UInt32:
+      return Value::makeUInt(((const uint32_t*)arr)[loc]);
+    case Datatype::UInt64:
+      return Value::makeUInt(((const uint64_t*)arr)[loc]);
+    case Datatype::Int8:
+      return Value::makeInt(((const int8_t*)arr)[loc]);
+    case Datatype::Int16:
+      return Value::makeInt(((const int16_t*)arr)[loc]);
+    case Datatype::Int32:
+      return Value::makeInt(((const int32_t*)arr)[loc]);
+    case Datatype::Int64:
+      return Value::makeInt(((const int64_t*)arr)[loc]);
+    case Datatype::Float32:
+      return Value::makeFloat(((const float*)arr)[loc]);
+    case Datatype::Float64:
+      return Value::makeFloat(((const double*)arr)[loc]);
+    case Datatype::Complex64:
+      return Value::makeComplex(((const complex<float>*)arr)[loc]);
+    case Datatype::Complex128:
+      return Value::makeComplex(((const complex<double>*)arr)[loc]);
+    default:
+      taco_not_supported_yet << " (interpreting values of type " << type
+                             << ")";
+  }
+  return Value();
+}
+
+void store(void* arr, int64_t loc, Datatype type, const Value& v) {
+  const Value value = cast(v, type);
+  switch (type.getKind()) {
+    case Datatype::Bool:
+      ((bool*)arr)[loc] = value.toBool();
+      break;
+    case Datatype::UInt8:
+      ((uint8_t*)arr)[loc] = (uint8_t)value.u;
+      break;
+    case Datatype::UInt16:
+      ((uint16_t*)arr)[loc] = (uint16_t)value.u;
+      break;
+    case Datatype::UInt32:
+      ((uint32_t*)arr)[loc] = (uint32_t)value.u;
+      break;
+    case Datatype::UInt64:
+      ((uint64_t*)arr)[loc] = value.u;
+      break;
+    case Datatype::Int8:
+      ((int8_t*)arr)[loc] = (int8_t)value.i;
+      break;
+    case Datatype::Int16:
+      ((int16_t*)arr)[loc] = (int16_t)value.i;
+      break;
+    case Datatype::Int32:
+      ((int32_t*)arr)[loc] = (int32_t)value.i;
+      break;
+    case Datatype::Int64:
+      ((int64_t*)arr)[loc] = value.i;
+      break;
+    case Datatype::Float32:
+      ((float*)arr)[loc] = (float)value.f;
+      break;
+    case Datatype::Float64:
+      ((double*)arr)[loc] = value.f;
+      break;
+    case Datatype::Complex64:
+      ((complex<float>*)arr)[loc] = complex<float>(value.c);
+      break;
+    case Datatype::Complex128:
+      ((complex<double>*)arr)[loc] = value.c;
+      break;
+    default:
+      taco_not_supported_yet << " (interpreting values of type " << type
+                             << ")";
+  }
+}
+
+/// Apply an arithmetic operator in the domain of `type` and round the result
+/// to `type`, like C does for operands that were converted to `type`.
+template <typename Op>
+Value arithmetic(Datatype type, const Value& a, const Value& b, Op op) {
+  if (type.isComplex()) {
+    return cast(Value::makeComplex(op(a.toComplex(), b.toComplex())), type);
+  }
+  if (type.isFloat()) {
+    return cast(Value::makeFloat(op(a.toFloat(), b.toFloat())), type);
+  }
+  if (type.isUInt()) {
+    return cast(Value::makeUInt(op(a.toUInt(), b.toUInt())), type);
+  }
+  return cast(Value::makeInt(op(a.toInt(), b.toInt())), type);
+}
+
+/// Apply an integer operator and round the result to `type`.
+template <typename Op>
+Value integerArithmetic(Datatype type, const Value& a, const Value& b, Op op) {
+  taco_iassert(type.isInt() || type.isUInt() || type.isBool());
+  if (type.isUInt()) {
+    return cast(Value::makeUInt(op(a.toUInt(), b.toUInt())), type);
+  }
+  return cast(Value::makeInt(op(a.toInt(), b.toInt())), type);
+}
+
+/// Compare two real values after promoting them to a common type.
+template <typename Op>
+bool compare(const Value& a, const Value& b, Op op) {
+  if (a.kind == Value::Float || b.kind == Value::Float) {
+    return op(a.toFloat(), b.toFloat());
+  }
+  if (a.kind == Value::UInt && b.kind == Value::UInt) {
+    return op(a.toUInt(), b.toUInt());
+  }
+  return op(a.toInt(), b.toInt());
+}
+
+bool equals(const Value& a, const Value& b) {
+  if (a.kind == Value::Complex || b.kind == Value::Complex) {
+    return a.toComplex() == b.toComplex();
+  }
+  return compare(a, b, [](auto x, auto y) { return x == y; });
+}
+
+bool isPointer(const Expr& e) {
+  if (const Var* var = e.as<Var>()) {
+    return var->is_ptr || var->is_tensor;
+  }
+  if (const GetProperty* property = e.as<GetProperty>()) {
+    return property->property == TensorProperty::Values ||
+           property->property == TensorProperty::Indices;
+  }
+  return false;
+}
+
+template <typename T>
+int64_t binarySearchAfter(const T* array, int64_t arrayStart,
+                          int64_t arrayEnd, int64_t target) {
+  if (array[arrayStart] >= target) {
+    return arrayStart;
+  }
+  int64_t lowerBound = arrayStart;
+  int64_t upperBound = arrayEnd;
+  while (upperBound - lowerBound > 1) {
+    int64_t mid = (upperBound + lowerBound) / 2;
+    int64_t midValue = array[mid];
+    if (midValue < target) {
+      lowerBound = mid;
+    }
+    else if (midValue > target) {
+      upperBound = mid;
+    }
+    else {
+      return mid;
+    }
+  }
+  return upperBound;
+}
+
+template <typename T>
+int64_t binarySearchBefore(const T* array, int64_t arrayStart,
+                           int64_t arrayEnd, int64_t target) {
+  if (array[arrayEnd] <= target) {
+    return arrayEnd;
+  }
+  int64_t lowerBound = arrayStart;
+  int64_t upperBound = arrayEnd;
+  while (upperBound - lowerBound > 1) {
+    int64_t mid = (upperBound + lowerBound) / 2;
+    int64_t midValue = array[mid];
+    if (midValue < target) {
+      lowerBound = mid;
+    }
+    else if (midValue > target) {
+      upperBound = mid;
+    }
+    else {
+      return mid;
+    }
+  }
+  return lowerBound;
+}
+
+int hashLookup(const int* keys, int capacity, int shift, int coord) {
+  int slot = util::fibonacciHash(coord, shift);
+  while (keys[slot] != coord) {
+    if (keys[slot] < 0) {
+      return capacity;
+    }
+    slot = (slot + 1) & (capacity - 1);
+  }
+  return slot;
+}
+
+/// An external function that generated code may call.
+typedef Value (*Intrinsic)(const vector<Value>& args);
+
+template <double (*F)(double)>
+Value realFunction(const vector<Value>& args) {
+  return Value::makeFloat(F(args[0].toFloat()));
+}
+
+template <float (*F)(float)>
+Value floatFunction(const vector<Value>& args) {
+  return Value::makeFloat(F((float)args[0].toFloat()));
+}
+
+template <double (*F)(double,double)>
+Value realFunction2(const vector<Value>& args) {
+  return Value::makeFloat(F(args[0].toFloat(), args[1].toFloat()));
+}
+
+template <float (*F)(float,float)>
+Value floatFunction2(const vector<Value>& args) {
+  return Value::makeFloat(F((float)args[0].toFloat(),
+                            (float)args[1].toFloat()));
+}
+
+template <typename T, complex<T> (*F)(const complex<T>&)>
+Value complexFunction(const vector<Value>& args) {
+  return Value::makeComplex(F(complex<T>(args[0].toComplex())));
+}
+
+template <typename T>
+Value complexAbs(const vector<Value>& args) {
+  return Value::makeFloat(abs(complex<T>(args[0].toComplex())));
+}
+
+template <typename T>
+Value complexPow(const vector<Value>& args) {
+  return Value::makeComplex(pow(complex<T>(args[0].toComplex()),
+                                complex<T>(args[1].toComplex())));
+}
+
+Value intAbs(const vector<Value>& args) {
+  return Value::makeInt(llabs(args[0].toInt()));
+}
+
+template <typename T>
+Value binarySearchAfter(const vector<Value>& args) {
+  return Value::makeInt(binarySearchAfter((const T*)args[0].toPointer(),
+                                          args[1].toInt(),
+                                          args[2].toInt(),
+                                          args[3].toInt()));
+}
+
+template <typename T>
+Value binarySearchBefore(const vector<Value>& args) {
+  return Value::makeInt(binarySearchBefore((const T*)args[0].toPointer(),
+                                           args[1].toInt(),
+                                           args[2].toInt(),
+                                           args[3].toInt()));
+}
+
+Value hash(const vector<Value>& args) {
+  return Value::makeInt(util::fibonacciHash((int)args[0].toInt(),
+                                             (int)args[1].toInt()));
+}
+
+Value hashLookup(const vector<Value>& args) {
+  return Value::makeInt(hashLookup((const int*)args[0].toPointer(),
+                                   (int)args[1].toInt(),
+                                   (int)args[2].toInt(),
+                                   (int)args[3].toInt()));
+}
+
+Value sortCoordinates(const vector<Value>& args) {
+  int* coords = (int*)args[0].toPointer();
+  int size = (int)args[1].toInt();
+  std::sort(coords, coords + size);
+  return Value::makeInt(size);
+}
+
+template <typename T>
+Value intersectAdvance(const vector<Value>& args) {
+  const T* crd = (const T*)args[0].toPointer();
+  int64_t pos = args[1].toInt();
+  int64_t end = args[2].toInt();
+  int64_t target = args[3].toInt();
+  return Value::makeInt(std::lower_bound(crd + pos, crd + end, target,
+                                         [](T c, int64_t target) {
+                                           return (int64_t)c < target;
+                                         }) - crd);
+}
+
+/// Interpreted kernels run on a single thread.
+Value numThreads(const vector<Value>& args) {
+  return Value::makeInt(1);
+}
+
+Value threadId(const vector<Value>& args) {
+  return Value::makeInt(0);
+}
+
+const map<string,Intrinsic>& getIntrinsics() {
+#define TACO_REAL_INTRINSIC(fn) \
+    {#fn, realFunction<::fn>}, {#fn "f", floatFunction<::fn##f>}
+#define TACO_COMPLEX_INTRINSIC(fn) \
+    {"c" #fn, complexFunction<double, std::fn<double>>}, \
+    {"c" #fn "f", complexFunction<float, std::fn<float>>}
+#define TACO_SEARCH_INTRINSICS(suffix, T) \
+    {"taco_binarySearchAfter" suffix,  binarySearchAfter<T>}, \
+    {"taco_binarySearchBefore" suffix, binarySearchBefore<T>}, \
+    {"taco_intersectAdvance" suffix,   intersectAdvance<T>}
+  static const map<string,Intrinsic> intrinsics = {
+    TACO_REAL_INTRINSIC(sqrt),  TACO_COMPLEX_INTRINSIC(sqrt),
+    TACO_REAL_INTRINSIC(exp),   TACO_COMPLEX_INTRINSIC(exp),
+    TACO_REAL_INTRINSIC(log),   TACO_COMPLEX_INTRINSIC(log),
+    TACO_REAL_INTRINSIC(sin),   TACO_COMPLEX_INTRINSIC(sin),
+    TACO_REAL_INTRINSIC(cos),   TACO_COMPLEX_INTRINSIC(cos),
+    TACO_REAL_INTRINSIC(tan),   TACO_COMPLEX_INTRINSIC(tan),
+    TACO_REAL_INTRINSIC(asin),  TACO_COMPLEX_INTRINSIC(asin),
+    TACO_REAL_INTRINSIC(acos),  TACO_COMPLEX_INTRINSIC(acos),
+    TACO_REAL_INTRINSIC(atan),  TACO_COMPLEX_INTRINSIC(atan),
+    TACO_REAL_INTRINSIC(sinh),  TACO_COMPLEX_INTRINSIC(sinh),
+    TACO_REAL_INTRINSIC(cosh),  TACO_COMPLEX_INTRINSIC(cosh),
+    TACO_REAL_INTRINSIC(tanh),  TACO_COMPLEX_INTRINSIC(tanh),
+    TACO_REAL_INTRINSIC(asinh), TACO_COMPLEX_INTRINSIC(asinh),
+    TACO_REAL_INTRINSIC(acosh), TACO_COMPLEX_INTRINSIC(acosh),
+    TACO_REAL_INTRINSIC(atanh), TACO_COMPLEX_INTRINSIC(atanh),
+    TACO_REAL_INTRINSIC(cbrt),
+    {"fabs",  realFunction<::fabs>},
+    {"fabsf", floatFunction<::fabsf>},
+    {"cabs",  complexAbs<double>},
+    {"cabsf", complexAbs<float>},
+    {"abs",   intAbs},
+    {"labs",  intAbs},
+    {"pow",   realFunction2<::pow>},
+    {"powf",  floatFunction2<::powf>},
+    {"cpow",  complexPow<double>},
+    {"cpowf", complexPow<float>},
+    {"fmod",  realFunction2<::fmod>},
+    {"fmodf", floatFunction2<::fmodf>},
+    TACO_SEARCH_INTRINSICS("", int),
+    TACO_SEARCH_INTRINSICS("_uint8", uint8_t),
+    TACO_SEARCH_INTRINSICS("_uint16", uint16_t),
+    TACO_SEARCH_INTRINSICS("_int64", int64_t),
+    {"TACO_HASH",               hash},
+    {"taco_hashLookup",         hashLookup},
+    {"taco_sortCoordinates",    sortCoordinates},
+    {"TACO_NUM_THREADS", numThreads},
+    {"TACO_THREAD_ID",   threadId}
+  };
+#undef TACO_REAL_INTRINSIC
+#undef TACO_COMPLEX_INTRINSIC
+#undef TACO_SEARCH_INTRINSICS
+  return intrinsics;
+}
+
+/// Executes a function by walking its IR.
+class Interpreter : public IRVisitorStrict {
+public:
+  int call(const Function* func, void** args) {
+    taco_uassert(func->getReturnType().second == Datatype())
+        << "Cannot interpret " << func->name << ", which yields results";
+
+    size_t i = 0;
+    for (auto& output : func->outputs) {
+      bind(output.as<Var>(), args[i++]);
+    }
+    for (auto& input : func->inputs) {
+      bind(input.as<Var>(), args[i++]);
+    }
+
+    exec(func->body);
+
+    // Write back the index and value arrays the function (re)allocated
+    for (auto& output : func->outputs) {
+      const Var* tensorVar = output.as<Var>();
+      if (!tensorVar->is_tensor) {
+        continue;
+      }
+      taco_tensor_t* tensor = (taco_tensor_t*)vars.at(tensorVar).toPointer();
+      for (auto& property : properties) {
+        if (get<0>(property.first) != tensorVar) {
+          continue;
+        }
+        const Value& value = property.second;
+        switch (get<1>(property.first)) {
+          case TensorProperty::Values:
+            tensor->vals = (uint8_t*)value.toPointer();
+            break;
+          case TensorProperty::ValuesSize:
+            tensor->vals_size = (int32_t)value.toInt();
+            break;
+          case TensorProperty::Indices:
+            tensor->indices[get<2>(property.first)][get<3>(property.first)] =
+                (uint8_t*)value.toPointer();
+            break;
+          default:
+            break;
+        }
+      }
+    }
+    return 0;
+  }
+
+private:
+  typedef tuple<const Var*,TensorProperty,int,int> PropertyKey;
+
+  Value value;
+  bool continuing = false;
+  unordered_map<const Var*,Value> vars;
+  map<PropertyKey,Value> properties;
+  unordered_map<const GetProperty*,Value*> propertySlots;
+  unordered_map<const Call*,Intrinsic> callees;
+
+  Value eval(const Expr& e) {
+    e.accept(this);
+    return value;
+  }
+
+  void exec(const Stmt& s) {
+    if (s.defined()) {
+      s.accept(this);
+    }
+  }
+
+  void bind(const Var* var, void* arg) {
+    vars[var] = (var->is_tensor || var->is_ptr)
+                ? Value::makePointer(arg)
+                : cast(Value::makeInt((int64_t)(intptr_t)arg), var->type);
+  }
+
+  Value& slot(const Var* var) {
+    auto it = vars.find(var);
+    taco_iassert(it != vars.end()) << var->name << " is used before it is set";
+    return it->second;
+  }
+
+  Value& slot(const GetProperty* op) {
+    auto cached = propertySlots.find(op);
+    if (cached != propertySlots.end()) {
+      return *cached->second;
+    }
+
+    const Var* tensorVar = op->tensor.as<Var>();
+    taco_iassert(tensorVar);
+    PropertyKey key(tensorVar, op->property, op->mode, op->index);
+    auto it = properties.find(key);
+    if (it == properties.end()) {
+      const taco_tensor_t* tensor =
+          (const taco_tensor_t*)slot(tensorVar).toPointer();
+      Value property;
+      switch (op->property) {
+        case TensorProperty::Order:
+          property = Value::makeInt(tensor->order);
+          break;
+        case TensorProperty::Dimension:
+          property = Value::makeInt(tensor->dimensions[op->mode]);
+          break;
+        case TensorProperty::ComponentSize:
+          property = Value::makeInt(tensor->csize);
+          break;
+        case TensorProperty::Indices:
+          property = Value::makePointer(tensor->indices[op->mode][op->index]);
+          break;
+        case TensorProperty::Values:
+          property = Value::makePointer(tensor->vals);
+          break;
+        case TensorProperty::ValuesSize:
+          property = Value::makeInt(tensor->vals_size);
+          break;
+        default:
+          taco_not_supported_yet << " (interpreting " << op->name << ")";
+      }
+      it = properties.insert({key, property}).first;
+    }
+    propertySlots.insert({op, &it->second});
+    return it->second;
+  }
+
+  Value& slot(const Expr& e) {
+    if (const Var* var = e.as<Var>()) {
+      return slot(var);
+    }
+    const GetProperty* property = e.as<GetProperty>();
+    taco_iassert(property) << "Cannot assign to " << e;
+    return slot(property);
+  }
+
+  void assign(const Expr& lhs, const Value& rhs) {
+    if (const Var* var = lhs.as<Var>()) {
+      // Declares the variable if it has not been assigned before
+      Value& v = vars[var];
+      v = isPointer(lhs) ? Value::makePointer(rhs.toPointer())
+                         : cast(rhs, lhs.type());
+      return;
+    }
+    slot(lhs) = isPointer(lhs) ? Value::makePointer(rhs.toPointer())
+                               : cast(rhs, lhs.type());
+  }
+
+  using IRVisitorStrict::visit;
+
+  void visit(const Literal* op) {
+    Datatype type = op->type;
+    if (type.isBool()) {
+      value = Value::makeInt(op->getBoolValue());
+    } else if (type.isUInt()) {
+      value = Value::makeUInt(op->getUIntValue());
+    } else if (type.isInt()) {
+      value = Value::makeInt(op->getIntValue());
+    } else if (type.isFloat()) {
+      value = Value::makeFloat(op->getFloatValue());
+    } else if (type.isComplex()) {
+      value = Value::makeComplex(op->getComplexValue());
+    } else {
+      taco_ierror << "Unsupported literal type: " << type;
+    }
+  }
+
+  void visit(const Var* op) {
+    value = slot(op);
+  }
+
+  void visit(const GetProperty* op) {
+    value = slot(op);
+  }
+
+  void visit(const Neg* op) {
+    Value a = eval(op->a);
+    value = arithmetic(op->type, Value::makeInt(0), a,
+                       [](auto x, auto y) { return x - y; });
+  }
+
+  void visit(const Sqrt* op) {
+    Value a = eval(op->a);
+    value = op->type.isComplex()
+            ? cast(Value::makeComplex(sqrt(a.toComplex())), op->type)
+            : cast(Value::makeFloat(sqrt(a.toFloat())), op->type);
+  }
+
+  void visit(const Add* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = arithmetic(op->type, a, b, [](auto x, auto y) { return x + y; });
+  }
+
+  void visit(const Sub* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = arithmetic(op->type, a, b, [](auto x, auto y) { return x - y; });
+  }
+
+  void visit(const Mul* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = arithmetic(op->type, a, b, [](auto x, auto y) { return x * y; });
+  }
+
+  void visit(const Div* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = arithmetic(op->type, a, b, [](auto x, auto y) { return x / y; });
+  }
+
+  void visit(const Rem* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    if (op->type.isFloat()) {
+      value = cast(Value::makeFloat(fmod(a.toFloat(), b.toFloat())), op->type);
+    } else {
+      value = integerArithmetic(op->type, a, b,
+                                [](auto x, auto y) { return x % y; });
+    }
+  }
+
+  void visit(const Min* op) {
+    Value result = eval(op->operands[0]);
+    for (size_t i = 1; i < op->operands.size(); ++i) {
+      Value operand = eval(op->operands[i]);
+      if (compare(operand, result, [](auto x, auto y) { return x < y; })) {
+        result = operand;
+      }
+    }
+    value = cast(result, op->type);
+  }
+
+  void visit(const Max* op) {
+    Value result = eval(op->operands[0]);
+    for (size_t i = 1; i < op->operands.size(); ++i) {
+      Value operand = eval(op->operands[i]);
+      if (compare(operand, result, [](auto x, auto y) { return x > y; })) {
+        result = operand;
+      }
+    }
+    value = cast(result, op->type);
+  }
+
+  void visit(const BitAnd* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = integerArithmetic(op->type, a, b,
+                              [](auto x, auto y) { return x & y; });
+  }
+
+  void visit(const BitOr* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = integerArithmetic(op->type, a, b,
+                              [](auto x, auto y) { return x | y; });
+  }
+
+  void visit(const Eq* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = Value::makeInt(equals(a, b));
+  }
+
+  void visit(const Neq* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = Value::makeInt(!equals(a, b));
+  }
+
+  void visit(const Gt* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = Value::makeInt(compare(a, b, [](auto x, auto y) { return x > y; }));
+  }
+
+  void visit(const Lt* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = Value::makeInt(compare(a, b, [](auto x, auto y) { return x < y; }));
+  }
+
+  void visit(const Gte* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = Value::makeInt(compare(a, b,
+                                   [](auto x, auto y) { return x >= y; }));
+  }
+
+  void visit(const Lte* op) {
+    Value a = eval(op->a);
+    Value b = eval(op->b);
+    value = Value::makeInt(compare(a, b,
+                                   [](auto x, auto y) { return x <= y; }));
+  }
+
+  void visit(const And* op) {
+    value = Value::makeInt(eval(op->a).toBool() && eval(op->b).toBool());
+  }
+
+  void visit(const Or* op) {
+    value = Value::makeInt(eval(op->a).toBool() || eval(op->b).toBool());
+  }
+
+  void visit(const Cast* op) {
+    value = cast(eval(op->a), op->type);
+  }
+
+  void visit(const Call* op) {
+    auto callee = callees.find(op);
+    if (callee == callees.end()) {
+      auto intrinsic = getIntrinsics().find(op->func);
+      taco_uassert(intrinsic != getIntrinsics().end())
+          << "Cannot interpret calls to " << op->func;
+      callee = callees.insert({op, intrinsic->second}).first;
+    }
+    vector<Value> args;
+    for (auto& arg : op->args) {
+      args.push_back(eval(arg));
+    }
+    value = cast(callee->second(args), op->type);
+  }
+
+  void visit(const Load* op) {
+    const void* arr = eval(op->arr).toPointer();
+    int64_t loc = eval(op->loc).toInt();
+    value = load(arr, loc, op->type);
+  }
+
+  void visit(const Malloc* op) {
+    value = Value::makePointer(malloc(eval(op->size).toUInt()));
+  }
+
+  void visit(const Sizeof* op) {
+    value = Value::makeUInt(op->sizeofType.getDataType().getNumBytes());
+  }
+
+  void visit(const Store* op) {
+    void* arr = eval(op->arr).toPointer();
+    int64_t loc = eval(op->loc).toInt();
+    Value data = eval(op->data);
+    store(arr, loc, op->arr.type(), data);
+  }
+
+  void visit(const IfThenElse* op) {
+    if (eval(op->cond).toBool()) {
+      exec(op->then);
+    } else {
+      exec(op->otherwise);
+    }
+  }
+
+  void visit(const Case* op) {
+    for (size_t i = 0; i < op->clauses.size(); ++i) {
+      const bool isElse = op->alwaysMatch && i == op->clauses.size() - 1;
+      if (isElse || eval(op->clauses[i].first).toBool()) {
+        exec(op->clauses[i].second);
+        return;
+      }
+    }
+  }
+
+  void visit(const Switch* op) {
+    Value control = eval(op->controlExpr);
+    for (auto& switchCase : op->cases) {
+      if (equals(eval(switchCase.first), control)) {
+        exec(switchCase.second);
+        return;
+      }
+    }
+  }
+
+  void visit(const For* op) {
+    const Var* var = op->var.as<Var>();
+    taco_iassert(var);
+    Value& iter = vars[var];
+    iter = cast(eval(op->start), var->type);
+    while (compare(iter, eval(op->end), [](auto x, auto y) { return x < y; })) {
+      exec(op->contents);
+      continuing = false;
+      Value increment = eval(op->increment);
+      iter = arithmetic(var->type, iter, increment,
+                        [](auto x, auto y) { return x + y; });
+    }
+  }
+
+  void visit(const While* op) {
+    while (eval(op->cond).toBool()) {
+      exec(op->contents);
+      continuing = false;
+    }
+  }
+
+  void visit(const Block* op) {
+    for (auto& stmt : op->contents) {
+      exec(stmt);
+      if (continuing) {
+        return;
+      }
+    }
+  }
+
+  void visit(const Scope* op) {
+    exec(op->scopedStmt);
+  }
+
+  void visit(const Function* op) {
+    taco_ierror << "Nested function " << op->name << " cannot be interpreted";
+  }
+
+  void visit(const VarDecl* op) {
+    assign(op->var, eval(op->rhs));
+  }
+
+  void visit(const Assign* op) {
+    assign(op->lhs, eval(op->rhs));
+  }
+
+  void visit(const Yield*) {
+    taco_ierror << "Cannot interpret coroutines";
+  }
+
+  void visit(const Allocate* op) {
+    size_t size = op->var.type().getNumBytes() *
+                  eval(op->num_elements).toUInt();
+    Value& ptr = slot(op->var);
+    ptr = Value::makePointer(op->is_realloc ? realloc(ptr.toPointer(), size)
+                                            : malloc(size));
+  }
+
+  void visit(const Free* op) {
+    free(eval(op->var).toPointer());
+  }
+
+  void visit(const Comment*) {
+  }
+
+  void visit(const BlankLine*) {
+  }
+
+  // Break statements are emitted as C `continue` statements
+  void visit(const Break*) {
+    continuing = true;
+  }
+
+  void visit(const Print* op) {
+    vector<Value> params;
+    for (auto& param : op->params) {
+      params.push_back(eval(param));
+    }
+
+    // Format each conversion on its own, so that every argument is passed to
+    // snprintf with the type its (rewritten) conversion specifier expects
+    const string& fmt = op->fmt;
+    string out;
+    size_t next = 0;
+    for (size_t i = 0; i < fmt.size(); ++i) {
+      if (fmt[i] != '%') {
+        out += fmt[i];
+        continue;
+      }
+      if (i + 1 < fmt.size() && fmt[i+1] == '%') {
+        out += '%';
+        ++i;
+        continue;
+      }
+      size_t end = fmt.find_first_of("diouxXeEfFgGcp", i+1);
+      taco_uassert(end != string::npos && next < params.size())
+          << "Malformed format string: " << fmt;
+      string spec;
+      for (size_t j = i; j < end; ++j) {
+        if (string("hlLqjzt").find(fmt[j]) == string::npos) {
+          spec += fmt[j];
+        }
+      }
+      const char conversion = fmt[end];
+      const Value& param = params[next++];
+      char buffer[128];
+      switch (conversion) {
+        case 'd': case 'i':
+          snprintf(buffer, sizeof(buffer), (spec + "lld").c_str(),
+                   (long long)param.toInt());
+          break;
+        case 'o': case 'u': case 'x': case 'X':
+          snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(),
+                   (unsigned long long)param.toUInt());
+          break;
+        case 'c':
+          snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(),
+                   (int)param.toInt());
+          break;
+        case 'p':
+          snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(),
+                   param.toPointer());
+          break;
+        default:
+          snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(),
+                   param.toFloat());
+          break;
+      }
+      out += buffer;
+      i = end;
+    }
+    fputs(out.c_str(), stdout);
+  }
+};
+
+} // anonymous namespace
+
+bool canInterpret(const Stmt& func) {
+  struct CheckInterpretable : public IRVisitor {
+    bool interpretable = true;
+
+    using IRVisitor::visit;
+
+    void visit(const Call* op) {
+      if (!util::contains(getIntrinsics(), op->func)) {
+        interpretable = false;
+      }
+      IRVisitor::visit(op);
+    }
+
+    void visit(const Yield*) {
+      interpretable = false;
+    }
+  };
+
+  const Function* function = func.as<Function>();
+  if (function == nullptr) {
+    return false;
+  }
+  CheckInterpretable checker;
+  function->body.accept(&checker);
+  return checker.interpretable;
+}
+
+int interpret(const Stmt& func, void** args) {
+  const Function* function = func.as<Function>();
+  taco_iassert(function) << "Can only interpret functions";
+  Interpreter interpreter;
+  return interpreter.call(function, args);
+}
+
+}}
@@ -69,9 +69,10 @@ Iterator::Iterator(IndexVar indexVar, Expr tensor, Mode mode, Iterator parent,
   if (useNameForPos) {
     posNamePrefix = name;
   }
-  content->posVar   = Var::make(name,            Int());
-  content->endVar   = Var::make("p" + modeName + "_end",   Int());
-  content->beginVar = Var::make("p" + modeName + "_begin", Int());
+  Datatype positionType = mode.getModePack().getPositionType();
+  content->posVar   = Var::make(name,                      positionType);
+  content->endVar   = Var::make("p" + modeName + "_end",   positionType);
+  content->beginVar = Var::make("p" + modeName + "_begin", positionType);
 
   content->coordVar = Var::make(name, Int());
   content->segendVar = Var::make(modeName + "_segend", Int());
@@ -319,6 +320,28 @@ Stmt Iterator::getAppendFinalizeLevel(const Expr& szPrev, const Expr& sz) const{
                                                               getMode());
 }
 
+bool Iterator::hasParallelAppend() const {
+  taco_iassert(defined());
+  if (isDimensionIterator()) return false;
+  return getMode().defined() &&
+         getMode().getModeFormat().impl->hasParallelAppend(getMode());
+}
+
+Expr Iterator::getAppendBegin(const Expr& pPrev) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->getAppendBegin(pPrev, getMode());
+}
+
+Stmt Iterator::getAppendScanLevel(const Expr& szPrev) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->getAppendScanLevel(szPrev, getMode());
+}
+
+Stmt Iterator::getAppendFillCoord(const Expr& p, const Expr& i) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->getAppendFillCoord(p, i, getMode());
+}
+
 bool Iterator::defined() const {
   return content != nullptr;
 }
@@ -450,9 +473,13 @@ Iterators::createAccessIterators(Access access, Format format, Expr tensorIR, Pr
     taco_iassert(modeTypePack.getModeFormats().size() > 0);
 
     int modeNumber = format.getModeOrdering()[level-1];
+    vector<Datatype> arrayTypes;
+    if ((size_t)level <= format.getLevelArrayTypes().size()) {
+      arrayTypes = format.getLevelArrayTypes()[level-1];
+    }
     ModePack modePack(modeTypePack.getModeFormats().size(),
                       modeTypePack.getModeFormats()[0], tensorIR,
-                      modeNumber, level);
+                      modeNumber, level, arrayTypes, format.getPositionType());
 
     int pos = 0;
     for (auto& modeType : modeTypePack.getModeFormats()) {
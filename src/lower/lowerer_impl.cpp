@@ -1,12 +1,15 @@
 #include <taco/lower/mode_format_compressed.h>
+#include "taco/lower/mode_format_bitmap.h"
 #include "taco/lower/lowerer_impl.h"
 
 #include "taco/index_notation/index_notation.h"
 #include "taco/index_notation/index_notation_nodes.h"
 #include "taco/index_notation/index_notation_visitor.h"
+#include "taco/index_notation/index_notation_rewriter.h"
 #include "taco/ir/ir.h"
 #include "ir/ir_generators.h"
 #include "taco/ir/ir_visitor.h"
+#include "taco/ir/ir_rewriter.h"
 #include "taco/ir/simplify.h"
 #include "taco/lower/iterator.h"
 #include "taco/lower/merge_lattice.h"
@@ -69,7 +72,9 @@ static void createCapacityVars(const map<TensorVar, Expr>& tensorVars,
                                map<Expr, Expr>* capacityVars) {
   for (auto& tensorVar : tensorVars) {
     Expr tensor = tensorVar.second;
-    Expr capacityVar = Var::make(util::toString(tensor) + "_capacity", Int());
+    Datatype positionType = tensorVar.first.getFormat().getPositionType();
+    Expr capacityVar = Var::make(util::toString(tensor) + "_capacity",
+                                 positionType);
     capacityVars->insert({tensor, capacityVar});
   }
 }
@@ -84,6 +89,48 @@ static void createReducedValueVars(const vector<Access>& inputAccesses,
   }
 }
 
+/// Returns true iff mode `mode` of `tensor` is stored as a tile.
+static bool isTileMode(const TensorVar& tensor, int mode) {
+  const Format& format = tensor.getFormat();
+  if (mode >= format.getOrder()) {
+    return false;
+  }
+  const auto& modeOrdering = format.getModeOrdering();
+  int level = (int)distance(modeOrdering.begin(),
+                            find(modeOrdering.begin(), modeOrdering.end(),
+                                 mode));
+  if (!format.getModeFormats()[level].hasFixedSize()) {
+    return false;
+  }
+  taco_uassert(tensor.getType().getShape().getDimension(mode).isFixed()) <<
+      "The size of tile mode " << mode << " of " << tensor.getName() <<
+      " must be fixed";
+  return true;
+}
+
+/// Returns true iff `stmt` contains a loop that is not unrolled.
+static bool hasRolledLoops(Stmt stmt) {
+  struct FindRolledLoops : IRVisitor {
+    bool hasRolledLoop;
+
+    using IRVisitor::visit;
+
+    void visit(const For* op) {
+      if (op->unrollFactor == 0) {
+        hasRolledLoop = true;
+      }
+      IRVisitor::visit(op);
+    }
+
+    bool hasRolledLoops(Stmt stmt) {
+      hasRolledLoop = false;
+      stmt.accept(this);
+      return hasRolledLoop;
+    }
+  };
+  return stmt.defined() && FindRolledLoops().hasRolledLoops(stmt);
+}
+
 /// Returns true iff `stmt` modifies an array
 static bool hasStores(Stmt stmt) {
   struct FindStores : IRVisitor {
@@ -104,6 +151,32 @@ static bool hasStores(Stmt stmt) {
   return stmt.defined() && FindStores().hasStores(stmt);
 }
 
+static bool hasAssignsTo(Stmt stmt, const vector<Iterator>& iterators) {
+  struct FindAssigns : IRVisitor {
+    set<Expr> posVars;
+    bool hasAssign;
+
+    using IRVisitor::visit;
+
+    void visit(const Assign* stmt) {
+      if (util::contains(posVars, stmt->lhs)) {
+        hasAssign = true;
+      }
+    }
+
+    bool hasAssigns(Stmt stmt) {
+      hasAssign = false;
+      stmt.accept(this);
+      return hasAssign;
+    }
+  };
+  FindAssigns findAssigns;
+  for (auto& iterator : iterators) {
+    findAssigns.posVars.insert(iterator.getPosVar());
+  }
+  return stmt.defined() && findAssigns.hasAssigns(stmt);
+}
+
 Stmt
 LowererImpl::lower(IndexStmt stmt, string name, 
                    bool assemble, bool compute, bool pack, bool unpack)
@@ -113,6 +186,37 @@ LowererImpl::lower(IndexStmt stmt, string name,
   definedIndexVarsOrdered = {};
   definedIndexVars = {};
 
+  // Lower hashed workspaces as dense workspaces whose accesses, assignments and
+  // consumer loops go through their hash tables instead
+  map<TensorVar,TensorVar> hashedTemporaries;
+  for (auto& temp : getTemporaries(stmt)) {
+    const vector<ModeFormat>& modeFormats = temp.getFormat().getModeFormats();
+    if (std::none_of(modeFormats.begin(), modeFormats.end(),
+                     [](ModeFormat m) { return m.getName() == Hashed.getName(); })) {
+      continue;
+    }
+    taco_uassert(temp.getOrder() == 1) <<
+        "Hashed workspaces must be vectors, but " << temp.getName() <<
+        " has order " << temp.getOrder();
+    taco_uassert(!should_use_CUDA_codegen()) <<
+        "Hashed workspaces are not supported on GPUs";
+    TensorVar denseTemp(temp.getName(), temp.getType(), taco::dense);
+    hashedTemporaries.insert({temp, denseTemp});
+
+    const string name = temp.getName();
+    HashedWorkspace workspace;
+    workspace.tableSize = modeFormats[0].getTableSize();
+    workspace.keys = Var::make(name + "_keys", Int32, true);
+    workspace.values = Var::make(name, temp.getType().getDataType(), true);
+    workspace.capacity = Var::make(name + "_capacity", Int32);
+    workspace.shift = Var::make(name + "_shift", Int32);
+    workspace.coords = Var::make(name + "_crd", Int32, true);
+    workspace.coordsCapacity = Var::make(name + "_crd_capacity", Int32);
+    workspace.size = Var::make(name + "_size", Int32);
+    hashedWorkspaces.insert({denseTemp, workspace});
+  }
+  stmt = replace(stmt, hashedTemporaries);
+
   // Create result and parameter variables
   vector<TensorVar> results = getResults(stmt);
   vector<TensorVar> arguments = getArguments(stmt);
@@ -165,6 +269,7 @@ LowererImpl::lower(IndexStmt stmt, string name,
   vector<IndexVar> indexVars = getIndexVars(stmt);
   for (auto& indexVar : indexVars) {
     Expr dimension;
+    Expr tileDimension;
     match(stmt,
       function<void(const AssignmentNode*, Matcher*)>([&](
           const AssignmentNode* n, Matcher* m) {
@@ -178,6 +283,17 @@ LowererImpl::lower(IndexStmt stmt, string name,
                                           TensorProperty::Dimension, loc);
           }
         }
+        if (!tileDimension.defined() && util::contains(n->lhs.getIndexVars(),
+                                                       indexVar)) {
+          auto ivars = n->lhs.getIndexVars();
+          int loc = (int)distance(ivars.begin(),
+                                  find(ivars.begin(),ivars.end(), indexVar));
+          if (isTileMode(n->lhs.getTensorVar(), loc)) {
+            tileIndexVars.insert(indexVar);
+            tileDimension = (int)n->lhs.getTensorVar().getType().getShape()
+                                                      .getDimension(loc).getSize();
+          }
+        }
       }),
       function<void(const AccessNode*)>([&](const AccessNode* n) {
         auto indexVars = n->indexVars;
@@ -189,9 +305,17 @@ LowererImpl::lower(IndexStmt stmt, string name,
             dimension = GetProperty::make(tensorVars.at(n->tensorVar),
                                           TensorProperty::Dimension, loc);
           }
+          if (isTileMode(n->tensorVar, loc)) {
+            tileIndexVars.insert(indexVar);
+            tileDimension = (int)n->tensorVar.getType().getShape()
+                                             .getDimension(loc).getSize();
+          }
         }
       })
     );
+    if (tileDimension.defined()) {
+      dimension = tileDimension;
+    }
     dimensions.insert({indexVar, dimension});
     underivedBounds.insert({indexVar, {ir::Literal::make(0), dimension}});
   }
@@ -265,6 +389,10 @@ Stmt LowererImpl::lowerAssignment(Assignment assignment)
 {
   TensorVar result = assignment.getLhs().getTensorVar();
 
+  if (util::contains(hashedWorkspaces, result)) {
+    return lowerHashedAssignment(assignment);
+  }
+
   if (generateComputeCode()) {
     Expr var = getTensorVar(result);
     Expr rhs = lower(assignment.getRhs());
@@ -414,6 +542,58 @@ Stmt LowererImpl::lowerForall(Forall forall)
                                         getArgumentAccesses(forall), 
                                         reducedAccesses);
 
+  // Start the positions of levels that are appended to in parallel at the
+  // positions that the count pass assigned to their parent positions
+  vector<Stmt> declAppendPositions;
+  if (appendPhase != AppendPhase::Serial) {
+    for (auto& appender : parallelAppenders) {
+      if (appender.getIndexVar() == forall.getIndexVar()) {
+        Expr begin = (appendPhase == AppendPhase::Count)
+                     ? Expr(0)
+                     : appender.getAppendBegin(appender.getParent().getPosVar());
+        declAppendPositions.push_back(VarDecl::make(appender.getPosVar(),
+                                                    begin));
+      }
+    }
+  }
+
+  Stmt loops;
+  vector<Iterator> appenders = getParallelAppenders(forall, lattice);
+  if (!appenders.empty()) {
+    loops = lowerForallAppendInParallel(forall, lattice, reducedAccesses,
+                                        recoveryStmt, appenders);
+  } else {
+    loops = lowerForallLoops(forall, lattice, reducedAccesses, recoveryStmt);
+  }
+
+  if (!generateComputeCode() && !hasStores(loops) &&
+      !hasAssignsTo(loops, parallelAppenders)) {
+    // If assembly loop does not modify output arrays or count coordinates,
+    // then it can be safely omitted.
+    loops = Stmt();
+  }
+  if (forall.getParallelUnit() == ParallelUnit::CPUThread &&
+      forall.getOutputRaceStrategy() == OutputRaceStrategy::Temporary &&
+      generateComputeCode() && !should_use_CUDA_codegen()) {
+    loops = privatizeResults(forall, resultAccesses, loops);
+  }
+
+  definedIndexVars.erase(forall.getIndexVar());
+  definedIndexVarsOrdered.pop_back();
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel) {
+    inParallelLoopDepth--;
+    taco_iassert(parallelUnitSizes.count(forall.getParallelUnit()));
+    taco_iassert(parallelUnitIndexVars.count(forall.getParallelUnit()));
+    parallelUnitIndexVars.erase(forall.getParallelUnit());
+    parallelUnitSizes.erase(forall.getParallelUnit());
+  }
+  return Block::blanks(Block::make(declAppendPositions), preInitValues,
+                       loops);
+}
+
+Stmt LowererImpl::lowerForallLoops(Forall forall, MergeLattice lattice,
+                                   set<Access> reducedAccesses,
+                                   Stmt recoveryStmt) {
   Stmt loops;
   // Emit a loop that iterates over over a single iterator (optimization)
   if (lattice.iterators().size() == 1 && lattice.iterators()[0].isUnique()) {
@@ -471,27 +651,234 @@ Stmt LowererImpl::lowerForall(Forall forall)
   else {
     std::vector<IndexVar> underivedAncestors = provGraph.getUnderivedAncestors(forall.getIndexVar());
     taco_iassert(underivedAncestors.size() == 1); // TODO: add support for fused coordinate of pos loop
-    loops = lowerMergeLattice(lattice, underivedAncestors[0],
-                              forall.getStmt(), reducedAccesses);
+    if (forall.getMergeStrategy() == MergeStrategy::BlockIntersect) {
+      loops = lowerBlockIntersection(lattice, underivedAncestors[0],
+                                     forall.getStmt(), reducedAccesses);
+    }
+    if (!loops.defined()) {
+      loops = lowerMergeLattice(lattice, underivedAncestors[0],
+                                forall.getStmt(), reducedAccesses);
+    }
   }
 //  taco_iassert(loops.defined());
+  return loops;
+}
 
-  if (!generateComputeCode() && !hasStores(loops)) {
-    // If assembly loop does not modify output arrays, then it can be safely 
-    // omitted.
-    loops = Stmt();
+Stmt LowererImpl::privatizeResults(Forall forall,
+                                   vector<Access> resultAccesses, Stmt loops) {
+  struct PrivatizeValues : IRRewriter {
+    using IRRewriter::visit;
+
+    /// Map from result tensors to their private values and to the offsets of
+    /// the running thread's copies
+    map<Expr, pair<Expr,Expr>> privateValues;
+    Stmt declOffsets;
+    bool declaredOffsets = false;
+
+    const pair<Expr,Expr>* getPrivateValues(Expr arr) {
+      const GetProperty* values = arr.as<GetProperty>();
+      if (values == nullptr || values->property != TensorProperty::Values ||
+          !util::contains(privateValues, values->tensor)) {
+        return nullptr;
+      }
+      return &privateValues.at(values->tensor);
+    }
+
+    void visit(const Load* op) {
+      const pair<Expr,Expr>* values = getPrivateValues(op->arr);
+      if (values == nullptr) {
+        IRRewriter::visit(op);
+        return;
+      }
+      expr = Load::make(values->first,
+                        ir::Add::make(values->second, rewrite(op->loc)));
+    }
+
+    void visit(const Store* op) {
+      const pair<Expr,Expr>* values = getPrivateValues(op->arr);
+      if (values == nullptr) {
+        IRRewriter::visit(op);
+        return;
+      }
+      stmt = Store::make(values->first,
+                         ir::Add::make(values->second, rewrite(op->loc)),
+                         rewrite(op->data));
+    }
+
+    void visit(const For* op) {
+      if (declaredOffsets || op->parallel_unit != ParallelUnit::CPUThread) {
+        IRRewriter::visit(op);
+        return;
+      }
+      declaredOffsets = true;
+      Stmt contents = Block::make(declOffsets, rewrite(op->contents));
+      stmt = For::make(op->var, op->start, op->end, op->increment, contents,
+                       op->kind, op->parallel_unit, op->unrollFactor,
+                       op->vec_width);
+    }
+  };
+
+  if (!loops.defined()) {
+    return loops;
+  }
+
+  // Results race if no iteration of the forall owns their components
+  vector<IndexVar> underivedVars =
+      provGraph.getUnderivedAncestors(forall.getIndexVar());
+  vector<Access> racingAccesses;
+  set<TensorVar> racingResults;
+  for (auto& access : resultAccesses) {
+    TensorVar result = access.getTensorVar();
+    bool races = (result.getOrder() > 0);
+    for (auto& indexVar : access.getIndexVars()) {
+      for (auto& underivedVar : provGraph.getUnderivedAncestors(indexVar)) {
+        if (util::contains(underivedVars, underivedVar)) {
+          races = false;
+        }
+      }
+    }
+    if (races && !util::contains(racingResults, result)) {
+      racingAccesses.push_back(access);
+      racingResults.insert(result);
+    }
   }
-  definedIndexVars.erase(forall.getIndexVar());
-  definedIndexVarsOrdered.pop_back();
-  if (forall.getParallelUnit() != ParallelUnit::NotParallel) {
-    inParallelLoopDepth--;
-    taco_iassert(parallelUnitSizes.count(forall.getParallelUnit()));
-    taco_iassert(parallelUnitIndexVars.count(forall.getParallelUnit()));
-    parallelUnitIndexVars.erase(forall.getParallelUnit());
-    parallelUnitSizes.erase(forall.getParallelUnit());
+  if (racingAccesses.empty()) {
+    return loops;
   }
-  return Block::blanks(preInitValues,
-                       loops);
+
+  Expr numThreads = Var::make("num_threads", Int());
+  Expr threadId = Call::make("TACO_THREAD_ID", {}, Int());
+
+  PrivatizeValues privatize;
+  vector<Stmt> initPrivate;
+  vector<Stmt> declOffsets;
+  vector<Stmt> reducePrivate;
+  initPrivate.push_back(VarDecl::make(numThreads,
+                                      Call::make("TACO_NUM_THREADS", {},
+                                                 Int())));
+  for (auto& access : racingAccesses) {
+    Expr tensor = getTensorVar(access.getTensorVar());
+    Expr values = GetProperty::make(tensor, TensorProperty::Values);
+    Datatype type = tensor.type();
+
+    Expr size = 1;
+    for (auto& iterator : getIterators(access)) {
+      taco_iassert(iterator.hasInsert());
+      size = ir::Mul::make(size, iterator.getWidth());
+    }
+    size = simplify(size);
+
+    std::string name = util::toString(tensor);
+    Expr privateValues = Var::make(name + "_vals_private", type, true, false);
+    Expr offset = Var::make(name + "_private_offset", Int());
+    privatize.privateValues.insert({tensor, {privateValues, offset}});
+    declOffsets.push_back(VarDecl::make(offset, ir::Mul::make(threadId, size)));
+
+    // Zero the private copies in parallel
+    Expr privateSize = ir::Mul::make(numThreads, size);
+    Expr p = Var::make("p" + name + "_private", Int());
+    initPrivate.push_back(VarDecl::make(privateValues, 0));
+    initPrivate.push_back(Allocate::make(privateValues, privateSize));
+    initPrivate.push_back(For::make(p, 0, privateSize, 1,
+                                    Store::make(privateValues, p,
+                                                ir::Literal::zero(type)),
+                                    LoopKind::Static_Chunked));
+
+    // Reduce the private copies into the result, with each thread reducing
+    // the copies of a range of components
+    Expr t = Var::make("t" + name, Int());
+    Expr privateValue = Load::make(privateValues,
+                                   ir::Add::make(ir::Mul::make(t, size), p));
+    Stmt reduce = Store::make(values, p, ir::Add::make(Load::make(values, p),
+                                                       privateValue));
+    reducePrivate.push_back(For::make(p, 0, size, 1,
+                                      For::make(t, 0, numThreads, 1, reduce),
+                                      LoopKind::Static_Chunked));
+    reducePrivate.push_back(Free::make(privateValues));
+  }
+  privatize.declOffsets = Block::make(declOffsets);
+
+  return Block::blanks(Block::make(initPrivate), privatize.rewrite(loops),
+                       Block::make(reducePrivate));
+}
+
+vector<Iterator> LowererImpl::getParallelAppenders(Forall forall,
+                                                   MergeLattice lattice) {
+  if (forall.getParallelUnit() != ParallelUnit::CPUThread ||
+      forall.getOutputRaceStrategy() != OutputRaceStrategy::NoRaces ||
+      definedIndexVarsOrdered.size() != 1 || ignoreVectorize ||
+      should_use_CUDA_codegen()) {
+    return {};
+  }
+
+  vector<Iterator> appenders;
+  for (Iterator iterator : lattice.results()) {
+    if (!iterator.getParent().isRoot()) {
+      continue;
+    }
+    while (!iterator.isLeaf() && iterator.hasInsert()) {
+      iterator = iterator.getChild();
+    }
+    if (iterator.isLeaf() && !iterator.hasInsert() &&
+        iterator.hasAppend() && iterator.hasParallelAppend()) {
+      appenders.push_back(iterator);
+    }
+  }
+  return appenders;
+}
+
+Stmt LowererImpl::lowerForallAppendInParallel(Forall forall,
+                                              MergeLattice lattice,
+                                              set<Access> reducedAccesses,
+                                              Stmt recoveryStmt,
+                                              vector<Iterator> appenders) {
+  taco_iassert(appendPhase == AppendPhase::Serial);
+  parallelAppenders = appenders;
+
+  Stmt countLoops;
+  Stmt scanPositions;
+  if (generateAssembleCode()) {
+    // Count the coordinates of each parent position without computing values
+    bool computeValues = compute;
+    compute = false;
+    appendPhase = AppendPhase::Count;
+    countLoops = lowerForallLoops(forall, lattice, reducedAccesses,
+                                  recoveryStmt);
+    compute = computeValues;
+
+    // Scan the counts into positions and size the levels to the positions
+    vector<Stmt> scans;
+    for (auto& appender : appenders) {
+      Expr parentSize = 1;
+      for (Iterator parent = appender.getParent(); !parent.isRoot();
+           parent = parent.getParent()) {
+        parentSize = ir::Mul::make(parentSize, parent.getWidth());
+      }
+      parentSize = simplify(parentSize);
+
+      Expr pos = appender.getPosVar();
+      scans.push_back(appender.getAppendScanLevel(parentSize));
+      scans.push_back(Assign::make(pos, appender.getAppendBegin(parentSize)));
+      if (generateComputeCode()) {
+        Expr values = GetProperty::make(appender.getTensor(),
+                                        TensorProperty::Values);
+        Expr capacity = getCapacityVar(appender.getTensor());
+        scans.push_back(Allocate::make(values, pos, true, capacity));
+        scans.push_back(Assign::make(capacity, pos));
+      }
+      scannedAppenders.insert(appender);
+    }
+    scanPositions = Block::make(scans);
+  }
+
+  // Append the coordinates and values from the positions of their parents
+  appendPhase = AppendPhase::Fill;
+  Stmt fillLoops = lowerForallLoops(forall, lattice, reducedAccesses,
+                                    recoveryStmt);
+
+  appendPhase = AppendPhase::Serial;
+  parallelAppenders.clear();
+  return Block::blanks(countLoops, scanPositions, fillLoops);
 }
 
 Stmt LowererImpl::lowerForallCloned(Forall forall) {
@@ -767,7 +1154,7 @@ Stmt LowererImpl::searchForFusedPositionStart(Forall forall, Iterator posIterato
     };
     Expr posVarUnknown = this->iterators.modeIterator(underivedAncestors[i]).getPosVar();
     searchForUnderivedStart.push_back(ir::VarDecl::make(posVarUnknown,
-                                                        ir::Call::make("taco_binarySearchBefore", binarySearchArgs,
+                                                        ir::callSearchFunction("taco_binarySearchBefore", binarySearchArgs,
                                                                        getCoordinateVar(underivedAncestors[i]).type())));
     Stmt locateCoordVar;
     if (posIteratorLevel.getParent().hasPosIter()) {
@@ -788,6 +1175,18 @@ Stmt LowererImpl::lowerForallDimension(Forall forall,
                                        set<Access> reducedAccesses,
                                        ir::Stmt recoveryStmt)
 {
+  Stmt bitmapLoops = lowerForallBitmap(forall, locators, inserters, appenders,
+                                       reducedAccesses, recoveryStmt);
+  if (bitmapLoops.defined()) {
+    return bitmapLoops;
+  }
+
+  Stmt hashedLoops = lowerForallHashed(forall, locators, inserters, appenders,
+                                       reducedAccesses, recoveryStmt);
+  if (hashedLoops.defined()) {
+    return hashedLoops;
+  }
+
   Expr coordinate = getCoordinateVar(forall.getIndexVar());
 
   if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
@@ -809,8 +1208,10 @@ Stmt LowererImpl::lowerForallDimension(Forall forall,
   // Emit loop with preamble and postamble
   std::vector<ir::Expr> bounds = provGraph.deriveIterBounds(forall.getIndexVar(), definedIndexVarsOrdered, underivedBounds, indexVarToExprMap, iterators);
 
+  // The guarded copies of vectorized loops that handle their partial vectors
+  // are vectorized too, with the guards masking out the missing lanes
   LoopKind kind = LoopKind::Serial;
-  if (forall.getParallelUnit() == ParallelUnit::CPUVector && !ignoreVectorize) {
+  if (forall.getParallelUnit() == ParallelUnit::CPUVector) {
     kind = LoopKind::Vectorized;
   }
   else if (forall.getParallelUnit() != ParallelUnit::NotParallel
@@ -818,9 +1219,232 @@ Stmt LowererImpl::lowerForallDimension(Forall forall,
     kind = LoopKind::Runtime;
   }
 
+  // Fully unroll the innermost loops over the small dense tiles of
+  // block-sparse tensors, which turns them into register-blocked micro-kernels
+  size_t unrollFactor = ignoreVectorize ? 0 : forall.getUnrollFactor();
+  if (unrollFactor == 0 && kind == LoopKind::Serial &&
+      util::contains(tileIndexVars, forall.getIndexVar()) &&
+      !hasRolledLoops(body) &&
+      isa<ir::Literal>(bounds[0]) && isa<ir::Literal>(bounds[1])) {
+    long long tripCount = to<ir::Literal>(bounds[1])->getIntValue() -
+                          to<ir::Literal>(bounds[0])->getIntValue();
+    if (tripCount > 1 && tripCount <= 16) {
+      unrollFactor = (size_t)tripCount;
+    }
+  }
+
   return Block::blanks(For::make(coordinate, bounds[0], bounds[1], 1, body,
                                  kind,
-                                 ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), ignoreVectorize ? 0 : forall.getUnrollFactor()),
+                                 ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), unrollFactor),
+                       posAppend);
+}
+
+
+Stmt LowererImpl::lowerForallBitmap(Forall forall,
+                                    vector<Iterator> locators,
+                                    vector<Iterator> inserters,
+                                    vector<Iterator> appenders,
+                                    set<Access> reducedAccesses,
+                                    ir::Stmt recoveryStmt)
+{
+  IndexVar indexVar = forall.getIndexVar();
+  if (forall.getParallelUnit() == ParallelUnit::CPUVector ||
+      !provGraph.isUnderived(indexVar) || provGraph.hasCoordBounds(indexVar)) {
+    return Stmt();
+  }
+
+  vector<Iterator> bitmaps = filter(locators, [this](Iterator it) {
+    return it.getMode().getModeFormat().getName() == Bitmap.getName() &&
+           (it.getParent().isRoot() ||
+            accessibleIterators.contains(it.getParent()));
+  });
+  if (bitmaps.empty()) {
+    return Stmt();
+  }
+
+  // The coordinates that contribute to the result are those in the
+  // intersection of the bitmaps of operands whose accesses zero the
+  // statement. If there are none, they are in the union of the bitmaps,
+  // provided the statement is zero where all the bitmap operands are.
+  IndexStmt stmt = forall.getStmt();
+  vector<Iterator> required;
+  set<Access> bitmapAccesses;
+  for (auto& bitmap : bitmaps) {
+    Access access = iterators.modeAccess(bitmap).getAccess();
+    bitmapAccesses.insert(access);
+    if (!zero(stmt, {access}).defined()) {
+      required.push_back(bitmap);
+    }
+  }
+  const bool intersect = !required.empty();
+  if (!intersect && zero(stmt, bitmapAccesses).defined()) {
+    return Stmt();
+  }
+
+  // Merge the bitmaps a word at a time
+  Expr coordinate = getCoordinateVar(indexVar);
+  Expr wordVar = Var::make("w" + util::toString(coordinate), Int());
+  Expr bitsVar = Var::make("bits" + util::toString(coordinate), UInt64);
+  Expr bitVar = Var::make("b" + util::toString(coordinate), Int());
+  const vector<Iterator>& merged = intersect ? required : bitmaps;
+  const BitmapModeFormat bitmapFormat;
+  Expr numWords = bitmapFormat.getNumWords(merged[0].getMode());
+  Expr bits;
+  vector<Stmt> declareWords;
+  for (auto& bitmap : merged) {
+    Expr parentPos = bitmap.getParent().getPosVar();
+    Expr word = Var::make(util::toString(bitmap.getPosVar()) + "_word",
+                          UInt64);
+    declareWords.push_back(VarDecl::make(word,
+        bitmapFormat.getWord(parentPos, wordVar, bitmap.getMode())));
+    declareWords.push_back(VarDecl::make(bitmap.getBeginVar(),
+        bitmapFormat.getRank(parentPos, wordVar, bitmap.getMode())));
+    bits = !bits.defined() ? word
+         : intersect ? ir::BitAnd::make(bits, word)
+                     : ir::BitOr::make(bits, word);
+
+    // Positions are ranked within the words already loaded, and a single
+    // bitmap's positions are consecutive
+    Expr pos = (merged.size() == 1)
+             ? bitmap.getBeginVar()
+             : ir::Add::make(bitmap.getBeginVar(),
+                             Call::make("TACO_RANK", {word, bitVar}, Int()));
+    Expr found = intersect ? ir::Literal::make(true)
+                           : Call::make("TACO_BIT", {word, bitVar}, Bool);
+    loopLocates.insert({bitmap, ModeFunction(Stmt(), {pos, found})});
+  }
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth++;
+    atomicParallelUnit = forall.getParallelUnit();
+  }
+
+  Stmt body = lowerForallBody(coordinate, stmt, locators, inserters,
+                              appenders, reducedAccesses);
+  for (auto& bitmap : merged) {
+    loopLocates.erase(bitmap);
+  }
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth--;
+  }
+
+  body = Block::make({recoveryStmt, body});
+
+  Stmt posAppend = generateAppendPositions(appenders);
+
+  // Visit the set bits of each word from the lowest to the highest
+  Stmt declareCoordinate = Block::make(
+      VarDecl::make(bitVar, Call::make("TACO_CTZ", {bitsVar}, Int())),
+      VarDecl::make(coordinate,
+                    ir::Add::make(ir::Mul::make(wordVar, 64), bitVar)));
+  Stmt clearBit = Assign::make(bitsVar,
+                               ir::BitAnd::make(bitsVar,
+                                   ir::Sub::make(bitsVar,
+                                       ir::Literal::make((uint64_t)1, UInt64))));
+  Stmt incrementPos = (merged.size() == 1)
+                    ? compoundAssign(merged[0].getBeginVar(), 1)
+                    : Stmt();
+  Stmt bitsLoop = While::make(ir::Neq::make(bitsVar,
+                                  ir::Literal::make((uint64_t)0, UInt64)),
+                              Block::make(declareCoordinate, body, clearBit,
+                                          incrementPos));
+
+  LoopKind kind = LoopKind::Serial;
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel
+      && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
+    kind = LoopKind::Runtime;
+  }
+
+  return Block::blanks(For::make(wordVar, 0, numWords, 1,
+                                 Block::make(Block::make(declareWords),
+                                             VarDecl::make(bitsVar, bits),
+                                             bitsLoop),
+                                 kind,
+                                 ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit()),
+                       posAppend);
+}
+
+
+Stmt LowererImpl::lowerForallHashed(Forall forall,
+                                    vector<Iterator> locators,
+                                    vector<Iterator> inserters,
+                                    vector<Iterator> appenders,
+                                    set<Access> reducedAccesses,
+                                    ir::Stmt recoveryStmt)
+{
+  IndexVar indexVar = forall.getIndexVar();
+  if (hashedWorkspaces.empty() || !provGraph.isUnderived(indexVar) ||
+      provGraph.hasCoordBounds(indexVar)) {
+    return Stmt();
+  }
+
+  // Only the coordinates inserted into the workspace contribute to the result
+  // if the statement is zero where the workspace is
+  IndexStmt stmt = forall.getStmt();
+  TensorVar workspace;
+  for (auto& locator : locators) {
+    Access access = iterators.modeAccess(locator).getAccess();
+    if (util::contains(hashedWorkspaces, access.getTensorVar()) &&
+        access.getIndexVars()[0] == indexVar &&
+        !zero(stmt, {access}).defined()) {
+      workspace = access.getTensorVar();
+      break;
+    }
+  }
+  if (!workspace.defined()) {
+    return Stmt();
+  }
+  const HashedWorkspace& hashed = hashedWorkspaces.at(workspace);
+
+  // Ordered result levels must be appended to in order
+  Stmt sort;
+  if (appendPhase != AppendPhase::Count &&
+      std::any_of(appenders.begin(), appenders.end(),
+                  [](Iterator it) { return it.isOrdered(); })) {
+    sort = Assign::make(hashed.size,
+                        Call::make("taco_sortCoordinates",
+                                   {hashed.coords, hashed.size}, Int32));
+  }
+
+  Expr coordinate = getCoordinateVar(indexVar);
+  Expr q = Var::make("q" + workspace.getName(), Int32);
+  Expr slot = Var::make("s" + workspace.getName(), Int32);
+  Stmt declareCoordinate = Block::make(
+      VarDecl::make(coordinate, Load::make(hashed.coords, q)),
+      generateComputeCode()
+          ? VarDecl::make(slot, Call::make("taco_hashLookup",
+                                           {hashed.keys, hashed.capacity,
+                                            hashed.shift, coordinate}, Int32))
+          : Stmt());
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth++;
+    atomicParallelUnit = forall.getParallelUnit();
+  }
+
+  hashedWorkspaces.at(workspace).slot = slot;
+  Stmt body = lowerForallBody(coordinate, stmt, locators, inserters,
+                              appenders, reducedAccesses);
+  hashedWorkspaces.at(workspace).slot = Expr();
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth--;
+  }
+
+  body = Block::make({declareCoordinate, recoveryStmt, body});
+
+  Stmt posAppend = generateAppendPositions(appenders);
+
+  LoopKind kind = LoopKind::Serial;
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel
+      && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
+    kind = LoopKind::Runtime;
+  }
+
+  return Block::blanks(sort,
+                       For::make(q, 0, hashed.size, 1, body, kind,
+                                 ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit()),
                        posAppend);
 }
 
@@ -894,13 +1518,36 @@ Stmt LowererImpl::lowerForallPosition(Forall forall, Iterator iterator,
   }
 
   LoopKind kind = LoopKind::Serial;
-  if (forall.getParallelUnit() == ParallelUnit::CPUVector && !ignoreVectorize) {
+  if (forall.getParallelUnit() == ParallelUnit::CPUVector) {
     kind = LoopKind::Vectorized;
   }
   else if (forall.getParallelUnit() != ParallelUnit::NotParallel
            && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
     kind = LoopKind::Runtime;
   }
+  // A mode that stores one coordinate per parent position, like a singleton
+  // mode, is iterated by a loop with one iteration. Emit its body directly so
+  // that the enclosing loop remains simple enough to vectorize.
+  if (kind == LoopKind::Serial && forall.getUnrollFactor() == 0 &&
+      provGraph.isUnderived(iterator.getIndexVar()) &&
+      isa<ir::Add>(endBound) && to<ir::Add>(endBound)->a == startBound &&
+      isa<ir::Literal>(to<ir::Add>(endBound)->b) &&
+      to<ir::Literal>(to<ir::Add>(endBound)->b)->equalsScalar(1)) {
+    return Block::blanks(boundsCompute,
+                         Block::make(VarDecl::make(iterator.getPosVar(),
+                                                   startBound),
+                                     declareCoordinate, body),
+                         posAppend);
+  }
+
+  // Skip positions that do not store a coordinate, like the empty slots of
+  // hashed modes
+  ModeFunction posAccess = iterator.posAccess(iterator.getPosVar(),
+                                              coordinates(iterator));
+  if (!isValue(posAccess.getResults()[1], true)) {
+    body = IfThenElse::make(posAccess.getResults()[1], body);
+  }
+
   // Loop with preamble and postamble
   return Block::blanks(boundsCompute,
                        For::make(iterator.getPosVar(), startBound, endBound, 1,
@@ -1052,7 +1699,7 @@ Stmt LowererImpl::lowerForallFusedPosition(Forall forall, Iterator iterator,
   }
 
   LoopKind kind = LoopKind::Serial;
-  if (forall.getParallelUnit() == ParallelUnit::CPUVector && !ignoreVectorize) {
+  if (forall.getParallelUnit() == ParallelUnit::CPUVector) {
     kind = LoopKind::Vectorized;
   }
   else if (forall.getParallelUnit() != ParallelUnit::NotParallel
@@ -1108,6 +1755,95 @@ Stmt LowererImpl::lowerMergeLattice(MergeLattice lattice, IndexVar coordinateVar
                        appendPositions);
 }
 
+/// Returns the array that a position access loads the coordinate at `pos`
+/// from, or an undefined expression if it computes the coordinate otherwise.
+static Expr getPositionedCoordArray(ModeFunction posAccess, Expr pos) {
+  const Load* load = posAccess[0].as<Load>();
+  if (posAccess.compute().defined() || load == nullptr) {
+    return Expr();
+  }
+  const ir::Mul* mul = load->loc.as<ir::Mul>();
+  if (load->loc != pos && !(mul && mul->a == pos && isValue(mul->b, 1))) {
+    return Expr();
+  }
+  return load->arr;
+}
+
+Stmt LowererImpl::lowerBlockIntersection(MergeLattice lattice,
+                                         IndexVar coordinateVar,
+                                         IndexStmt statement,
+                                         const set<Access>& reducedAccesses) {
+  if (should_use_CUDA_codegen() || lattice.points().size() != 1) {
+    return Stmt();
+  }
+  MergePoint point = lattice.points()[0];
+  vector<Iterator> mergers = point.mergers();
+  if (mergers.size() != 2 || point.iterators().size() != 2 ||
+      !point.locators().empty()) {
+    return Stmt();
+  }
+  vector<Expr> coordArrays;
+  for (Iterator merger : mergers) {
+    if (!merger.hasPosIter() || !merger.isUnique() || !merger.isOrdered() ||
+        merger.getIndexVar() != coordinateVar) {
+      return Stmt();
+    }
+    ModeFunction posAccess = merger.posAccess(merger.getPosVar(),
+                                              coordinates(merger));
+    Expr coordArray = getPositionedCoordArray(posAccess, merger.getPosVar());
+    if (!coordArray.defined() || !hasSearchFunctions(coordArray.type())) {
+      return Stmt();
+    }
+    coordArrays.push_back(coordArray);
+  }
+
+  Expr coordinate = getCoordinateVar(coordinateVar);
+  vector<Iterator> appenders;
+  vector<Iterator> inserters;
+  tie(appenders, inserters) = splitAppenderAndInserters(point.results());
+
+  Stmt iteratorVarInits = codeToInitializeIteratorVars(lattice.iterators(),
+                                                       point.rangers(),
+                                                       mergers, coordinate,
+                                                       coordinateVar);
+  Stmt loadPosIterCoordinates =
+      codeToLoadCoordinatesFromPosIterators(mergers, true);
+
+  // The iterator behind the other skips past its coordinates that are smaller
+  // than the other's, which it is known to have at least one of
+  vector<Stmt> skips;
+  for (size_t i = 0; i < 2; i++) {
+    Iterator merger = mergers[i];
+    Expr other = mergers[1 - i].getCoordVar();
+    Expr ivar = merger.getIteratorVar();
+    skips.push_back(Assign::make(ivar,
+        callSearchFunction("taco_intersectAdvance",
+                           {coordArrays[i], ir::Add::make(ivar, 1),
+                            merger.getEndVar(), other}, ivar.type())));
+  }
+
+  Stmt body = lowerForallBody(coordinate, statement, {}, inserters, appenders,
+                              reducedAccesses);
+  Stmt match = Block::make(VarDecl::make(coordinate, mergers[0].getCoordVar()),
+                           body,
+                           compoundAssign(mergers[0].getIteratorVar(), 1),
+                           compoundAssign(mergers[1].getIteratorVar(), 1));
+
+  Expr first = mergers[0].getCoordVar();
+  Expr second = mergers[1].getCoordVar();
+  Stmt intersectLoop =
+      While::make(checkThatNoneAreExhausted(point.rangers()),
+                  Block::make(loadPosIterCoordinates,
+                              IfThenElse::make(Lt::make(first, second),
+                                               skips[0],
+                              IfThenElse::make(Lt::make(second, first),
+                                               skips[1], match))));
+
+  return Block::blanks(iteratorVarInits,
+                       intersectLoop,
+                       generateAppendPositions(appenders));
+}
+
 Stmt LowererImpl::lowerMergePoint(MergeLattice pointLattice,
                                   ir::Expr coordinate, IndexVar coordinateVar, IndexStmt statement,
                                   const std::set<Access>& reducedAccesses, bool resolvedCoordDeclared)
@@ -1130,7 +1866,8 @@ Stmt LowererImpl::lowerMergePoint(MergeLattice pointLattice,
   Stmt resolvedCoordinate = resolveCoordinate(mergers, coordinate, !resolvedCoordDeclared);
 
   // Locate positions
-  Stmt loadLocatorPosVars = declLocatePosVars(locators);
+  vector<pair<Iterator,Expr>> locatorsFound;
+  Stmt loadLocatorPosVars = declLocatePosVars(locators, &locatorsFound);
 
   // Deduplication loops
   auto dupIters = filter(iterators, [](Iterator it){return !it.isUnique() && 
@@ -1140,8 +1877,17 @@ Stmt LowererImpl::lowerMergePoint(MergeLattice pointLattice,
                                                        alwaysReduce);
 
   // One case for each child lattice point lp
-  Stmt caseStmts = lowerMergeCases(coordinate, coordinateVar, statement, pointLattice,
-                                   reducedAccesses);
+  Expr locatorsGuard;
+  Stmt caseStmts = lowerLocated(statement, locatorsFound,
+                                [&](IndexStmt stmt) {
+                                  return lowerMergeCases(coordinate,
+                                                         coordinateVar, stmt,
+                                                         pointLattice,
+                                                         reducedAccesses);
+                                }, &locatorsGuard);
+  if (locatorsGuard.defined()) {
+    caseStmts = IfThenElse::make(locatorsGuard, caseStmts);
+  }
 
   // Increment iterator position variables
   Stmt incIteratorVarStmts = codeToIncIteratorVars(coordinate, coordinateVar, iterators, mergers);
@@ -1210,6 +1956,7 @@ Stmt LowererImpl::lowerMergeCases(ir::Expr coordinate, IndexVar coordinateVar, I
   }
   else {
     vector<pair<Expr,Stmt>> cases;
+    bool exact = lattice.exact();
     for (MergePoint point : lattice.points()) {
 
       // Construct case expression
@@ -1222,17 +1969,25 @@ Stmt LowererImpl::lowerMergeCases(ir::Expr coordinate, IndexVar coordinateVar, I
 
       // Construct case body
       IndexStmt zeroedStmt = zero(stmt, getExhaustedAccesses(point, lattice));
-      Stmt body = lowerForallBody(coordinate, zeroedStmt, {},
-                                  inserters, appenders, reducedAccesses);
       if (coordComparisons.empty()) {
         Stmt body = lowerForallBody(coordinate, stmt, {}, inserters,
                                     appenders, reducedAccesses);
         result.push_back(body);
         break;
       }
+      // The statement may already have been zeroed for operands that were
+      // not located, in which case nothing is computed at this point
+      if (!zeroedStmt.defined()) {
+        exact = false;
+        continue;
+      }
+      Stmt body = lowerForallBody(coordinate, zeroedStmt, {},
+                                  inserters, appenders, reducedAccesses);
       cases.push_back({taco::ir::conjunction(coordComparisons), body});
     }
-    result.push_back(Case::make(cases, lattice.exact()));
+    if (!cases.empty()) {
+      result.push_back(Case::make(cases, exact));
+    }
   }
 
   return Block::make(result);
@@ -1250,7 +2005,8 @@ Stmt LowererImpl::lowerForallBody(Expr coordinate, IndexStmt stmt,
   Stmt declInserterPosVars = declLocatePosVars(inserters);
 
   // Locate positions
-  Stmt declLocatorPosVars = declLocatePosVars(locators);
+  vector<pair<Iterator,Expr>> locatorsFound;
+  Stmt declLocatorPosVars = declLocatePosVars(locators, &locatorsFound);
 
   if (captureNextLocatePos) {
     capturedLocatePos = Block::make(declInserterPosVars, declLocatorPosVars);
@@ -1258,21 +2014,76 @@ Stmt LowererImpl::lowerForallBody(Expr coordinate, IndexStmt stmt,
   }
 
   // Code of loop body statement
-  Stmt body = lower(stmt);
+  Expr locatorsGuard;
+  Stmt body = lowerLocated(stmt, locatorsFound,
+                           [this](IndexStmt stmt) { return lower(stmt); },
+                           &locatorsGuard);
 
   // Code to append coordinates
   Stmt appendCoords = appendCoordinate(appenders, coordinate);
 
-  // TODO: Emit code to insert coordinates
+  // Code to insert coordinates
+  vector<Stmt> insertCoords;
+  if (generateAssembleCode()) {
+    for (auto& inserter : inserters) {
+      insertCoords.push_back(inserter.getInsertCoord(inserter.getPosVar(),
+                                                     coordinates(inserter)));
+    }
+  }
+
+  // Skip coordinates where the statement is zero
+  if (locatorsGuard.defined()) {
+    body = IfThenElse::make(locatorsGuard,
+                            Block::make(Block::make(insertCoords), body,
+                                        appendCoords));
+    insertCoords.clear();
+    appendCoords = Stmt();
+  }
 
   return Block::make(initVals,
                      declInserterPosVars,
+                     Block::make(insertCoords),
                      declLocatorPosVars,
                      body,
                      appendCoords);
 }
 
 
+Stmt LowererImpl::lowerLocated(IndexStmt stmt,
+                                vector<pair<Iterator,Expr>> locates,
+                                function<Stmt(IndexStmt)> lowerStmt,
+                                Expr* guard) {
+  vector<pair<Access,Expr>> optional;
+  for (auto& locate : locates) {
+    Access access = iterators.modeAccess(locate.first).getAccess();
+    if (!zero(stmt, {access}).defined()) {
+      *guard = guard->defined() ? ir::And::make(*guard, locate.second)
+                                : locate.second;
+    }
+    else {
+      optional.push_back({access, locate.second});
+    }
+  }
+
+  // Lower the statement for each combination of optional operands found
+  function<Stmt(IndexStmt,size_t)> lowerOptional = [&](IndexStmt stmt,
+                                                       size_t i) {
+    if (i == optional.size()) {
+      return lowerStmt(stmt);
+    }
+    Stmt found = lowerOptional(stmt, i + 1);
+    if (!found.defined()) {
+      return Stmt();
+    }
+    IndexStmt zeroedStmt = zero(stmt, {optional[i].first});
+    Stmt notFound = zeroedStmt.defined() ? lowerOptional(zeroedStmt, i + 1)
+                                         : Stmt();
+    return IfThenElse::make(optional[i].second, found, notFound);
+  };
+  return lowerOptional(stmt, 0);
+}
+
+
 Stmt LowererImpl::lowerWhere(Where where) {
   TensorVar temporary = where.getTemporary();
 
@@ -1282,6 +2093,30 @@ Stmt LowererImpl::lowerWhere(Where where) {
   if (isScalar(temporary.getType())) {
     initializeTemporary = defineScalarVariable(temporary, true);
   }
+  else if (util::contains(hashedWorkspaces, temporary)) {
+    // The coordinates of hashed workspaces are needed to assemble results
+    const HashedWorkspace& workspace = hashedWorkspaces.at(temporary);
+    int tableSize = workspace.tableSize;
+    int bits = 0;
+    while ((1 << bits) < tableSize) {
+      bits++;
+    }
+    initializeTemporary = Block::make(
+        VarDecl::make(workspace.capacity, tableSize),
+        VarDecl::make(workspace.shift, 32 - bits),
+        VarDecl::make(workspace.keys, 0),
+        generateComputeCode() ? VarDecl::make(workspace.values, 0) : Stmt(),
+        allocateHashTable(temporary, workspace.keys, workspace.values,
+                          workspace.capacity),
+        VarDecl::make(workspace.coordsCapacity, std::max(tableSize / 2, 1)),
+        VarDecl::make(workspace.coords, 0),
+        Allocate::make(workspace.coords, workspace.coordsCapacity),
+        VarDecl::make(workspace.size, 0));
+    freeTemporary = Block::make(
+        Free::make(workspace.keys),
+        generateComputeCode() ? Free::make(workspace.values) : Stmt(),
+        Free::make(workspace.coords));
+  }
   else {
     if (generateComputeCode()) {
       Expr values = ir::Var::make(temporary.getName(),
@@ -1358,6 +2193,98 @@ Stmt LowererImpl::lowerWhere(Where where) {
 }
 
 
+Stmt LowererImpl::allocateHashTable(TensorVar workspace, Expr keys,
+                                    Expr values, Expr capacity) {
+  Expr p = Var::make("p" + workspace.getName(), Int32);
+  Stmt allocateKeys = Allocate::make(keys, capacity);
+  Stmt clearKeys = For::make(p, 0, capacity, 1, Store::make(keys, p, -1));
+  if (!generateComputeCode()) {
+    return Block::make(allocateKeys, clearKeys);
+  }
+
+  // Lookups of coordinates that are not in the table yield the slot past the
+  // last one, which holds a zero
+  Datatype type = workspace.getType().getDataType();
+  Stmt allocateValues = Allocate::make(values, ir::Add::make(capacity, 1));
+  Stmt storeZero = Store::make(values, capacity, ir::Literal::zero(type));
+  return Block::make(allocateKeys, clearKeys, allocateValues, storeZero);
+}
+
+
+Stmt LowererImpl::lowerHashedAssignment(Assignment assignment) {
+  TensorVar workspace = assignment.getLhs().getTensorVar();
+  const HashedWorkspace& hashed = hashedWorkspaces.at(workspace);
+  const bool computeValues = generateComputeCode();
+  const string name = workspace.getName();
+  Datatype type = workspace.getType().getDataType();
+  Expr coord = getCoordinateVar(assignment.getLhs().getIndexVars()[0]);
+
+  // Double the number of slots before the table gets more than half full, and
+  // move the stored coordinates and values into the new table
+  Expr newKeys = Var::make(name + "_keys_new", Int32, true);
+  Expr newValues = Var::make(name + "_new", type, true);
+  Expr newCapacity = Var::make(name + "_capacity_new", Int32);
+  Expr p = Var::make("p" + name + "_old", Int32);
+  Expr oldKey = Load::make(hashed.keys, p);
+  Expr newSlot = Var::make("s" + name + "_new", Int32);
+  Stmt move = Block::make(
+      VarDecl::make(newSlot, Call::make("TACO_HASH", {oldKey, hashed.shift},
+                                        Int32)),
+      While::make(Gte::make(Load::make(newKeys, newSlot), 0),
+                  Assign::make(newSlot,
+                               BitAnd::make(ir::Add::make(newSlot, 1),
+                                            ir::Sub::make(newCapacity, 1)))),
+      Store::make(newKeys, newSlot, oldKey),
+      computeValues ? Store::make(newValues, newSlot,
+                                  Load::make(hashed.values, p))
+                    : Stmt());
+  Stmt rehash = Block::make(
+      VarDecl::make(newCapacity, ir::Mul::make(hashed.capacity, 2)),
+      VarDecl::make(newKeys, 0),
+      computeValues ? VarDecl::make(newValues, 0) : Stmt(),
+      allocateHashTable(workspace, newKeys, newValues, newCapacity),
+      Assign::make(hashed.shift, ir::Sub::make(hashed.shift, 1)),
+      For::make(p, 0, hashed.capacity, 1,
+                IfThenElse::make(Gte::make(oldKey, 0), move)),
+      Free::make(hashed.keys),
+      computeValues ? Free::make(hashed.values) : Stmt(),
+      Assign::make(hashed.keys, newKeys),
+      computeValues ? Assign::make(hashed.values, newValues) : Stmt(),
+      Assign::make(hashed.capacity, newCapacity));
+  Stmt grow = IfThenElse::make(
+      Gt::make(ir::Mul::make(ir::Add::make(hashed.size, 1), 2),
+               hashed.capacity),
+      rehash);
+
+  // Probe the table linearly from the slot the coordinate hashes to, and
+  // insert the coordinate into the first empty slot if it is not stored yet
+  Expr slot = Var::make("s" + name, Int32);
+  Expr key = Load::make(hashed.keys, slot);
+  Stmt probe = Block::make(
+      VarDecl::make(slot, Call::make("TACO_HASH", {coord, hashed.shift}, Int32)),
+      While::make(ir::And::make(Neq::make(key, coord), Gte::make(key, 0)),
+                  Assign::make(slot,
+                               BitAnd::make(ir::Add::make(slot, 1),
+                                            ir::Sub::make(hashed.capacity, 1)))));
+  Stmt insert = IfThenElse::make(Lt::make(key, 0), Block::make(
+      Store::make(hashed.keys, slot, coord),
+      computeValues ? Store::make(hashed.values, slot, ir::Literal::zero(type))
+                    : Stmt(),
+      doubleSizeIfFull(hashed.coords, hashed.coordsCapacity, hashed.size),
+      Store::make(hashed.coords, hashed.size, coord),
+      Assign::make(hashed.size, ir::Add::make(hashed.size, 1))));
+
+  Stmt accumulate;
+  if (computeValues) {
+    Expr rhs = lower(assignment.getRhs());
+    accumulate = assignment.getOperator().defined()
+               ? compoundStore(hashed.values, slot, rhs)
+               : Store::make(hashed.values, slot, rhs);
+  }
+  return Block::make(grow, probe, insert, accumulate);
+}
+
+
 Stmt LowererImpl::lowerSequence(Sequence sequence) {
   Stmt definition = lower(sequence.getDefinition());
   Stmt mutation = lower(sequence.getMutation());
@@ -1384,6 +2311,16 @@ Expr LowererImpl::lowerAccess(Access access) {
     return getTensorVar(var);
   }
 
+  if (util::contains(hashedWorkspaces, var)) {
+    const HashedWorkspace& hashed = hashedWorkspaces.at(var);
+    Expr slot = hashed.slot.defined()
+        ? hashed.slot
+        : Call::make("taco_hashLookup",
+                     {hashed.keys, hashed.capacity, hashed.shift,
+                      getCoordinateVar(access.getIndexVars()[0])}, Int32);
+    return Load::make(hashed.values, slot);
+  }
+
   return getIterators(access).back().isUnique()
          ? Load::make(getValuesArray(var), generateValueLocExpr(access))
          : getReducedValueVar(access);
@@ -1736,7 +2673,9 @@ ir::Stmt LowererImpl::finalizeResultArrays(std::vector<Access> writes) {
       // Post-process data structures for storing levels
       if (iterator.hasAppend()) {
         size = iterator.getPosVar();
-        finalize = iterator.getAppendFinalizeLevel(parentSize, size);
+        if (!util::contains(scannedAppenders, iterator)) {
+          finalize = iterator.getAppendFinalizeLevel(parentSize, size);
+        }
       } else if (iterator.hasInsert()) {
         size = simplify(ir::Mul::make(parentSize, iterator.getWidth()));
         finalize = iterator.getInsertFinalizeLevel(parentSize, size);
@@ -1890,9 +2829,10 @@ Stmt LowererImpl::resizeAndInitValues(const std::vector<Iterator>& appenders,
     Expr tensor = appender.getTensor(); 
     Expr values = GetProperty::make(tensor, TensorProperty::Values);
     Expr capacity = getCapacityVar(appender.getTensor());
-    Expr pos = appender.getIteratorVar();
+    Expr pos = appender.getPosVar();
 
-    if (generateAssembleCode()) {
+    if (generateAssembleCode() &&
+        !util::contains(parallelAppenders, appender)) {
       result.push_back(doubleSizeIfFull(values, capacity, pos));
     }
 
@@ -1909,7 +2849,7 @@ Stmt LowererImpl::resizeAndInitValues(const std::vector<Iterator>& appenders,
 Stmt LowererImpl::zeroInitValues(Expr tensor, Expr begin, Expr size) {
   Expr lower = simplify(ir::Mul::make(begin, size));
   Expr upper = simplify(ir::Mul::make(ir::Add::make(begin, 1), size));
-  Expr p = Var::make("p" + util::toString(tensor), Int());
+  Expr p = Var::make("p" + util::toString(tensor), getCapacityVar(tensor).type());
   Expr values = GetProperty::make(tensor, TensorProperty::Values);
   Stmt zeroInit = Store::make(values, p, ir::Literal::zero(tensor.type()));
   LoopKind parallel = (isa<ir::Literal>(size) && 
@@ -1923,7 +2863,8 @@ Stmt LowererImpl::zeroInitValues(Expr tensor, Expr begin, Expr size) {
 }
 
 
-Stmt LowererImpl::declLocatePosVars(vector<Iterator> locators) {
+Stmt LowererImpl::declLocatePosVars(vector<Iterator> locators,
+                                    vector<pair<Iterator,Expr>>* found) {
   vector<Stmt> result;
   for (Iterator& locator : locators) {
     accessibleIterators.insert(locator);
@@ -1939,15 +2880,23 @@ Stmt LowererImpl::declLocatePosVars(vector<Iterator> locators) {
 
     if (doLocate) {
       Iterator locateIterator = locator;
-      if (locateIterator.hasPosIter()) {
-        taco_iassert(!provGraph.isUnderived(locateIterator.getIndexVar()));
+      if (locateIterator.hasPosIter() &&
+          !provGraph.isUnderived(locateIterator.getIndexVar())) {
         continue; // these will be recovered with separate procedure
       }
       do {
-        ModeFunction locate = locateIterator.locate(coordinates(locateIterator));
-        taco_iassert(isValue(locate.getResults()[1], true));
+        ModeFunction locate = util::contains(loopLocates, locateIterator)
+            ? loopLocates.at(locateIterator)
+            : locateIterator.locate(coordinates(locateIterator));
+        if (!isValue(locate.getResults()[1], true)) {
+          taco_iassert(found != nullptr || locateIterator.hasInsert());
+          if (found != nullptr) {
+            found->push_back({locateIterator, locate.getResults()[1]});
+          }
+        }
         Stmt declarePosVar = VarDecl::make(locateIterator.getPosVar(),
                                            locate.getResults()[0]);
+        result.push_back(locate.compute());
         result.push_back(declarePosVar);
 
         if (locateIterator.isLeaf()) {
@@ -2048,7 +2997,7 @@ Stmt LowererImpl::codeToInitializeIteratorVar(Iterator iterator, vector<Iterator
                   iterator.getBeginVar() // target
           };
           result.push_back(
-                  VarDecl::make(iterVar, Call::make("taco_binarySearchAfter", binarySearchArgs, iterVar.type())));
+                  VarDecl::make(iterVar, callSearchFunction("taco_binarySearchAfter", binarySearchArgs, iterVar.type())));
         }
         else {
           result.push_back(VarDecl::make(iterVar, bounds[0]));
@@ -2259,7 +3208,14 @@ Stmt LowererImpl::appendCoordinate(vector<Iterator> appenders, Expr coord) {
 
     vector<Stmt> appendStmts;
 
-    if (generateAssembleCode()) {
+    if (generateAssembleCode() && util::contains(parallelAppenders, appender)) {
+      // Only count coordinates in the count pass, and store them at their
+      // scanned positions in the fill pass
+      if (appendPhase == AppendPhase::Fill) {
+        appendStmts.push_back(appender.getAppendFillCoord(pos, coord));
+      }
+    }
+    else if (generateAssembleCode()) {
       appendStmts.push_back(appender.getAppendCoord(pos, coord));
       while (!appender.isRoot() && appender.isBranchless()) {
         // Need to append result coordinate to parent level as well if child 
@@ -2299,6 +3255,11 @@ Stmt LowererImpl::generateAppendPositions(vector<Iterator> appenders) {
   vector<Stmt> result;
   if (generateAssembleCode()) {
     for (Iterator appender : appenders) {
+      if (appendPhase == AppendPhase::Fill &&
+          util::contains(parallelAppenders, appender)) {
+        // Positions were stored by the count pass
+        continue;
+      }
       if (!appender.isBranchless()) {
         Expr pos = [](Iterator appender) {
           // Get the position variable associated with the appender. If a mode 
@@ -100,6 +100,7 @@ std::ostream& operator<<(std::ostream& os, const Mode& mode) {
 struct ModePack::Content {
   size_t numModes = 0;
   vector<ir::Expr> arrays;
+  Datatype positionType = Int();
 };
 
 ModePack::ModePack() : content(new Content) {
@@ -111,6 +112,24 @@ ModePack::ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor,
   content->arrays = modeType.impl->getArrays(tensor, mode, level);
 }
 
+ModePack::ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor,
+                   int mode, int level, const vector<Datatype>& arrayTypes,
+                   Datatype positionType)
+    : ModePack(numModes, modeType, tensor, mode, level) {
+  content->positionType = positionType;
+  for (auto& array : content->arrays) {
+    const ir::GetProperty* property = array.as<ir::GetProperty>();
+    if (property == nullptr ||
+        property->property != ir::TensorProperty::Indices ||
+        property->index >= (int)arrayTypes.size()) {
+      continue;
+    }
+    array = ir::GetProperty::make(property->tensor, property->property,
+                                  property->mode, property->index,
+                                  property->name, arrayTypes[property->index]);
+  }
+}
+
 size_t ModePack::getNumModes() const {
   return content->numModes;
 }
@@ -119,4 +138,8 @@ ir::Expr ModePack::getArray(size_t i) const {
   return content->arrays[i];
 }
 
+Datatype ModePack::getPositionType() const {
+  return content->positionType;
+}
+
 }
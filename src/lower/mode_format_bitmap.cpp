@@ -0,0 +1,180 @@
+#include "taco/lower/mode_format_bitmap.h"
+
+#include "ir/ir_generators.h"
+#include "taco/error.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+BitmapModeFormat::BitmapModeFormat() : BitmapModeFormat(DEFAULT_ALLOC_SIZE) {
+}
+
+BitmapModeFormat::BitmapModeFormat(long long allocSize) :
+    ModeFormatImpl("bitmap", false, true, true, false, true, false, false,
+                   true, false, true),
+    allocSize(allocSize) {
+}
+
+ModeFormat BitmapModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  return ModeFormat(std::make_shared<BitmapModeFormat>(allocSize));
+}
+
+ModeFunction BitmapModeFormat::locate(Expr parentPos, vector<Expr> coords,
+                                      Mode mode) const {
+  Expr coord = coords.back();
+  Expr wordPos = Add::make(Mul::make(parentPos, getNumWords(mode)),
+                           Div::make(coord, 64));
+  Expr word = Load::make(getBitmapArray(mode.getModePack()), wordPos);
+  Expr bit = Rem::make(coord, 64);
+  Expr pos = Add::make(Load::make(getRankArray(mode.getModePack()), wordPos),
+                       Call::make("TACO_RANK", {word, bit}, Int()));
+  Expr found = Call::make("TACO_BIT", {word, bit}, Bool);
+  return ModeFunction(Stmt(), {pos, found});
+}
+
+Stmt BitmapModeFormat::getAppendCoord(Expr p, Expr i, Mode mode) const {
+  Expr crdBuffer = getCoordBuffer(mode);
+  Stmt maybeResize = doubleSizeIfFull(crdBuffer, getCoordBufferCapacity(mode),
+                                      p);
+  return Block::make(maybeResize, Store::make(crdBuffer, p, i));
+}
+
+Stmt BitmapModeFormat::getAppendEdges(Expr pPrev, Expr pBegin, Expr pEnd,
+                                      Mode mode) const {
+  // Set the bits of the coordinates appended below the parent position
+  Expr bitmapArray = getBitmapArray(mode.getModePack());
+  Expr pVar = Var::make("p" + mode.getName(),
+                        mode.getModePack().getPositionType());
+  Expr coord = Load::make(getCoordBuffer(mode), pVar);
+  Expr wordPos = Add::make(Mul::make(pPrev, getNumWords(mode)),
+                           Div::make(coord, 64));
+  Expr mask = Call::make("TACO_BITMASK", {Rem::make(coord, 64)}, UInt64);
+  Stmt setBit = Store::make(bitmapArray, wordPos,
+                            BitOr::make(Load::make(bitmapArray, wordPos),
+                                        mask));
+  return For::make(pVar, pBegin, pEnd, 1, setBit);
+}
+
+Expr BitmapModeFormat::getSize(Expr szPrev, Mode mode) const {
+  return Load::make(getRankArray(mode.getModePack()),
+                    Mul::make(szPrev, getNumWords(mode)));
+}
+
+Stmt BitmapModeFormat::getAppendInitEdges(Expr pPrevBegin, Expr pPrevEnd,
+                                          Mode mode) const {
+  return Stmt();
+}
+
+Stmt BitmapModeFormat::getAppendInitLevel(Expr szPrev, Expr sz,
+                                          Mode mode) const {
+  taco_uassert(!(isa<Literal>(szPrev) && to<Literal>(szPrev)->equalsScalar(0)))
+      << "Results with bitmap modes below compressed or singleton modes are "
+         "not supported";
+
+  Datatype positionType = mode.getModePack().getPositionType();
+  Expr numWords = Mul::make(szPrev, getNumWords(mode));
+  Expr bitmapArray = getBitmapArray(mode.getModePack());
+  Expr pVar = Var::make("p" + mode.getName(), positionType);
+  Stmt clearBitmap = For::make(pVar, 0, numWords, 1,
+                               Store::make(bitmapArray, pVar,
+                                           Literal::make((uint64_t)0, UInt64)));
+
+  Expr crdBuffer = getCoordBuffer(mode);
+  Expr crdCapacity = getCoordBufferCapacity(mode);
+  return Block::make({Allocate::make(bitmapArray, numWords),
+                      clearBitmap,
+                      Allocate::make(getRankArray(mode.getModePack()),
+                                     Add::make(numWords, 1)),
+                      VarDecl::make(crdCapacity,
+                                    Literal::make(allocSize, positionType)),
+                      VarDecl::make(crdBuffer, 0),
+                      Allocate::make(crdBuffer, crdCapacity)});
+}
+
+Stmt BitmapModeFormat::getAppendFinalizeLevel(Expr szPrev, Expr sz,
+                                              Mode mode) const {
+  // Rank the words of the bitmaps
+  Datatype positionType = mode.getModePack().getPositionType();
+  Expr numWords = Mul::make(szPrev, getNumWords(mode));
+  Expr rankArray = getRankArray(mode.getModePack());
+  Expr csVar = Var::make("cs" + mode.getName(), positionType);
+  Expr pVar = Var::make("p" + mode.getName(), positionType);
+  Expr word = Load::make(getBitmapArray(mode.getModePack()), pVar);
+  Stmt rankWord = Block::make(
+      Store::make(rankArray, pVar, csVar),
+      Assign::make(csVar,
+                   Add::make(csVar, Call::make("TACO_POPCOUNT", {word},
+                                               Int()))));
+  return Block::make({VarDecl::make(csVar, 0),
+                      For::make(pVar, 0, numWords, 1, rankWord),
+                      Store::make(rankArray, numWords, csVar),
+                      Free::make(getCoordBuffer(mode))});
+}
+
+vector<Expr> BitmapModeFormat::getArrays(Expr tensor, int mode,
+                                         int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_rank"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_bitmap", UInt64),
+          GetProperty::make(tensor, TensorProperty::Dimension, mode)};
+}
+
+Expr BitmapModeFormat::getNumWords(Mode mode) const {
+  return Div::make(Add::make(getDimension(mode.getModePack()), 63), 64);
+}
+
+Expr BitmapModeFormat::getWord(Expr parentPos, Expr word, Mode mode) const {
+  return Load::make(getBitmapArray(mode.getModePack()),
+                    Add::make(Mul::make(parentPos, getNumWords(mode)), word));
+}
+
+Expr BitmapModeFormat::getRank(Expr parentPos, Expr word, Mode mode) const {
+  return Load::make(getRankArray(mode.getModePack()),
+                    Add::make(Mul::make(parentPos, getNumWords(mode)), word));
+}
+
+Expr BitmapModeFormat::getRankArray(ModePack pack) const {
+  return pack.getArray(0);
+}
+
+Expr BitmapModeFormat::getBitmapArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+Expr BitmapModeFormat::getDimension(ModePack pack) const {
+  return pack.getArray(2);
+}
+
+Expr BitmapModeFormat::getCoordBuffer(Mode mode) const {
+  const std::string varName = mode.getName() + "_crd";
+  if (!mode.hasVar(varName)) {
+    Expr crdBuffer = Var::make(varName, Int32, true, false);
+    mode.addVar(varName, crdBuffer);
+    return crdBuffer;
+  }
+  return mode.getVar(varName);
+}
+
+Expr BitmapModeFormat::getCoordBufferCapacity(Mode mode) const {
+  const std::string varName = mode.getName() + "_crd_size";
+  if (!mode.hasVar(varName)) {
+    Expr crdCapacity = Var::make(varName,
+                                 mode.getModePack().getPositionType());
+    mode.addVar(varName, crdCapacity);
+    return crdCapacity;
+  }
+  return mode.getVar(varName);
+}
+
+bool BitmapModeFormat::equals(const ModeFormatImpl& other) const {
+  return ModeFormatImpl::equals(other) &&
+         (dynamic_cast<const BitmapModeFormat&>(other).allocSize == allocSize);
+}
+
+}
@@ -1,5 +1,7 @@
 #include "taco/lower/mode_format_compressed.h"
 
+#include <functional>
+
 #include "ir/ir_generators.h"
 #include "taco/ir/simplify.h"
 #include "taco/util/strings.h"
@@ -123,7 +125,8 @@ Stmt CompressedModeFormat::getAppendInitEdges(Expr pPrevBegin,
     return doubleSizeIfFull(posArray, posCapacity, pPrevEnd);
   }
 
-  Expr pVar = Var::make("p" + mode.getName(), Int());
+  Expr pVar = Var::make("p" + mode.getName(),
+                        mode.getModePack().getPositionType());
   Expr lb = Add::make(pPrevBegin, 1);
   Expr ub = Add::make(pPrevEnd, 1);
   Stmt initPos = For::make(pVar, lb, ub, 1, Store::make(posArray, pVar, 0));
@@ -151,7 +154,8 @@ Stmt CompressedModeFormat::getAppendInitLevel(Expr szPrev, Expr sz,
 
   if (mode.getParentModeType().defined() &&
       !mode.getParentModeType().hasAppend() && !szPrevIsZero) {
-    Expr pVar = Var::make("p" + mode.getName(), Int());
+    Expr pVar = Var::make("p" + mode.getName(),
+                          mode.getModePack().getPositionType());
     Stmt storePos = Store::make(posArray, pVar, 0);
     initStmts.push_back(For::make(pVar, 1, initCapacity, 1, storePos));
   }
@@ -174,10 +178,11 @@ Stmt CompressedModeFormat::getAppendFinalizeLevel(Expr szPrev,
     return Stmt();
   }
 
-  Expr csVar = Var::make("cs" + mode.getName(), Int());
+  Datatype positionType = mode.getModePack().getPositionType();
+  Expr csVar = Var::make("cs" + mode.getName(), positionType);
   Stmt initCs = VarDecl::make(csVar, 0);
   
-  Expr pVar = Var::make("p" + mode.getName(), Int());
+  Expr pVar = Var::make("p" + mode.getName(), positionType);
   Expr loadPos = Load::make(getPosArray(mode.getModePack()), pVar);
   Stmt incCs = Assign::make(csVar, Add::make(csVar, loadPos));
   Stmt updatePos = Store::make(getPosArray(mode.getModePack()), pVar, csVar);
@@ -187,6 +192,105 @@ Stmt CompressedModeFormat::getAppendFinalizeLevel(Expr szPrev,
   return Block::make({initCs, finalizeLoop});
 }
 
+bool CompressedModeFormat::hasParallelAppend(Mode mode) const {
+  // The counts of the parent positions are scanned in place in the pos array,
+  // which needs every parent position to have an entry
+  ModeFormat parentModeType = mode.getParentModeType();
+  return mode.getModePack().getNumModes() == 1 &&
+         parentModeType.defined() && !parentModeType.hasAppend();
+}
+
+Expr CompressedModeFormat::getAppendBegin(Expr pPrev, Mode mode) const {
+  return Load::make(getPosArray(mode.getModePack()), pPrev);
+}
+
+Stmt CompressedModeFormat::getAppendScanLevel(Expr szPrev, Mode mode) const {
+  Expr crdCapacity = getCoordCapacity(mode);
+  Stmt scanPos = getAppendFinalizeLevel(szPrev, Expr(), mode);
+  if (scanPos.defined()) {
+    scanPos = scanCountsInParallel(szPrev, mode);
+  }
+  Expr size = Load::make(getPosArray(mode.getModePack()), szPrev);
+  Stmt resizeCrd = Allocate::make(getCoordArray(mode.getModePack()), size,
+                                  true, crdCapacity);
+  Stmt sizeCrd = Assign::make(crdCapacity, size);
+  return Block::make({scanPos, resizeCrd, sizeCrd});
+}
+
+Stmt CompressedModeFormat::scanCountsInParallel(Expr szPrev, Mode mode) const {
+  // Each thread scans the counts of a block of parent positions, the totals of
+  // the blocks are scanned into the offsets of the blocks, and each thread then
+  // adds the offset of its block to the positions in it
+  Datatype positionType = mode.getModePack().getPositionType();
+  Expr posArray = getPosArray(mode.getModePack());
+  const std::string name = mode.getName();
+  Expr numBlocks = Var::make(name + "_num_blocks", positionType);
+  Expr blockSize = Var::make(name + "_block_size", positionType);
+  Expr blockOffsets = Var::make(name + "_block_offsets", positionType, true);
+  Stmt initBlocks = Block::make(
+      VarDecl::make(numBlocks, Cast::make(Call::make("TACO_NUM_THREADS", {},
+                                                     Int32), positionType)),
+      VarDecl::make(blockSize,
+                    Div::make(Sub::make(Add::make(szPrev, numBlocks), 1),
+                              numBlocks)),
+      VarDecl::make(blockOffsets, 0),
+      Allocate::make(blockOffsets, Add::make(numBlocks, 1)),
+      Store::make(blockOffsets, 0, ir::Literal::zero(positionType)));
+
+  // Loops over the blocks in parallel, and over the positions of each block
+  auto forEachBlock = [&](const std::string& pass,
+                          function<Stmt(Expr b, Stmt loop)> makeBody,
+                          function<Stmt(Expr b, Expr p)> makeLoopBody) {
+    Expr b = Var::make("b" + name + "_" + pass, positionType);
+    Expr p = Var::make("p" + name + "_" + pass, positionType);
+    Expr begin = Var::make(name + "_" + pass + "_begin", positionType);
+    Expr end = Var::make(name + "_" + pass + "_end", positionType);
+    Stmt loop = For::make(p, begin, end, 1, makeLoopBody(b, p));
+    return For::make(b, 0, numBlocks, 1, Block::make(
+        VarDecl::make(begin, Add::make(Mul::make(b, blockSize), 1)),
+        VarDecl::make(end, Min::make(Add::make(begin, blockSize),
+                                     Add::make(szPrev, 1))),
+        makeBody(b, loop)),
+        LoopKind::Static, ParallelUnit::CPUThread);
+  };
+
+  Expr cs = Var::make("cs" + name, positionType);
+  Stmt scanBlocks = forEachBlock("scan",
+      [&](Expr b, Stmt loop) {
+        return Block::make(VarDecl::make(cs, 0), loop,
+                           Store::make(blockOffsets, Add::make(b, 1), cs));
+      },
+      [&](Expr, Expr p) {
+        return Block::make(
+            Assign::make(cs, Add::make(cs, Load::make(posArray, p))),
+            Store::make(posArray, p, cs));
+      });
+
+  Expr c = Var::make("b" + name, positionType);
+  Stmt scanOffsets = For::make(c, 1, Add::make(numBlocks, 1), 1,
+      Store::make(blockOffsets, c,
+                  Add::make(Load::make(blockOffsets, c),
+                            Load::make(blockOffsets, Sub::make(c, 1)))));
+
+  Stmt offsetBlocks = forEachBlock("offset",
+      [](Expr, Stmt loop) {
+        return loop;
+      },
+      [&](Expr b, Expr p) {
+        return Store::make(posArray, p,
+                           Add::make(Load::make(posArray, p),
+                                     Load::make(blockOffsets, b)));
+      });
+
+  return Block::make(initBlocks, scanBlocks, scanOffsets, offsetBlocks,
+                     Free::make(blockOffsets));
+}
+
+Stmt CompressedModeFormat::getAppendFillCoord(Expr p, Expr i,
+                                              Mode mode) const {
+  return Store::make(getCoordArray(mode.getModePack()), p, i);
+}
+
 vector<Expr> CompressedModeFormat::getArrays(Expr tensor, int mode, 
                                              int level) const {
   std::string arraysName = util::toString(tensor) + std::to_string(level);
@@ -208,7 +312,8 @@ Expr CompressedModeFormat::getPosCapacity(Mode mode) const {
   const std::string varName = mode.getName() + "_pos_size";
  
   if (!mode.hasVar(varName)) {
-    Expr posCapacity = Var::make(varName, Int());
+    Expr posCapacity = Var::make(varName,
+                                 mode.getModePack().getPositionType());
     mode.addVar(varName, posCapacity);
     return posCapacity;
   }
@@ -220,7 +325,8 @@ Expr CompressedModeFormat::getCoordCapacity(Mode mode) const {
   const std::string varName = mode.getName() + "_crd_size";
   
   if (!mode.hasVar(varName)) {
-    Expr idxCapacity = Var::make(varName, Int());
+    Expr idxCapacity = Var::make(varName,
+                                 mode.getModePack().getPositionType());
     mode.addVar(varName, idxCapacity);
     return idxCapacity;
   }
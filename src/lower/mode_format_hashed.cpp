@@ -0,0 +1,159 @@
+#include "taco/lower/mode_format_hashed.h"
+
+#include "taco/error.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+HashedModeFormat::HashedModeFormat() : HashedModeFormat(1024) {
+}
+
+HashedModeFormat::HashedModeFormat(int tableSize) :
+    HashedModeFormat(false, true, tableSize) {
+}
+
+HashedModeFormat::HashedModeFormat(bool isOrdered, bool isUnique,
+                                   int tableSize) :
+    ModeFormatImpl("hashed", false, isOrdered, isUnique, false, false, false,
+                   true, true, true, false),
+    tableSize(tableSize) {
+  taco_uassert(tableSize >= 2 && (tableSize & (tableSize - 1)) == 0 &&
+               tableSize <= (1 << 30)) <<
+      "The table size of a hashed mode must be a power of two between 2 and "
+      "2^30";
+}
+
+ModeFormat HashedModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  bool isOrdered = this->isOrdered;
+  bool isUnique = this->isUnique;
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::ORDERED:
+        isOrdered = true;
+        break;
+      case ModeFormat::NOT_ORDERED:
+        isOrdered = false;
+        break;
+      case ModeFormat::UNIQUE:
+        isUnique = true;
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        isUnique = false;
+        break;
+      default:
+        break;
+    }
+  }
+  return ModeFormat(std::make_shared<HashedModeFormat>(isOrdered, isUnique,
+                                                       tableSize));
+}
+
+ModeFunction HashedModeFormat::posIterBounds(Expr parentPos, Mode mode) const {
+  Expr pbegin = Mul::make(parentPos, tableSize);
+  Expr pend = Mul::make(Add::make(parentPos, 1), tableSize);
+  return ModeFunction(Stmt(), {pbegin, pend});
+}
+
+ModeFunction HashedModeFormat::posIterAccess(ir::Expr pos,
+                                             std::vector<ir::Expr> coords,
+                                             Mode mode) const {
+  Expr idx = Load::make(getCoordArray(mode.getModePack()), pos);
+  return ModeFunction(Stmt(), {idx, Gte::make(idx, 0)});
+}
+
+ModeFunction HashedModeFormat::locate(ir::Expr parentPos,
+                                      std::vector<ir::Expr> coords,
+                                      Mode mode) const {
+  // Probe the table linearly from the slot the coordinate hashes to, until
+  // finding the coordinate or an empty slot. Probes of full tables stop after
+  // visiting every slot, and packing reports the full table.
+  Datatype positionType = mode.getModePack().getPositionType();
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Expr coord = coords.back();
+  Expr base = Mul::make(parentPos, tableSize);
+  Expr slot = Var::make("s" + mode.getName(), positionType);
+  Expr probes = Var::make("n" + mode.getName(), Int32);
+  Expr stored = Load::make(crdArray, Add::make(base, slot));
+  Stmt initSlot = VarDecl::make(slot, hash(coord, positionType));
+  Stmt initProbes = VarDecl::make(probes, 1);
+  Stmt probe = While::make(And::make(And::make(Neq::make(stored, coord),
+                                               Gte::make(stored, 0)),
+                                     Lt::make(probes, tableSize)),
+                           Block::make(
+                               Assign::make(slot,
+                                            BitAnd::make(Add::make(slot, 1),
+                                                         tableSize - 1)),
+                               Assign::make(probes, Add::make(probes, 1))));
+  return ModeFunction(Block::make(initSlot, initProbes, probe),
+                      {Add::make(base, slot), Eq::make(stored, coord)});
+}
+
+Stmt HashedModeFormat::getInsertCoord(Expr p, const std::vector<Expr>& i,
+                                      Mode mode) const {
+  return Store::make(getCoordArray(mode.getModePack()), p, i.back());
+}
+
+Expr HashedModeFormat::getWidth(Mode mode) const {
+  return tableSize;
+}
+
+Stmt HashedModeFormat::getInsertInitCoords(Expr pBegin, Expr pEnd,
+                                           Mode mode) const {
+  return Stmt();
+}
+
+Stmt HashedModeFormat::getInsertInitLevel(Expr szPrev, Expr sz,
+                                          Mode mode) const {
+  taco_uassert(!(isa<Literal>(sz) && to<Literal>(sz)->equalsScalar(0))) <<
+      "Results with hashed modes below compressed or singleton modes are not "
+      "supported";
+
+  // Allocate the hash tables and mark all their slots as empty
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Expr pVar = Var::make("p" + mode.getName(),
+                        mode.getModePack().getPositionType());
+  Stmt allocate = Allocate::make(crdArray, sz);
+  Stmt clear = For::make(pVar, 0, sz, 1, Store::make(crdArray, pVar, -1));
+  return Block::make(allocate, clear);
+}
+
+Stmt HashedModeFormat::getInsertFinalizeLevel(Expr szPrev, Expr sz,
+                                              Mode mode) const {
+  return Stmt();
+}
+
+vector<Expr> HashedModeFormat::getArrays(Expr tensor, int mode,
+                                         int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_size"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_crd")};
+}
+
+int HashedModeFormat::getTableSize() const {
+  return tableSize;
+}
+
+Expr HashedModeFormat::getCoordArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+Expr HashedModeFormat::hash(Expr coord, Datatype type) const {
+  int bits = 0;
+  while ((1 << bits) < tableSize) {
+    bits++;
+  }
+  return Cast::make(Call::make("TACO_HASH", {coord, 32 - bits}, Int32), type);
+}
+
+bool HashedModeFormat::equals(const ModeFormatImpl& other) const {
+  return ModeFormatImpl::equals(other) &&
+         (dynamic_cast<const HashedModeFormat&>(other).tableSize == tableSize);
+}
+
+}
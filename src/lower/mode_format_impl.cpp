@@ -154,6 +154,26 @@ Stmt ModeFormatImpl::getAppendFinalizeLevel(Expr szPrev,
   return Stmt();
 }
 
+bool ModeFormatImpl::hasParallelAppend(Mode mode) const {
+  return false;
+}
+
+Expr ModeFormatImpl::getAppendBegin(Expr pPrev, Mode mode) const {
+  return Expr();
+}
+
+Stmt ModeFormatImpl::getAppendScanLevel(Expr szPrev, Mode mode) const {
+  return Stmt();
+}
+
+Stmt ModeFormatImpl::getAppendFillCoord(Expr p, Expr i, Mode mode) const {
+  return Stmt();
+}
+
+bool ModeFormatImpl::hasFixedSize() const {
+  return false;
+}
+
 bool ModeFormatImpl::equals(const ModeFormatImpl& other) const {
   return (isFull == other.isFull &&
           isOrdered == other.isOrdered &&
@@ -0,0 +1,52 @@
+#include "taco/lower/mode_format_tile.h"
+
+#include "taco/error.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+TileModeFormat::TileModeFormat() : TileModeFormat(true, true) {
+}
+
+TileModeFormat::TileModeFormat(const bool isOrdered, const bool isUnique) :
+    DenseModeFormat(isOrdered, isUnique) {
+}
+
+ModeFormat TileModeFormat::copy(
+    std::vector<ModeFormat::Property> properties) const {
+  bool isOrdered = this->isOrdered;
+  bool isUnique = this->isUnique;
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::ORDERED:
+        isOrdered = true;
+        break;
+      case ModeFormat::NOT_ORDERED:
+        isOrdered = false;
+        break;
+      case ModeFormat::UNIQUE:
+        isUnique = true;
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        isUnique = false;
+        break;
+      default:
+        break;
+    }
+  }
+  return ModeFormat(std::make_shared<TileModeFormat>(isOrdered, isUnique));
+}
+
+Expr TileModeFormat::getWidth(Mode mode) const {
+  taco_uassert(mode.getSize().isFixed()) <<
+      "The size of a tile mode must be known when the kernel is generated";
+  return (int)mode.getSize().getSize();
+}
+
+bool TileModeFormat::hasFixedSize() const {
+  return true;
+}
+
+}
@@ -15,13 +15,15 @@ namespace taco {
 
 struct Array::Content : util::Uncopyable {
   Datatype   type;
-  void*  data;
-  size_t size;
+  void*  data = nullptr;
+  size_t size = 0;
   Policy policy = Array::UserOwns;
+  std::shared_ptr<void> mapping;
 
   ~Content() {
     switch (policy) {
       case UserOwns:
+      case Mmap:
         // do nothing
         break;
       case Free:
@@ -98,6 +100,12 @@ Array::Array(Datatype type, void* data, size_t size, Policy policy) : Array() {
   content->policy = policy;
 }
 
+Array::Array(Datatype type, void* data, size_t size,
+             std::shared_ptr<void> mapping)
+    : Array(type, data, size, Mmap) {
+  content->mapping = mapping;
+}
+
 const Datatype& Array::getType() const {
   return content->type;
 }
@@ -106,6 +114,10 @@ size_t Array::getSize() const {
   return content->size;
 }
 
+Array::Policy Array::getPolicy() const {
+  return content->policy;
+}
+
 const void* Array::getData() const {
   return content->data;
 }
@@ -126,15 +138,17 @@ void Array::zero() {
   memset(getData(), 0, getSize() * getType().getNumBytes());
 }
 
-template<typename T>
+// Prints the elements as type P, so that 8-bit integers are not printed as
+// characters
+template<typename T, typename P=T>
 void printData(ostream& os, const Array& array) {
   const T* data = static_cast<const T*>(array.getData());
   os << "[";
   if (array.getSize() > 0) {
-    os << data[0];
+    os << (P)data[0];
   }
   for (size_t i = 1; i < array.getSize(); i++) {
-    os << ", " << data[i];
+    os << ", " << (P)data[i];
   }
   os << "]";
 }
@@ -146,7 +160,7 @@ std::ostream& operator<<(std::ostream& os, const Array& array) {
       printData<bool>(os, array);
       break;
     case Datatype::UInt8:
-      printData<uint8_t>(os, array);
+      printData<uint8_t,int>(os, array);
       break;
     case Datatype::UInt16:
       printData<uint16_t>(os, array);
@@ -161,7 +175,7 @@ std::ostream& operator<<(std::ostream& os, const Array& array) {
       printData<unsigned long long>(os, array);
       break;
     case Datatype::Int8:
-      printData<int8_t>(os, array);
+      printData<int8_t,int>(os, array);
       break;
     case Datatype::Int16:
       printData<int16_t>(os, array);
@@ -205,6 +219,9 @@ std::ostream& operator<<(std::ostream& os, Array::Policy policy) {
     case Array::Delete:
       os << "delete";
       break;
+    case Array::Mmap:
+      os << "mmap";
+      break;
   }
   return os;
 }
@@ -5,6 +5,8 @@
 #include <sstream>
 #include <cstdlib>
 #include <climits>
+#include <iterator>
+#include <memory>
 
 #include "taco/tensor.h"
 #include "taco/format.h"
@@ -12,57 +14,278 @@
 #include "taco/util/strings.h"
 #include "taco/util/timers.h"
 #include "taco/util/files.h"
+#include "text_parser.h"
 
 using namespace std;
 
 namespace taco {
 
+namespace {
+enum class MTXField {Real, Integer, Pattern};
+enum class MTXSymmetry {General, Symmetric, SkewSymmetric};
+
+/// The components parsed from a chunk of lines of an mtx file, including the
+/// mirrored components of symmetric matrices.
+struct MTXChunk {
+  std::vector<std::vector<int>> coordinates;
+  std::vector<double> values;
+  size_t numEntries = 0;
+  const char* error = nullptr;
+};
+}
+
+static std::istream& operator>>(std::istream& stream, MTXField& field) {
+  string name;
+  stream >> name;
+  if (name == "real") {
+    field = MTXField::Real;
+  } else if (name == "integer") {
+    field = MTXField::Integer;
+  } else if (name == "pattern") {
+    field = MTXField::Pattern;
+  } else {
+    taco_uerror << "MatrixMarket field not available";
+  }
+  return stream;
+}
+
+static std::istream& operator>>(std::istream& stream, MTXSymmetry& symmetry) {
+  string name;
+  stream >> name;
+  if (name == "general") {
+    symmetry = MTXSymmetry::General;
+  } else if (name == "symmetric") {
+    symmetry = MTXSymmetry::Symmetric;
+  } else if (name == "skew-symmetric") {
+    symmetry = MTXSymmetry::SkewSymmetric;
+  } else {
+    taco_uerror << "MatrixMarket symmetry not available";
+  }
+  return stream;
+}
+
+/// Parse the size line that follows the comments at `begin`, and return the
+/// start of the line after it.
+static const char* parseMTXSizeLine(const char* begin, const char* end,
+                                    std::vector<long long>& sizes) {
+  while (begin < end && isBlankLine(begin, end, "%")) {
+    begin = skipLine(begin, end);
+  }
+  const char* lineEnd = skipLine(begin, end);
+  long long size;
+  for (const char* p = begin; parseInt(p, lineEnd, size);) {
+    // Empty coordinate matrices have zero stored components
+    taco_uassert(size >= 0) << "Malformed MatrixMarket size line";
+    taco_uassert(size <= INT_MAX) << "Dimension exceeds INT_MAX";
+    sizes.push_back(size);
+  }
+  return lineEnd;
+}
+
+static void parseMTXLines(const char* begin, const char* end, size_t order,
+                          MTXField field, MTXSymmetry symmetry,
+                          MTXChunk& chunk) {
+  chunk.coordinates.resize(order);
+  std::vector<int> coordinate(order);
+  for (const char* line = begin; line < end; line = skipLine(line, end)) {
+    if (isBlankLine(line, end, "%")) {
+      continue;
+    }
+    const char* p = line;
+    for (size_t i = 0; i < order; i++) {
+      long long index;
+      if (!parseInt(p, end, index) || index > INT_MAX) {
+        chunk.error = line;
+        return;
+      }
+      coordinate[i] = (int)index - 1;
+      chunk.coordinates[i].push_back(coordinate[i]);
+    }
+    double val = 1.0;
+    if (field != MTXField::Pattern && !parseDouble(p, end, val)) {
+      chunk.error = line;
+      return;
+    }
+    chunk.values.push_back(val);
+    chunk.numEntries++;
+
+    if (symmetry != MTXSymmetry::General && coordinate[0] != coordinate[1]) {
+      chunk.coordinates[0].push_back(coordinate[1]);
+      chunk.coordinates[1].push_back(coordinate[0]);
+      chunk.values.push_back(symmetry == MTXSymmetry::SkewSymmetric ? -val
+                                                                    : val);
+    }
+  }
+}
+
+/// Parse the lines in [begin,end) in parallel and return their components.
+static std::vector<MTXChunk> parseMTXBlock(const char* begin, const char* end,
+                                           size_t order, MTXField field,
+                                           MTXSymmetry symmetry) {
+  auto chunks = splitLines(begin, end, getNumParseThreads(end - begin));
+  std::vector<MTXChunk> parsed(chunks.size() - 1);
+  parseChunks(chunks, [&](int c, const char* chunkBegin, const char* chunkEnd) {
+    parseMTXLines(chunkBegin, chunkEnd, order, field, symmetry, parsed[c]);
+  });
+  for (auto& chunk : parsed) {
+    if (chunk.error != nullptr) {
+      taco_uerror << "Malformed line in MatrixMarket file: " <<
+          std::string(chunk.error, skipLine(chunk.error, end) - chunk.error);
+    }
+  }
+  return parsed;
+}
+
 template <typename T>
-TensorBase dispatchReadMTX(std::string filename, const T& format, bool pack) {
-  std::fstream file;
-  util::openStream(file, filename, fstream::in);
-  TensorBase tensor = readMTX(file, format, pack);
-  file.close();
+static TensorBase readMTXCoordinates(const char* begin, const char* end,
+                                     const T& format, MTXField field,
+                                     MTXSymmetry symmetry) {
+  // The first non-comment line is the header with dimensions and the number
+  // of stored components
+  std::vector<long long> sizes;
+  begin = parseMTXSizeLine(begin, end, sizes);
+  taco_uassert(sizes.size() >= 2) << "Malformed MatrixMarket size line";
+  const size_t nnz = sizes.back();
+  const std::vector<int> dimensions(sizes.begin(), sizes.end() - 1);
+  const size_t order = dimensions.size();
+  taco_uassert(symmetry == MTXSymmetry::General || order == 2) <<
+      "Symmetry only available for matrix";
+
+  // Symmetric matrices store at most half of their components
+  const size_t capacity = (symmetry == MTXSymmetry::General) ? nnz : 2*nnz;
+  std::vector<std::unique_ptr<ArrayBuilder<int>>> coordinates;
+  for (size_t i = 0; i < order; i++) {
+    coordinates.emplace_back(new ArrayBuilder<int>());
+    coordinates[i]->reserve(capacity);
+  }
+  ArrayBuilder<double> values;
+  values.reserve(capacity);
+
+  size_t numEntries = 0;
+  for (auto& chunk : parseMTXBlock(begin, end, order, field, symmetry)) {
+    for (size_t i = 0; i < order; i++) {
+      coordinates[i]->append(chunk.coordinates[i].data(),
+                             chunk.coordinates[i].size());
+    }
+    values.append(chunk.values.data(), chunk.values.size());
+    numEntries += chunk.numEntries;
+  }
+  taco_uassert(numEntries == nnz) << "MatrixMarket file has " << numEntries <<
+      " components instead of " << nnz;
+
+  TensorBase tensor(type<double>(), dimensions, format);
+  std::vector<Array> coordinateArrays;
+  for (auto& modeCoordinates : coordinates) {
+    coordinateArrays.push_back(modeCoordinates->release());
+  }
+  tensor.insertComponents(coordinateArrays, values.release());
   return tensor;
 }
 
-TensorBase readMTX(std::string filename, const ModeFormat& modetype, bool pack) {
-  return dispatchReadMTX(filename, modetype, pack);
-}
+template <typename T>
+static TensorBase readMTXArray(const char* begin, const char* end,
+                               const T& format, MTXField field,
+                               MTXSymmetry symmetry) {
+  taco_uassert(field != MTXField::Pattern) <<
+      "MatrixMarket arrays cannot have the pattern field";
 
-TensorBase readMTX(std::string filename, const Format& format, bool pack) {
-  return dispatchReadMTX(filename, format, pack);
+  // The first non-comment line is the header with dimension sizes
+  std::vector<long long> sizes;
+  begin = parseMTXSizeLine(begin, end, sizes);
+  const std::vector<int> dimensions(sizes.begin(), sizes.end());
+  const size_t order = dimensions.size();
+  taco_uassert(symmetry == MTXSymmetry::General ||
+               (order == 2 && dimensions[0] == dimensions[1])) <<
+      "Symmetry only available for square matrix";
+
+  std::vector<double> values;
+  for (auto& chunk : parseMTXBlock(begin, end, 0, MTXField::Real,
+                                   MTXSymmetry::General)) {
+    values.insert(values.end(), chunk.values.begin(), chunk.values.end());
+  }
+
+  // Values are stored in column-major order, and only the lower triangle (of
+  // skew-symmetric matrices without the diagonal) is stored for symmetric
+  // matrices
+  const int diagonal = (symmetry == MTXSymmetry::SkewSymmetric) ? 1 : 0;
+  size_t numValues = 1;
+  for (int dimension : dimensions) {
+    numValues *= dimension;
+  }
+  if (symmetry != MTXSymmetry::General) {
+    size_t n = dimensions[0] - diagonal;
+    numValues = n * (n + 1) / 2;
+  }
+  taco_uassert(values.size() >= numValues) << "MatrixMarket file has " <<
+      values.size() << " values instead of " << numValues;
+  values.resize(numValues);
+
+  std::vector<std::vector<int>> coordinates(order);
+  std::vector<double> componentValues;
+  if (symmetry == MTXSymmetry::General) {
+    std::vector<int> coordinate(order, 0);
+    for (size_t n = 0; n < numValues; n++) {
+      if (n > 0) {
+        for (size_t i = 0; i < order && ++coordinate[i] == dimensions[i]; i++) {
+          coordinate[i] = 0;
+        }
+      }
+      for (size_t i = 0; i < order; i++) {
+        coordinates[i].push_back(coordinate[i]);
+      }
+    }
+    componentValues = std::move(values);
+  } else {
+    const double sign = (symmetry == MTXSymmetry::SkewSymmetric) ? -1.0 : 1.0;
+    size_t n = 0;
+    for (int j = 0; j < dimensions[1]; j++) {
+      for (int i = j + diagonal; i < dimensions[0]; i++, n++) {
+        coordinates[0].push_back(i);
+        coordinates[1].push_back(j);
+        componentValues.push_back(values[n]);
+        if (i != j) {
+          coordinates[0].push_back(j);
+          coordinates[1].push_back(i);
+          componentValues.push_back(sign * values[n]);
+        }
+      }
+    }
+  }
+
+  TensorBase tensor(type<double>(), dimensions, format);
+  std::vector<Array> coordinateArrays;
+  for (auto& modeCoordinates : coordinates) {
+    coordinateArrays.push_back(makeArray(modeCoordinates));
+  }
+  tensor.insertComponents(coordinateArrays, makeArray(componentValues));
+  return tensor;
 }
 
+/// Parse an mtx file held in [begin,end).
 template <typename T>
-TensorBase dispatchReadMTX(std::istream& stream, const T& format, bool pack) {
-  string line;
-  if (!std::getline(stream, line)) {
+static TensorBase parseMTX(const char* begin, const char* end, const T& format,
+                           bool pack) {
+  if (begin == end) {
     return TensorBase();
   }
 
   // Read Header
-  std::stringstream lineStream(line);
-  string head, type, formats, field, symmetry;
+  const char* headerEnd = skipLine(begin, end);
+  std::stringstream lineStream(std::string(begin, headerEnd - begin));
+  string head, type, formats;
+  MTXField field;
+  MTXSymmetry symmetry;
   lineStream >> head >> type >> formats >> field >> symmetry;
   taco_uassert(head=="%%MatrixMarket") << "Unknown header of MatrixMarket";
   // type = [matrix tensor]
   taco_uassert((type=="matrix") || (type=="tensor"))
                                        << "Unknown type of MatrixMarket";
-  // formats = [coordinate array]
-  // field = [real integer complex pattern]
-  taco_uassert(field=="real")          << "MatrixMarket field not available";
-  // symmetry = [general symmetric skew-symmetric Hermitian]
-  taco_uassert((symmetry=="general") || (symmetry=="symmetric"))
-                                       << "MatrixMarket symmetry not available";
-
-  bool symm = (symmetry=="symmetric");
 
   TensorBase tensor;
   if (formats=="coordinate")
-    tensor = readSparse(stream,format,symm);
+    tensor = readMTXCoordinates(headerEnd, end, format, field, symmetry);
   else if (formats=="array")
-    tensor = readDense(stream,format,symm);
+    tensor = readMTXArray(headerEnd, end, format, field, symmetry);
   else
     taco_uerror << "MatrixMarket format not available";
 
@@ -73,6 +296,32 @@ TensorBase dispatchReadMTX(std::istream& stream, const T& format, bool pack) {
   return tensor;
 }
 
+template <typename T>
+TensorBase dispatchReadMTX(std::string filename, const T& format, bool pack) {
+  util::MappedFile file(filename);
+  const char* data = file.map(0, file.getSize());
+  return parseMTX(data, data + file.getSize(), format, pack);
+}
+
+TensorBase readMTX(std::string filename, const ModeFormat& modetype, bool pack) {
+  return dispatchReadMTX(filename, modetype, pack);
+}
+
+TensorBase readMTX(std::string filename, const Format& format, bool pack) {
+  return dispatchReadMTX(filename, format, pack);
+}
+
+static std::string readStream(std::istream& stream) {
+  return std::string(std::istreambuf_iterator<char>(stream),
+                     std::istreambuf_iterator<char>());
+}
+
+template <typename T>
+TensorBase dispatchReadMTX(std::istream& stream, const T& format, bool pack) {
+  std::string data = readStream(stream);
+  return parseMTX(data.data(), data.data() + data.size(), format, pack);
+}
+
 TensorBase readMTX(std::istream& stream, const ModeFormat& modetype, bool pack) {
   return dispatchReadMTX(stream, modetype, pack);
 }
@@ -81,153 +330,34 @@ TensorBase readMTX(std::istream& stream, const Format& format, bool pack) {
   return dispatchReadMTX(stream, format, pack);
 }
 
-template <typename T>
-TensorBase dispatchReadSparse(std::istream& stream, const T& format, 
-                              bool symm) {
-  string line;
-  std::getline(stream,line);
-
-  // Skip comments at the top of the file
-  string token;
-  do {
-    std::stringstream lineStream(line);
-    lineStream >> token;
-    if (token[0] != '%') {
-      break;
-    }
-  } while (std::getline(stream, line));
-
-  // The first non-comment line is the header with dimensions
-  vector<int> dimensions;
-  char* linePtr = (char*)line.data();
-  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
-    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
-    dimensions.push_back(static_cast<int>(dimension));
-  }
-  size_t nnz = dimensions[dimensions.size()-1];
-  dimensions.pop_back();
-  if (symm)
-    taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
-
-  vector<int> coordinates;
-  vector<double> values;
-  coordinates.reserve(nnz*dimensions.size());
-  values.reserve(nnz);
-
-  while (std::getline(stream, line)) {
-    linePtr = (char*)line.data();
-    for (size_t i=0; i < dimensions.size(); i++) {
-      long index = strtol(linePtr, &linePtr, 10);
-      taco_uassert(index <= INT_MAX) << "Index exceeds INT_MAX";
-      coordinates.push_back(static_cast<int>(index));
-    }
-    double val = strtod(linePtr, &linePtr);
-    values.push_back(val);
-  }
-
-  // Create matrix
-  TensorBase tensor(type<double>(), dimensions, format);
-  if (symm)
-    tensor.reserve(2*nnz);
-  else
-    tensor.reserve(nnz);
-
-  // Insert coordinates
-  std::vector<int> coord;
-  for (size_t i = 0; i < nnz; i++) {
-    coord.clear();
-    for (size_t mode = 0; mode < dimensions.size(); mode++) {
-      coord.push_back(coordinates[i*dimensions.size() + mode] -1);
-    }
-    tensor.insert(coord, values[i]);
-    if (symm && coord.front() != coord.back()) {
-      std::reverse(coord.begin(), coord.end());
-      tensor.insert(coord, values[i]);
-    }
-  }
-
-  return tensor;
+static MTXSymmetry getSymmetry(bool symm) {
+  return symm ? MTXSymmetry::Symmetric : MTXSymmetry::General;
 }
 
 TensorBase readSparse(std::istream& stream, const ModeFormat& modetype, 
                       bool symm) {
-  return dispatchReadSparse(stream, modetype, symm);
+  std::string data = readStream(stream);
+  return readMTXCoordinates(data.data(), data.data() + data.size(), modetype,
+                            MTXField::Real, getSymmetry(symm));
 }
 
 TensorBase readSparse(std::istream& stream, const Format& format, bool symm) {
-  return dispatchReadSparse(stream, format, symm);
-}
-
-template <typename T>
-TensorBase dispatchReadDense(std::istream& stream, const T& format, bool symm) {
-  string line;
-  std::getline(stream,line);
-
-  // Skip comments at the top of the file
-  string token;
-  do {
-    std::stringstream lineStream(line);
-    lineStream >> token;
-    if (token[0] != '%') {
-      break;
-    }
-  } while (std::getline(stream, line));
-
-  // The first non-comment line is the header with dimension sizes
-  vector<int> dimensions;
-  char* linePtr = (char*)line.data();
-  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
-    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
-    dimensions.push_back(static_cast<int>(dimension));
-  }
-  if (symm)
-    taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
-
-  vector<double> values;
-  auto size = std::accumulate(begin(dimensions), end(dimensions),
-                              1, std::multiplies<double>());
-  values.reserve(size);
-
-  while (std::getline(stream, line)) {
-    linePtr = (char*)line.data();
-    double val = strtod(linePtr, &linePtr);
-    values.push_back(val);
-  }
-
-  // Create matrix
-  TensorBase tensor(type<double>(), dimensions, format);
-  if (symm)
-    tensor.reserve(2*size);
-  else
-    tensor.reserve(size);
-
-  // Insert coordinates
-  std::vector<int> coord;
-  for (auto n = 0; n<size; n++) {
-    coord.clear();
-    auto index=n;
-    for (size_t mode = 0; mode < dimensions.size()-1; mode++) {
-      coord.push_back(index%dimensions[mode]);
-      index=index/dimensions[mode];
-    }
-    coord.push_back(index);
-    tensor.insert(coord, values[n]);
-    if (symm && coord.front() != coord.back()) {
-      std::reverse(coord.begin(), coord.end());
-      tensor.insert(coord, values[n]);
-    }
-  }
-
-  return tensor;
+  std::string data = readStream(stream);
+  return readMTXCoordinates(data.data(), data.data() + data.size(), format,
+                            MTXField::Real, getSymmetry(symm));
 }
 
 TensorBase readDense(std::istream& stream, const ModeFormat& modetype, 
                      bool symm) {
-  return dispatchReadDense(stream, modetype, symm);
+  std::string data = readStream(stream);
+  return readMTXArray(data.data(), data.data() + data.size(), modetype,
+                      MTXField::Real, getSymmetry(symm));
 }
 
 TensorBase readDense(std::istream& stream, const Format& format, bool symm) {
-  return dispatchReadDense(stream, format, symm);
+  std::string data = readStream(stream);
+  return readMTXArray(data.data(), data.data() + data.size(), format,
+                      MTXField::Real, getSymmetry(symm));
 }
 
 void writeMTX(std::string filename, const TensorBase& tensor) {
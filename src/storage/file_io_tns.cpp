@@ -7,77 +7,140 @@
 #include <vector>
 #include <cmath>
 #include <climits>
+#include <cstring>
+#include <memory>
 
 #include "taco/tensor.h"
 #include "taco/format.h"
 #include "taco/error.h"
 #include "taco/util/strings.h"
 #include "taco/util/files.h"
+#include "text_parser.h"
 
 using namespace std;
 
 namespace taco {
 
-template <typename T>
-TensorBase dispatchReadTNS(std::string filename, const T& format, bool pack) {
-  std::fstream file;
-  util::openStream(file, filename, fstream::in);
-  TensorBase tensor = readTNS(file, format, pack);
-  file.close();
-  return tensor;
-}
+/// Files are read in blocks of this size, so that the text of files that are
+/// larger than memory never has to be resident at once.
+static const size_t TNS_BLOCK_SIZE = 1 << 26;
 
-TensorBase readTNS(std::string filename, const ModeFormat& modetype, bool pack) {
-  return dispatchReadTNS(filename, modetype, pack);
-}
+namespace {
+/// The components parsed from a chunk of lines of a tns file.
+struct TNSChunk {
+  std::vector<std::vector<int>> coordinates;
+  std::vector<double> values;
+  std::vector<int> dimensions;
+  const char* error = nullptr;
+};
 
-TensorBase readTNS(std::string filename, const Format& format, bool pack) {
-  return dispatchReadTNS(filename, format, pack);
+/// The components parsed from all blocks of a tns file.
+struct TNSComponents {
+  int order = -1;
+  std::vector<int> dimensions;
+  std::vector<std::unique_ptr<ArrayBuilder<int>>> coordinates;
+  ArrayBuilder<double> values;
+};
 }
 
-template <typename T>
-TensorBase dispatchReadTNS(std::istream& stream, const T& format, bool pack) {
-  std::vector<int>    coordinates;
-  std::vector<double> values;
-
-  std::string line;
-  if (!std::getline(stream, line)) {
-    return TensorBase();
+static void parseTNSLines(const char* begin, const char* end, int order,
+                          TNSChunk& chunk) {
+  chunk.coordinates.resize(order);
+  chunk.dimensions.resize(order, 0);
+  for (const char* line = begin; line < end; line = skipLine(line, end)) {
+    if (isBlankLine(line, end, "#")) {
+      continue;
+    }
+    const char* p = line;
+    for (int i = 0; i < order; i++) {
+      long long idx;
+      if (!parseInt(p, end, idx) || idx > INT_MAX) {
+        chunk.error = line;
+        return;
+      }
+      chunk.coordinates[i].push_back((int)idx - 1);
+      chunk.dimensions[i] = std::max(chunk.dimensions[i], (int)idx);
+    }
+    double val;
+    if (!parseDouble(p, end, val)) {
+      chunk.error = line;
+      return;
+    }
+    chunk.values.push_back(val);
   }
+}
 
+/// Parse the lines in [begin,end) in parallel and append their components.
+static void parseTNSBlock(const char* begin, const char* end,
+                          TNSComponents& components) {
   // Infer tensor order from the first coordinate
-  vector<string> toks = util::split(line, " ");
-  size_t order = toks.size()-1;
-  std::vector<int> dimensions(order);
-  std::vector<int> coordinate(order);
-
-  // Load data
-  do {
-    char* linePtr = (char*)line.data();
-    for (size_t i = 0; i < order; i++) {
-      long idx = strtol(linePtr, &linePtr, 10);
-      taco_uassert(idx <= INT_MAX)<<"Coordinate in file is larger than INT_MAX";
-      coordinate[i] = (int)idx - 1;
-      dimensions[i] = std::max(dimensions[i], (int)idx);
+  if (components.order == -1) {
+    while (begin < end && isBlankLine(begin, end, "#")) {
+      begin = skipLine(begin, end);
     }
-    coordinates.insert(coordinates.end(), coordinate.begin(), coordinate.end());
-    double val = strtod(linePtr, &linePtr);
-    values.push_back(val);
-
-  } while (std::getline(stream, line));
+    if (begin == end) {
+      return;
+    }
+    int numTokens = 0;
+    for (const char* p = skipSpaces(begin, end); p < end && *p != '\n';
+         p = skipSpaces(p, end)) {
+      numTokens++;
+      while (p < end && !isspace((unsigned char)*p)) {
+        p++;
+      }
+    }
+    components.order = numTokens - 1;
+    components.dimensions.resize(components.order, 0);
+    for (int i = 0; i < components.order; i++) {
+      components.coordinates.emplace_back(new ArrayBuilder<int>());
+    }
+  }
 
-  // Create tensor
-  const size_t nnz = values.size();
-  TensorBase tensor(type<double>(), dimensions, format);
-  tensor.reserve(nnz);
+  const int order = components.order;
+  auto chunks = splitLines(begin, end, getNumParseThreads(end - begin));
+  std::vector<TNSChunk> parsed(chunks.size() - 1);
+  parseChunks(chunks, [&](int c, const char* chunkBegin, const char* chunkEnd) {
+    parseTNSLines(chunkBegin, chunkEnd, order, parsed[c]);
+  });
 
-  // Insert coordinates (TODO add and use bulk insertion)
-  for (size_t i = 0; i < nnz; i++) {
-    for (size_t j = 0; j < order; j++) {
-      coordinate[j] = coordinates[i*order + j];
+  for (auto& chunk : parsed) {
+    if (chunk.error != nullptr) {
+      taco_uerror << "Malformed line in tns file: " <<
+          std::string(chunk.error, skipLine(chunk.error, end) - chunk.error);
+    }
+    for (int i = 0; i < order; i++) {
+      components.coordinates[i]->append(chunk.coordinates[i].data(),
+                                        chunk.coordinates[i].size());
+      components.dimensions[i] = std::max(components.dimensions[i],
+                                          chunk.dimensions[i]);
     }
-    tensor.insert(coordinate, values[i]);
+    components.values.append(chunk.values.data(), chunk.values.size());
+  }
+}
+
+/// Returns the end of the last complete line in [begin,end).
+static const char* findLastLineEnd(const char* begin, const char* end) {
+  const char* p = end;
+  while (p > begin && *(p - 1) != '\n') {
+    p--;
+  }
+  taco_uassert(p > begin) << "Line in tns file is longer than " <<
+                             TNS_BLOCK_SIZE << " bytes";
+  return p;
+}
+
+template <typename T>
+static TensorBase makeTNSTensor(TNSComponents& components, const T& format,
+                                bool pack) {
+  if (components.order == -1) {
+    return TensorBase();
   }
+  TensorBase tensor(type<double>(), components.dimensions, format);
+  std::vector<Array> coordinateArrays;
+  for (auto& coordinates : components.coordinates) {
+    coordinateArrays.push_back(coordinates->release());
+  }
+  tensor.insertComponents(coordinateArrays, components.values.release());
 
   if (pack) {
     tensor.pack();
@@ -86,6 +149,52 @@ TensorBase dispatchReadTNS(std::istream& stream, const T& format, bool pack) {
   return tensor;
 }
 
+template <typename T>
+TensorBase dispatchReadTNS(std::string filename, const T& format, bool pack) {
+  util::MappedFile file(filename);
+  TNSComponents components;
+  for (size_t offset = 0; offset < file.getSize();) {
+    size_t size = std::min(TNS_BLOCK_SIZE, file.getSize() - offset);
+    const char* block = file.map(offset, size);
+    const char* blockEnd = block + size;
+    if (offset + size < file.getSize()) {
+      blockEnd = findLastLineEnd(block, blockEnd);
+    }
+    parseTNSBlock(block, blockEnd, components);
+    offset += blockEnd - block;
+  }
+  file.unmap();
+  return makeTNSTensor(components, format, pack);
+}
+
+TensorBase readTNS(std::string filename, const ModeFormat& modetype, bool pack) {
+  return dispatchReadTNS(filename, modetype, pack);
+}
+
+TensorBase readTNS(std::string filename, const Format& format, bool pack) {
+  return dispatchReadTNS(filename, format, pack);
+}
+
+template <typename T>
+TensorBase dispatchReadTNS(std::istream& stream, const T& format, bool pack) {
+  std::unique_ptr<char[]> buffer(new char[TNS_BLOCK_SIZE]);
+  TNSComponents components;
+  size_t size = 0;
+  while (stream) {
+    stream.read(&buffer[size], TNS_BLOCK_SIZE - size);
+    size += stream.gcount();
+    const char* blockEnd = stream ? findLastLineEnd(&buffer[0], &buffer[size])
+                                  : &buffer[size];
+    parseTNSBlock(&buffer[0], blockEnd, components);
+
+    // Move the incomplete last line to the front of the buffer
+    size_t parsedSize = blockEnd - &buffer[0];
+    memmove(&buffer[0], blockEnd, size - parsedSize);
+    size -= parsedSize;
+  }
+  return makeTNSTensor(components, format, pack);
+}
+
 TensorBase readTNS(std::istream& stream, const ModeFormat& modetype, bool pack) {
   return dispatchReadTNS(stream, modetype, pack);
 }
@@ -0,0 +1,495 @@
+#include "taco/storage/file_io_ttb.h"
+
+#include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <climits>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "taco/tensor.h"
+#include "taco/format.h"
+#include "taco/error.h"
+#include "taco/storage/storage.h"
+#include "taco/storage/index.h"
+#include "taco/storage/array.h"
+#include "taco/util/files.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+
+namespace taco {
+
+namespace {
+const char     TTB_MAGIC[8]   = {'T', 'A', 'C', 'O', 'T', 'T', 'B', '\0'};
+const uint32_t TTB_VERSION    = 1;
+const uint32_t TTB_BYTE_ORDER = 0x01020304;
+
+/// Arrays start at cache line boundaries of the file, and therefore of the
+/// memory it is mapped into.
+const uint64_t TTB_ALIGNMENT  = 64;
+
+enum TTBProperty : uint32_t {
+  TTB_FULL = 1, TTB_ORDERED = 2, TTB_UNIQUE = 4, TTB_BRANCHLESS = 8,
+  TTB_COMPACT = 16
+};
+
+/// An array stored in a ttb file, at an offset from the start of the file.
+struct TTBArray {
+  Datatype type;
+  uint64_t size;
+  uint64_t offset;
+};
+
+/// A level stored in a ttb file.
+struct TTBLevel {
+  std::string name;
+  uint32_t properties;
+  int32_t tableSize;
+  std::vector<TTBArray> arrays;
+};
+
+/// The header of a ttb file, which describes the format, the dimensions and
+/// the arrays of the tensor. The arrays follow the header in the order they
+/// are described in.
+struct TTBHeader {
+  Datatype componentType;
+  std::vector<int> dimensions;
+  std::vector<int> modeOrdering;
+  std::vector<uint32_t> packSizes;
+  std::vector<std::vector<Datatype>> levelArrayTypes;
+  std::vector<TTBLevel> levels;
+  TTBArray values;
+};
+}
+
+template <typename T>
+static void writeValue(std::ostream& stream, T value) {
+  stream.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+static T readValue(std::istream& stream) {
+  T value;
+  stream.read((char*)&value, sizeof(T));
+  taco_uassert(!stream.fail()) << "Unexpected end of ttb file";
+  return value;
+}
+
+static void writeType(std::ostream& stream, Datatype type) {
+  writeValue<uint32_t>(stream, type.getKind());
+}
+
+static Datatype readType(std::istream& stream) {
+  uint32_t kind = readValue<uint32_t>(stream);
+  taco_uassert(kind < Datatype::Undefined) << "Invalid type in ttb file";
+  return Datatype((Datatype::Kind)kind);
+}
+
+static void writeArray(std::ostream& stream, const TTBArray& array) {
+  writeType(stream, array.type);
+  writeValue<uint64_t>(stream, array.size);
+  writeValue<uint64_t>(stream, array.offset);
+}
+
+static TTBArray readArray(std::istream& stream) {
+  TTBArray array;
+  array.type = readType(stream);
+  array.size = readValue<uint64_t>(stream);
+  array.offset = readValue<uint64_t>(stream);
+  return array;
+}
+
+static uint32_t getProperties(const ModeFormat& modeFormat) {
+  return (modeFormat.isFull()       ? (uint32_t)TTB_FULL       : 0u) |
+         (modeFormat.isOrdered()    ? (uint32_t)TTB_ORDERED    : 0u) |
+         (modeFormat.isUnique()     ? (uint32_t)TTB_UNIQUE     : 0u) |
+         (modeFormat.isBranchless() ? (uint32_t)TTB_BRANCHLESS : 0u) |
+         (modeFormat.isCompact()    ? (uint32_t)TTB_COMPACT    : 0u);
+}
+
+static void writeHeader(std::ostream& stream, const TTBHeader& header) {
+  stream.write(TTB_MAGIC, sizeof(TTB_MAGIC));
+  writeValue<uint32_t>(stream, TTB_VERSION);
+  writeValue<uint32_t>(stream, TTB_BYTE_ORDER);
+  writeType(stream, header.componentType);
+  writeValue<uint32_t>(stream, header.dimensions.size());
+  for (int dimension : header.dimensions) {
+    writeValue<int64_t>(stream, dimension);
+  }
+  for (int mode : header.modeOrdering) {
+    writeValue<int32_t>(stream, mode);
+  }
+  writeValue<uint32_t>(stream, header.packSizes.size());
+  for (uint32_t packSize : header.packSizes) {
+    writeValue<uint32_t>(stream, packSize);
+  }
+  writeValue<uint32_t>(stream, header.levelArrayTypes.size());
+  for (auto& arrayTypes : header.levelArrayTypes) {
+    writeValue<uint32_t>(stream, arrayTypes.size());
+    for (auto& type : arrayTypes) {
+      writeType(stream, type);
+    }
+  }
+  for (auto& level : header.levels) {
+    writeValue<uint32_t>(stream, level.name.size());
+    stream.write(level.name.data(), level.name.size());
+    writeValue<uint32_t>(stream, level.properties);
+    writeValue<int32_t>(stream, level.tableSize);
+    writeValue<uint32_t>(stream, level.arrays.size());
+    for (auto& array : level.arrays) {
+      writeArray(stream, array);
+    }
+  }
+  writeArray(stream, header.values);
+}
+
+static TTBHeader readHeader(std::istream& stream) {
+  char magic[sizeof(TTB_MAGIC)];
+  stream.read(magic, sizeof(magic));
+  taco_uassert(!stream.fail() &&
+               equal(magic, magic + sizeof(magic), TTB_MAGIC)) <<
+      "Not a ttb file";
+  uint32_t version = readValue<uint32_t>(stream);
+  taco_uassert(version <= TTB_VERSION) <<
+      "Unsupported ttb file version " << version;
+  taco_uassert(readValue<uint32_t>(stream) == TTB_BYTE_ORDER) <<
+      "The ttb file was written on a machine with a different byte order";
+
+  TTBHeader header;
+  header.componentType = readType(stream);
+  uint32_t order = readValue<uint32_t>(stream);
+  for (uint32_t i = 0; i < order; i++) {
+    int64_t dimension = readValue<int64_t>(stream);
+    taco_uassert(dimension >= 0 && dimension <= INT_MAX) <<
+        "Invalid dimension in ttb file";
+    header.dimensions.push_back((int)dimension);
+  }
+  for (uint32_t i = 0; i < order; i++) {
+    header.modeOrdering.push_back(readValue<int32_t>(stream));
+  }
+  uint32_t numPacks = readValue<uint32_t>(stream);
+  for (uint32_t i = 0; i < numPacks; i++) {
+    header.packSizes.push_back(readValue<uint32_t>(stream));
+  }
+  uint32_t numLevelArrayTypes = readValue<uint32_t>(stream);
+  for (uint32_t i = 0; i < numLevelArrayTypes; i++) {
+    std::vector<Datatype> arrayTypes;
+    uint32_t numArrays = readValue<uint32_t>(stream);
+    for (uint32_t j = 0; j < numArrays; j++) {
+      arrayTypes.push_back(readType(stream));
+    }
+    header.levelArrayTypes.push_back(arrayTypes);
+  }
+  for (uint32_t i = 0; i < order; i++) {
+    TTBLevel level;
+    level.name.resize(readValue<uint32_t>(stream));
+    stream.read(&level.name[0], level.name.size());
+    level.properties = readValue<uint32_t>(stream);
+    level.tableSize = readValue<int32_t>(stream);
+    uint32_t numArrays = readValue<uint32_t>(stream);
+    for (uint32_t j = 0; j < numArrays; j++) {
+      level.arrays.push_back(readArray(stream));
+    }
+    header.levels.push_back(level);
+  }
+  header.values = readArray(stream);
+  return header;
+}
+
+static uint64_t getHeaderSize(const TTBHeader& header) {
+  std::ostringstream stream;
+  writeHeader(stream, header);
+  return stream.str().size();
+}
+
+static uint64_t align(uint64_t offset) {
+  return (offset + TTB_ALIGNMENT - 1) / TTB_ALIGNMENT * TTB_ALIGNMENT;
+}
+
+static std::vector<TTBArray*> getArrays(TTBHeader& header) {
+  std::vector<TTBArray*> arrays;
+  for (auto& level : header.levels) {
+    for (auto& array : level.arrays) {
+      arrays.push_back(&array);
+    }
+  }
+  arrays.push_back(&header.values);
+  return arrays;
+}
+
+static Format getFormat(const TTBHeader&, const Format& format) {
+  return format;
+}
+
+static Format getFormat(const TTBHeader& header, const ModeFormat& modetype) {
+  return Format(std::vector<ModeFormatPack>(header.dimensions.size(),
+                                            modetype));
+}
+
+/// Returns the format with the level array types of the stored tensor, if the
+/// format matches the one the tensor was stored in.
+static Format getStoredFormat(const TTBHeader& header, Format format) {
+  bool matches = (size_t)format.getOrder() == header.levels.size() &&
+                 format.getModeOrdering() == header.modeOrdering &&
+                 format.getModeFormatPacks().size() == header.packSizes.size();
+  for (size_t i = 0; matches && i < header.packSizes.size(); i++) {
+    matches = format.getModeFormatPacks()[i].getModeFormats().size() ==
+              header.packSizes[i];
+  }
+  const std::vector<ModeFormat> modeFormats = format.getModeFormats();
+  for (size_t level = 0; matches && level < header.levels.size(); level++) {
+    const ModeFormat& modeFormat = modeFormats[level];
+    matches = modeFormat.getName() == header.levels[level].name &&
+              getProperties(modeFormat) == header.levels[level].properties &&
+              (modeFormat.getName() != Hashed.getName() ||
+               modeFormat.getTableSize() == header.levels[level].tableSize);
+  }
+
+  std::vector<std::string> names;
+  for (auto& level : header.levels) {
+    names.push_back(level.name);
+  }
+  taco_uassert(matches) << "The ttb tensor is stored with the mode formats (" <<
+      util::join(names) << ") and cannot be read in the format " << format;
+
+  format.setLevelArrayTypes(header.levelArrayTypes);
+  return format;
+}
+
+/// Checks that the arrays of the ttb file have the types that the tensor's
+/// storage and the kernels generated for its format expect, since the arrays
+/// are mapped with the types stored in the file.
+static void validateTypes(const TTBHeader& header, const Format& format) {
+  taco_uassert(header.values.type == header.componentType) <<
+      "The values of the ttb file have type " << header.values.type <<
+      " rather than its component type " << header.componentType;
+  for (size_t i = 0; i < header.levels.size(); i++) {
+    const TTBLevel& level = header.levels[i];
+    std::vector<Datatype> types;
+    if (level.name == Dense.getName()) {
+      types = {Int32};
+    }
+    else if (level.name == Hashed.getName()) {
+      types = {Int32, format.getCoordinateTypeIdx(i)};
+    }
+    else {
+      types = {format.getCoordinateTypePos(i), format.getCoordinateTypeIdx(i)};
+    }
+    bool matches = level.arrays.size() == types.size();
+    for (size_t j = 0; matches && j < types.size(); j++) {
+      matches = level.arrays[j].type == types[j];
+    }
+    taco_uassert(matches) << "The index arrays of level " << i << " of the " <<
+        "ttb file do not have the types of its format";
+  }
+}
+
+/// Checks that the index arrays of each level are consistent with those of
+/// the levels above it, so that kernels stay within the arrays. Coordinates
+/// are not checked, so that mapped tensors are not read in full.
+static void validateIndex(const TTBHeader& header,
+                          const std::vector<ModeIndex>& modeIndices,
+                          const Array& values) {
+  size_t numVals = 1;
+  for (size_t i = 0; i < header.levels.size(); i++) {
+    const TTBLevel& level = header.levels[i];
+    const ModeIndex& modeIndex = modeIndices[i];
+    const size_t dimension = header.dimensions[header.modeOrdering[i]];
+    if (level.name == Dense.getName()) {
+      taco_uassert(modeIndex.numIndexArrays() == 1 &&
+                   modeIndex.getIndexArray(0).getSize() == 1 &&
+                   modeIndex.getIndexArray(0).get(0).getAsIndex() ==
+                       dimension) << "Invalid dense level in ttb file";
+      numVals *= dimension;
+    }
+    else if (level.name == Compressed.getName()) {
+      taco_uassert(modeIndex.numIndexArrays() == 2 &&
+                   modeIndex.getIndexArray(0).getSize() == numVals + 1) <<
+          "Invalid compressed level in ttb file";
+      const Array& pos = modeIndex.getIndexArray(0);
+      size_t previous = 0;
+      for (size_t p = 0; p <= numVals; p++) {
+        const size_t position = pos.get(p).getAsIndex();
+        if ((p == 0 && position != 0) || position < previous) {
+          taco_uerror << "Invalid pos array in ttb file";
+        }
+        previous = position;
+      }
+      taco_uassert(previous <= modeIndex.getIndexArray(1).getSize()) <<
+          "The pos array of a compressed level in the ttb file points past "
+          "its crd array";
+      numVals = previous;
+    }
+    else if (level.name == Singleton.getName()) {
+      taco_uassert(modeIndex.numIndexArrays() == 2 &&
+                   modeIndex.getIndexArray(1).getSize() >= numVals) <<
+          "Invalid singleton level in ttb file";
+    }
+    else if (level.name == Hashed.getName()) {
+      numVals *= level.tableSize;
+      taco_uassert(level.tableSize > 0 && modeIndex.numIndexArrays() == 2 &&
+                   modeIndex.getIndexArray(1).getSize() == numVals) <<
+          "Invalid hashed level in ttb file";
+    }
+    else if (level.name == Bitmap.getName()) {
+      const size_t numWords = numVals * ((dimension + 63) / 64);
+      taco_uassert(modeIndex.numIndexArrays() == 2 &&
+                   modeIndex.getIndexArray(0).getSize() == numWords + 1 &&
+                   modeIndex.getIndexArray(1).getSize() == numWords) <<
+          "Invalid bitmap level in ttb file";
+      numVals = modeIndex.getIndexArray(0).get(numWords).getAsIndex();
+    }
+  }
+  taco_uassert(values.getSize() >= numVals) <<
+      "The ttb file has fewer values than its index stores";
+}
+
+static TensorBase makeTTBTensor(const TTBHeader& header, const Format& format,
+    std::function<Array(const TTBArray&)> getArray) {
+  Format storedFormat = getStoredFormat(header, format);
+  TensorBase tensor(header.componentType, header.dimensions, storedFormat);
+  validateTypes(header, storedFormat);
+
+  std::vector<ModeIndex> modeIndices;
+  for (auto& level : header.levels) {
+    std::vector<Array> arrays;
+    for (auto& array : level.arrays) {
+      arrays.push_back(getArray(array));
+    }
+    modeIndices.push_back(ModeIndex(arrays));
+  }
+  Array values = getArray(header.values);
+  validateIndex(header, modeIndices, values);
+  TensorStorage storage = tensor.getStorage();
+  storage.setIndex(Index(storedFormat, modeIndices));
+  storage.setValues(values);
+  tensor.setStorage(storage);
+  return tensor;
+}
+
+template <typename T>
+TensorBase dispatchReadTTB(std::string filename, const T& format) {
+  std::fstream stream;
+  util::openStream(stream, filename, fstream::in | fstream::binary);
+  TTBHeader header = readHeader(stream);
+  stream.close();
+
+  auto file = std::make_shared<util::MappedFile>(filename);
+  for (auto array : getArrays(header)) {
+    taco_uassert(array->offset + array->size * array->type.getNumBytes() <=
+                 file->getSize()) << "Truncated ttb file: " << filename;
+  }
+  char* data = file->mapPrivate(0, file->getSize());
+  return makeTTBTensor(header, getFormat(header, format),
+                       [&](const TTBArray& array) {
+    return Array(array.type, data + array.offset, array.size, file);
+  });
+}
+
+TensorBase readTTB(std::string filename, const ModeFormat& modetype) {
+  return dispatchReadTTB(filename, modetype);
+}
+
+TensorBase readTTB(std::string filename, const Format& format) {
+  return dispatchReadTTB(filename, format);
+}
+
+template <typename T>
+TensorBase dispatchReadTTB(std::istream& stream, const T& format) {
+  TTBHeader header = readHeader(stream);
+
+  // The arrays follow the header in order, so they are read as they come
+  uint64_t position = getHeaderSize(header);
+  return makeTTBTensor(header, getFormat(header, format),
+                       [&](const TTBArray& array) {
+    taco_uassert(array.offset >= position) << "Invalid array offset in ttb file";
+    stream.ignore(array.offset - position);
+    size_t numBytes = array.size * array.type.getNumBytes();
+    Array result = makeArray(array.type, array.size);
+    stream.read((char*)result.getData(), numBytes);
+    taco_uassert(!stream.fail()) << "Unexpected end of ttb file";
+    position = array.offset + numBytes;
+    return result;
+  });
+}
+
+TensorBase readTTB(std::istream& stream, const ModeFormat& modetype) {
+  return dispatchReadTTB(stream, modetype);
+}
+
+TensorBase readTTB(std::istream& stream, const Format& format) {
+  return dispatchReadTTB(stream, format);
+}
+
+void writeTTB(std::string filename, const TensorBase& tensor) {
+  std::fstream file;
+  util::openStream(file, filename, fstream::out | fstream::binary);
+  writeTTB(file, tensor);
+  file.close();
+}
+
+void writeTTB(std::ostream& stream, const TensorBase& tensor) {
+  TensorBase packed = tensor;
+  if (packed.needsPack()) {
+    packed.pack();
+  }
+  else if (packed.needsCompute()) {
+    packed.evaluate();
+  }
+
+  const TensorStorage& storage = packed.getStorage();
+  const Format& format = storage.getFormat();
+  TTBHeader header;
+  header.componentType = storage.getComponentType();
+  header.dimensions = storage.getDimensions();
+  header.modeOrdering = format.getModeOrdering();
+  for (auto& modeFormatPack : format.getModeFormatPacks()) {
+    header.packSizes.push_back(modeFormatPack.getModeFormats().size());
+  }
+  header.levelArrayTypes = format.getLevelArrayTypes();
+
+  std::vector<Array> arrays;
+  const std::vector<ModeFormat> modeFormats = format.getModeFormats();
+  for (int i = 0; i < format.getOrder(); i++) {
+    TTBLevel level;
+    level.name = modeFormats[i].getName();
+    level.properties = getProperties(modeFormats[i]);
+    level.tableSize = (level.name == Hashed.getName())
+                    ? modeFormats[i].getTableSize() : 0;
+    const ModeIndex& modeIndex = storage.getIndex().getModeIndex(i);
+    for (int j = 0; j < modeIndex.numIndexArrays(); j++) {
+      const Array& array = modeIndex.getIndexArray(j);
+      level.arrays.push_back({array.getType(), array.getSize(), 0});
+      arrays.push_back(array);
+    }
+    header.levels.push_back(level);
+  }
+  const Array& values = storage.getValues();
+  header.values = {values.getType(), values.getSize(), 0};
+  arrays.push_back(values);
+
+  // Lay out the arrays after the header
+  uint64_t offset = getHeaderSize(header);
+  for (auto array : getArrays(header)) {
+    array->offset = align(offset);
+    offset = array->offset + array->size * array->type.getNumBytes();
+  }
+
+  writeHeader(stream, header);
+  uint64_t position = getHeaderSize(header);
+  const std::vector<TTBArray*> layout = getArrays(header);
+  for (size_t i = 0; i < arrays.size(); i++) {
+    const std::string padding(layout[i]->offset - position, '\0');
+    stream.write(padding.data(), padding.size());
+    size_t numBytes = layout[i]->size * layout[i]->type.getNumBytes();
+    stream.write((const char*)arrays[i].getData(), numBytes);
+    position = layout[i]->offset + numBytes;
+  }
+  taco_uassert(!stream.fail()) << "Error writing ttb file";
+}
+
+}
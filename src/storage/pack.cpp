@@ -1,6 +1,10 @@
 #include "taco/storage/pack.h"
 
+#include <algorithm>
+#include <complex>
 #include <climits>
+#include <cstdint>
+#include <cstring>
 
 #include "taco/format.h"
 #include "taco/error.h"
@@ -10,6 +14,10 @@
 #include "taco/storage/array.h"
 #include "taco/util/collections.h"
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
 using namespace std;
 
 namespace taco {
@@ -188,4 +196,440 @@ TensorStorage pack(Datatype                             componentType,
   return storage;
 }
 
+
+namespace {
+/// A mode whose coordinates are stored in `bits` bits, starting at bit
+/// `shift`, of a sort key.
+struct KeyField {
+  int mode;
+  int shift;
+  int bits;
+};
+
+/// The coordinates of a component are concatenated into as few 64-bit sort
+/// keys as possible, with each mode taking only as many bits as its largest
+/// coordinate needs. Keys are ordered from least to most significant.
+struct SortKey {
+  std::vector<KeyField> fields;
+  int bits;
+};
+}
+
+static int getNumSortThreads(size_t numComponents) {
+#ifdef USE_OPENMP
+  // Too few components per thread do not amortize the per-thread histograms
+  size_t maxThreads = numComponents / (1 << 16) + 1;
+  return (int)std::min((size_t)omp_get_max_threads(), maxThreads);
+#else
+  return 1;
+#endif
+}
+
+/// Call `f(t, begin, end)` for each of `numThreads` equal chunks of [0,n).
+template <typename F>
+static void forEachChunk(int numThreads, size_t n, F f) {
+#ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static, 1) num_threads(numThreads)
+#endif
+  for (int t = 0; t < numThreads; t++) {
+    f(t, n * t / numThreads, n * (t + 1) / numThreads);
+  }
+}
+
+namespace {
+/// Components stored as an array of structures, each holding the coordinates
+/// followed by the value.
+struct BufferComponents {
+  const char* components;
+  size_t order;
+  size_t componentSize;
+
+  uint32_t coordinate(size_t i, int mode) const {
+    return ((const uint32_t*)&components[i * componentSize])[mode];
+  }
+  const char* value(size_t i) const {
+    return &components[i * componentSize + order * sizeof(int)];
+  }
+};
+
+/// Components stored as a structure of arrays, with one array per mode.
+struct ArrayComponents {
+  const std::vector<const int*>& coordinates;
+  const char* values;
+  size_t valueSize;
+
+  uint32_t coordinate(size_t i, int mode) const {
+    return (uint32_t)coordinates[mode][i];
+  }
+  const char* value(size_t i) const {
+    return &values[i * valueSize];
+  }
+};
+}
+
+namespace {
+/// Components being sorted, as sort keys, one coordinate array per mode and an
+/// array of values.
+struct SortBuffer {
+  std::vector<uint64_t> keys;
+  std::vector<std::vector<int>> coordinates;
+  std::vector<char> values;
+};
+}
+
+static inline void copyValue(char* dst, const char* src, size_t valueSize) {
+  // Copies of the common sizes compile to single moves
+  switch (valueSize) {
+    case 4:  memcpy(dst, src, 4);  break;
+    case 8:  memcpy(dst, src, 8);  break;
+    case 16: memcpy(dst, src, 16); break;
+    default: memcpy(dst, src, valueSize); break;
+  }
+}
+
+/// Stable LSD radix sort of the keys of `buffer`, whose values are less than
+/// 2^bits, that moves the coordinates of `movedModes` and the values along with
+/// the keys, using `tmp` as scratch space. Digits are at most 11 bits so that
+/// the histograms of all threads stay in cache and each thread scatters into
+/// few enough streams that the writes combine, and passes over digits that are
+/// equal for all keys are skipped. Moving the components in every pass reads
+/// and writes them in order, unlike gathering them by a sorted permutation.
+static void radixSort(SortBuffer& buffer, SortBuffer& tmp,
+                      const std::vector<int>& movedModes, size_t valueSize,
+                      int bits, int numThreads) {
+  if (bits == 0) {
+    return;
+  }
+  const int numPasses = (bits + 10) / 11;
+  const int digitBits = (bits + numPasses - 1) / numPasses;
+  const size_t numBuckets = (size_t)1 << digitBits;
+  const uint64_t mask = numBuckets - 1;
+  const size_t n = buffer.keys.size();
+
+  std::vector<size_t> offsets(numThreads * numBuckets);
+  std::vector<size_t> destinations(n);
+  for (int shift = 0; shift < bits; shift += digitBits) {
+    std::fill(offsets.begin(), offsets.end(), 0);
+    forEachChunk(numThreads, n, [&](int t, size_t begin, size_t end) {
+      size_t* count = &offsets[t * numBuckets];
+      const uint64_t* keys = buffer.keys.data();
+      for (size_t i = begin; i < end; i++) {
+        count[(keys[i] >> shift) & mask]++;
+      }
+    });
+
+    // Offsets are laid out thread-major, so scan bucket by bucket
+    size_t offset = 0;
+    bool isConstantDigit = false;
+    for (size_t b = 0; b < numBuckets; b++) {
+      size_t bucketBegin = offset;
+      for (int t = 0; t < numThreads; t++) {
+        size_t count = offsets[t * numBuckets + b];
+        offsets[t * numBuckets + b] = offset;
+        offset += count;
+      }
+      isConstantDigit |= (offset - bucketBegin == n);
+    }
+    if (isConstantDigit) {
+      continue;
+    }
+
+    forEachChunk(numThreads, n, [&](int t, size_t begin, size_t end) {
+      size_t* offset = &offsets[t * numBuckets];
+      const uint64_t* keys = buffer.keys.data();
+      uint64_t* keysTmp = tmp.keys.data();
+      size_t* dst = destinations.data();
+      for (size_t i = begin; i < end; i++) {
+        size_t j = offset[(keys[i] >> shift) & mask]++;
+        keysTmp[j] = keys[i];
+        dst[i] = j;
+      }
+      for (int mode : movedModes) {
+        const int* crd = buffer.coordinates[mode].data();
+        int* crdTmp = tmp.coordinates[mode].data();
+        for (size_t i = begin; i < end; i++) {
+          crdTmp[dst[i]] = crd[i];
+        }
+      }
+      const char* vals = buffer.values.data();
+      char* valsTmp = tmp.values.data();
+      for (size_t i = begin; i < end; i++) {
+        copyValue(&valsTmp[dst[i] * valueSize], &vals[i * valueSize],
+                  valueSize);
+      }
+    });
+    buffer.keys.swap(tmp.keys);
+    for (int mode : movedModes) {
+      buffer.coordinates[mode].swap(tmp.coordinates[mode]);
+    }
+    buffer.values.swap(tmp.values);
+  }
+}
+
+template <typename Components>
+static void sortComponents(const Components& components, size_t numComponents,
+                           const std::vector<int>& modeOrdering,
+                           size_t valueSize,
+                           const std::vector<int*>& coordinates, char* values,
+                           size_t numSortedModes) {
+  const size_t order = modeOrdering.size();
+  taco_iassert(coordinates.size() == order);
+  const int numThreads = getNumSortThreads(numComponents);
+
+  // Find the coordinate width of each mode and whether the components are
+  // already sorted, which is the common case of tensors that are filled in
+  // order. Coordinates are compared as unsigned integers.
+  std::vector<uint32_t> maxCoordinates(numThreads * order, 0);
+  std::vector<char> chunkIsSorted(numThreads, true);
+  forEachChunk(numThreads, numComponents, [&](int t, size_t begin, size_t end) {
+    uint32_t* maxCoordinate = &maxCoordinates[t * order];
+    bool isSorted = true;
+    for (size_t i = begin; i < end; i++) {
+      for (size_t d = 0; d < order; d++) {
+        maxCoordinate[d] = std::max(maxCoordinate[d],
+                                    components.coordinate(i, d));
+      }
+      if (isSorted && i > 0) {
+        for (size_t d = 0; d < order; d++) {
+          uint32_t a = components.coordinate(i-1, modeOrdering[d]);
+          uint32_t b = components.coordinate(i, modeOrdering[d]);
+          if (a != b) {
+            isSorted = a < b;
+            break;
+          }
+        }
+      }
+    }
+    chunkIsSorted[t] = isSorted;
+  });
+  bool isSorted = true;
+  for (int t = 0; t < numThreads; t++) {
+    isSorted &= (bool)chunkIsSorted[t];
+  }
+
+  if (isSorted || numSortedModes == order) {
+    // Split the components into the per-mode coordinate arrays and the value
+    // array
+    forEachChunk(numThreads, numComponents,
+                 [&](int, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        for (size_t d = 0; d < order; d++) {
+          coordinates[d][i] = (int)components.coordinate(i, modeOrdering[d]);
+        }
+        copyValue(&values[i * valueSize], components.value(i), valueSize);
+      }
+    });
+    return;
+  }
+
+  // Pack the coordinates into keys, starting with the least significant mode
+  // that the components are not already sorted by
+  std::vector<SortKey> sortKeys;
+  for (int d = (int)(order - numSortedModes) - 1; d >= 0; d--) {
+    int mode = modeOrdering[d];
+    uint32_t maxCoordinate = 0;
+    for (int t = 0; t < numThreads; t++) {
+      maxCoordinate = std::max(maxCoordinate, maxCoordinates[t*order + mode]);
+    }
+    int bits = 0;
+    while (bits < 32 && (maxCoordinate >> bits) != 0) {
+      bits++;
+    }
+    if (sortKeys.empty() || sortKeys.back().bits + bits > 64) {
+      sortKeys.push_back({{}, 0});
+    }
+    sortKeys.back().fields.push_back({mode, sortKeys.back().bits, bits});
+    sortKeys.back().bits += bits;
+  }
+
+  // Sort the components by each key in turn. The coordinates of the modes in
+  // a key are decoded from the sorted keys, so only the coordinates of the
+  // other modes and the values move with the keys. The coordinates of the modes
+  // in the last key are decoded straight into the output.
+  std::vector<char> isInLastKey(order, false);
+  for (auto& field : sortKeys.back().fields) {
+    isInLastKey[field.mode] = true;
+  }
+  std::vector<char> isLoaded(order);
+  for (size_t mode = 0; mode < order; mode++) {
+    isLoaded[mode] = sortKeys.size() > 1 || !isInLastKey[mode];
+  }
+  SortBuffer buffer;
+  SortBuffer tmp;
+  buffer.keys.resize(numComponents);
+  tmp.keys.resize(numComponents);
+  buffer.coordinates.resize(order);
+  tmp.coordinates.resize(order);
+  for (size_t mode = 0; mode < order; mode++) {
+    if (isLoaded[mode]) {
+      buffer.coordinates[mode].resize(numComponents);
+      tmp.coordinates[mode].resize(numComponents);
+    }
+  }
+  buffer.values.resize(numComponents * valueSize);
+  tmp.values.resize(numComponents * valueSize);
+  forEachChunk(numThreads, numComponents, [&](int, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      uint64_t key = 0;
+      for (auto& field : sortKeys[0].fields) {
+        key |= (uint64_t)components.coordinate(i, field.mode) << field.shift;
+      }
+      buffer.keys[i] = key;
+      for (size_t mode = 0; mode < order; mode++) {
+        if (isLoaded[mode]) {
+          buffer.coordinates[mode][i] = (int)components.coordinate(i, mode);
+        }
+      }
+      copyValue(&buffer.values[i * valueSize], components.value(i), valueSize);
+    }
+  });
+
+  std::vector<int> outputLevel(order);
+  for (size_t d = 0; d < order; d++) {
+    outputLevel[modeOrdering[d]] = (int)d;
+  }
+  for (size_t k = 0; k < sortKeys.size(); k++) {
+    const SortKey& sortKey = sortKeys[k];
+    std::vector<int> movedModes;
+    for (size_t mode = 0; mode < order; mode++) {
+      bool isInKey = false;
+      for (auto& field : sortKey.fields) {
+        isInKey |= (field.mode == (int)mode);
+      }
+      if (isLoaded[mode] && !isInKey) {
+        movedModes.push_back((int)mode);
+      }
+    }
+
+    if (k > 0) {
+      forEachChunk(numThreads, numComponents,
+                   [&](int, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          uint64_t key = 0;
+          for (auto& field : sortKey.fields) {
+            key |= (uint64_t)(uint32_t)buffer.coordinates[field.mode][i]
+                       << field.shift;
+          }
+          buffer.keys[i] = key;
+        }
+      });
+    }
+    radixSort(buffer, tmp, movedModes, valueSize, sortKey.bits, numThreads);
+
+    const bool isLastKey = (k + 1 == sortKeys.size());
+    forEachChunk(numThreads, numComponents,
+                 [&](int, size_t begin, size_t end) {
+      for (auto& field : sortKey.fields) {
+        const uint64_t mask = ((uint64_t)1 << field.bits) - 1;
+        int* crd = isLastKey ? coordinates[outputLevel[field.mode]]
+                             : buffer.coordinates[field.mode].data();
+        for (size_t i = begin; i < end; i++) {
+          crd[i] = (int)((buffer.keys[i] >> field.shift) & mask);
+        }
+      }
+    });
+  }
+
+  // Copy the coordinates of the other modes and the values into the output
+  forEachChunk(numThreads, numComponents, [&](int, size_t begin, size_t end) {
+    for (size_t mode = 0; mode < order; mode++) {
+      if (!isInLastKey[mode]) {
+        memcpy(&coordinates[outputLevel[mode]][begin],
+               &buffer.coordinates[mode][begin], (end - begin) * sizeof(int));
+      }
+    }
+    memcpy(&values[begin * valueSize], &buffer.values[begin * valueSize],
+           (end - begin) * valueSize);
+  });
+}
+
+void sortCoordinates(const char* components, size_t numComponents,
+                     const std::vector<int>& modeOrdering, size_t valueSize,
+                     const std::vector<int*>& coordinates, char* values) {
+  const size_t order = modeOrdering.size();
+  BufferComponents buffer = {components, order, order*sizeof(int) + valueSize};
+  sortComponents(buffer, numComponents, modeOrdering, valueSize,
+                 coordinates, values, 0);
+}
+
+void sortCoordinates(const std::vector<const int*>& componentCoordinates,
+                     const char* componentValues, size_t numComponents,
+                     const std::vector<int>& modeOrdering, size_t valueSize,
+                     const std::vector<int*>& coordinates, char* values,
+                     size_t numSortedModes) {
+  taco_iassert(componentCoordinates.size() == modeOrdering.size());
+  taco_iassert(numSortedModes <= modeOrdering.size());
+  ArrayComponents arrays = {componentCoordinates, componentValues, valueSize};
+  sortComponents(arrays, numComponents, modeOrdering, valueSize,
+                 coordinates, values, numSortedModes);
+}
+
+template <typename T>
+static bool isZeroValue(const char* value) {
+  T typed;
+  memcpy(&typed, value, sizeof(T));
+  return typed == T(0);
+}
+
+static bool (*getIsZeroValue(Datatype type))(const char*) {
+  switch (type.getKind()) {
+    case Datatype::UInt8:      return isZeroValue<uint8_t>;
+    case Datatype::UInt16:     return isZeroValue<uint16_t>;
+    case Datatype::UInt32:     return isZeroValue<uint32_t>;
+    case Datatype::UInt64:     return isZeroValue<uint64_t>;
+    case Datatype::Int8:       return isZeroValue<int8_t>;
+    case Datatype::Int16:      return isZeroValue<int16_t>;
+    case Datatype::Int32:      return isZeroValue<int32_t>;
+    case Datatype::Int64:      return isZeroValue<int64_t>;
+    case Datatype::Float32:    return isZeroValue<float>;
+    case Datatype::Float64:    return isZeroValue<double>;
+    case Datatype::Complex64:  return isZeroValue<std::complex<float>>;
+    case Datatype::Complex128: return isZeroValue<std::complex<double>>;
+    default:
+      taco_not_supported_yet << "Components of type " << type;
+      return nullptr;
+  }
+}
+
+size_t removeZeroComponents(
+    const std::vector<const int*>& componentCoordinates,
+    const char* componentValues, size_t numComponents, Datatype type,
+    const std::vector<int*>& coordinates, char* values) {
+  bool (*isZero)(const char*) = getIsZeroValue(type);
+  const size_t valueSize = type.getNumBytes();
+  const size_t order = componentCoordinates.size();
+
+  // Each thread counts the nonzero components of a chunk, and then copies them
+  // to the position given by the counts of the chunks before it
+  const int numThreads = getNumSortThreads(numComponents);
+  std::vector<size_t> offsets(numThreads + 1, 0);
+  forEachChunk(numThreads, numComponents,
+               [&](int t, size_t begin, size_t end) {
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++) {
+      count += !isZero(componentValues + i * valueSize);
+    }
+    offsets[t + 1] = count;
+  });
+  for (int t = 0; t < numThreads; t++) {
+    offsets[t + 1] += offsets[t];
+  }
+  forEachChunk(numThreads, numComponents,
+               [&](int t, size_t begin, size_t end) {
+    size_t k = offsets[t];
+    for (size_t i = begin; i < end; i++) {
+      const char* value = componentValues + i * valueSize;
+      if (isZero(value)) {
+        continue;
+      }
+      for (size_t mode = 0; mode < order; mode++) {
+        coordinates[mode][k] = componentCoordinates[mode][i];
+      }
+      copyValue(values + k * valueSize, value, valueSize);
+      k++;
+    }
+  });
+  return offsets[numThreads];
+}
+
 }
@@ -45,6 +45,10 @@ struct TensorStorage::Content {
         modeTypes[i] = taco_mode_sparse;
       } else if (modeType.getName() == Singleton.getName()) {
         modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == Hashed.getName()) {
+        modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == Bitmap.getName()) {
+        modeTypes[i] = taco_mode_sparse;
       } else {
         taco_not_supported_yet;
       }
@@ -153,6 +157,25 @@ TensorStorage::operator struct taco_tensor_t*() const {
         tensorData->indices[i][1] = (uint8_t*)idx.getData();
       }
     }
+    // Hashed levels have the size of their hash tables and the coordinates
+    // stored in the slots of the tables
+    else if (modeType.getName() == Hashed.getName()) {
+      const Array& size = modeIndex.getIndexArray(0);
+      tensorData->indices[i][0] = (uint8_t*)size.getData();
+      if (modeIndex.numIndexArrays() > 1) {
+        const Array& idx = modeIndex.getIndexArray(1);
+        tensorData->indices[i][1] = (uint8_t*)idx.getData();
+      }
+    }
+    // Bitmap levels have the ranks of the words of their bitmaps and the words
+    else if (modeType.getName() == Bitmap.getName()) {
+      if (modeIndex.numIndexArrays() > 0) {
+        const Array& rank = modeIndex.getIndexArray(0);
+        const Array& bitmap = modeIndex.getIndexArray(1);
+        tensorData->indices[i][0] = (uint8_t*)rank.getData();
+        tensorData->indices[i][1] = (uint8_t*)bitmap.getData();
+      }
+    }
     else {
       taco_not_supported_yet;
     }
@@ -0,0 +1,37 @@
+#include "text_parser.h"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+namespace taco {
+
+int getNumParseThreads(size_t size) {
+#ifdef USE_OPENMP
+  // Chunks of less than a megabyte are not worth a thread
+  size_t maxThreads = size / (1 << 20) + 1;
+  return (int)std::min((size_t)omp_get_max_threads(), maxThreads);
+#else
+  return 1;
+#endif
+}
+
+std::vector<const char*> splitLines(const char* begin, const char* end,
+                                    int numChunks) {
+  std::vector<const char*> chunks = {begin};
+  for (int c = 1; c < numChunks; c++) {
+    const char* chunk = begin + (end - begin) * c / numChunks;
+    chunk = (chunk == begin) ? begin : skipLine(chunk - 1, end);
+    if (chunk > chunks.back()) {
+      chunks.push_back(chunk);
+    }
+  }
+  if (end > chunks.back()) {
+    chunks.push_back(end);
+  }
+  return chunks;
+}
+
+}
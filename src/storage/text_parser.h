@@ -0,0 +1,207 @@
+#ifndef TACO_STORAGE_TEXT_PARSER_H
+#define TACO_STORAGE_TEXT_PARSER_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "taco/error.h"
+#include "taco/storage/array.h"
+
+namespace taco {
+
+/// Helpers for the parallel parsers of text file formats. The parsers read
+/// (memory mapped) blocks of a file, which they split into chunks of whole
+/// lines that are parsed in parallel. Each parsing function takes the end of
+/// the block, since blocks are not null terminated.
+
+/// Returns the number of threads to parse `size` bytes with.
+int getNumParseThreads(size_t size);
+
+/// Split the lines in [begin,end) into at most `numChunks` chunks of similar
+/// size. Returns the chunk boundaries, starting with `begin` and ending with
+/// `end`.
+std::vector<const char*> splitLines(const char* begin, const char* end,
+                                    int numChunks);
+
+/// Call `parseChunk(chunk, begin, end)` for each chunk of lines, in parallel.
+template <typename F>
+void parseChunks(const std::vector<const char*>& chunks, F parseChunk) {
+  const int numChunks = (int)chunks.size() - 1;
+#ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static, 1) num_threads(numChunks)
+#endif
+  for (int c = 0; c < numChunks; c++) {
+    parseChunk(c, chunks[c], chunks[c+1]);
+  }
+}
+
+/// Returns the end of the block if `p` is in its last line, and otherwise the
+/// start of the line after `p`.
+inline const char* skipLine(const char* p, const char* end) {
+  const char* newline = (const char*)memchr(p, '\n', end - p);
+  return (newline == nullptr) ? end : newline + 1;
+}
+
+inline const char* skipSpaces(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+    p++;
+  }
+  return p;
+}
+
+/// Returns true iff the line at `p` has no content or is a comment starting
+/// with one of the characters in `comments`.
+inline bool isBlankLine(const char* p, const char* end, const char* comments) {
+  p = skipSpaces(p, end);
+  return p == end || *p == '\n' || strchr(comments, *p) != nullptr;
+}
+
+/// Parse a decimal integer that is preceded by spaces.
+inline bool parseInt(const char*& p, const char* end, long long& value) {
+  p = skipSpaces(p, end);
+  bool negative = (p < end && *p == '-');
+  if (p < end && (*p == '-' || *p == '+')) {
+    p++;
+  }
+  const char* digits = p;
+  unsigned long long result = 0;
+  while (p < end && *p >= '0' && *p <= '9' && p - digits < 19) {
+    result = result * 10 + (*p - '0');
+    p++;
+  }
+  if (p == digits || (p < end && *p >= '0' && *p <= '9')) {
+    return false;
+  }
+  value = negative ? -(long long)result : (long long)result;
+  return true;
+}
+
+/// Returns true iff `p` is at the end of a token.
+inline bool isTokenEnd(const char* p, const char* end) {
+  return p == end || isspace((unsigned char)*p);
+}
+
+/// Parse a floating point number that is preceded by spaces and followed by a
+/// space or the end of the block. Numbers with at most 19 significant digits
+/// whose value is exactly representable after one multiplication or division
+/// by a power of ten are converted directly, and all others by `strtod`, so
+/// the result is always correctly rounded.
+inline bool parseDouble(const char*& p, const char* end, double& value) {
+  static const double powersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  p = skipSpaces(p, end);
+  const char* start = p;
+  bool negative = (p < end && *p == '-');
+  if (p < end && (*p == '-' || *p == '+')) {
+    p++;
+  }
+  uint64_t mantissa = 0;
+  int numDigits = 0;
+  int numSignificantDigits = 0;
+  int exponent = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; p++, numDigits++) {
+    mantissa = mantissa * 10 + (*p - '0');
+    numSignificantDigits += (mantissa != 0);
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++, numDigits++) {
+      mantissa = mantissa * 10 + (*p - '0');
+      numSignificantDigits += (mantissa != 0);
+      exponent--;
+    }
+  }
+  if (numDigits > 0 && p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    long long exponentValue;
+    if (!parseInt(p, end, exponentValue) || exponentValue > 10000 ||
+        exponentValue < -10000) {
+      return false;
+    }
+    exponent += (int)exponentValue;
+  }
+
+  if (numDigits > 0 && numSignificantDigits <= 19 &&
+      mantissa <= ((uint64_t)1 << 53) && exponent >= -22 && exponent <= 22 &&
+      isTokenEnd(p, end)) {
+    value = (double)mantissa;
+    value = (exponent < 0) ? value / powersOfTen[-exponent]
+                           : value * powersOfTen[exponent];
+    value = negative ? -value : value;
+    return true;
+  }
+
+  // Slow path for long numbers, large exponents, infinities and NaNs, which
+  // also rejects tokens with trailing characters
+  char token[128];
+  const char* tokenEnd = start;
+  while (tokenEnd < end && !isspace((unsigned char)*tokenEnd) &&
+         tokenEnd - start < (long)sizeof(token) - 1) {
+    tokenEnd++;
+  }
+  memcpy(token, start, tokenEnd - start);
+  token[tokenEnd - start] = '\0';
+  char* parsedEnd;
+  value = strtod(token, &parsedEnd);
+  p = start + (parsedEnd - token);
+  return parsedEnd != token && isTokenEnd(p, end);
+}
+
+/// A growing array allocated with malloc, which can be handed over to an Array
+/// without copying.
+template <typename T>
+class ArrayBuilder {
+public:
+  ArrayBuilder() : data(nullptr), size(0), capacity(0) {}
+  ~ArrayBuilder() { free(data); }
+
+  void reserve(size_t newCapacity) {
+    if (newCapacity > capacity) {
+      data = (T*)realloc(data, newCapacity * sizeof(T));
+      taco_uassert(data != nullptr) << "Out of memory";
+      capacity = newCapacity;
+    }
+  }
+
+  void append(const T* values, size_t numValues) {
+    if (numValues == 0) {
+      return;
+    }
+    if (size + numValues > capacity) {
+      reserve(std::max(size + numValues, 2 * capacity));
+    }
+    memcpy(&data[size], values, numValues * sizeof(T));
+    size += numValues;
+  }
+
+  size_t getSize() const {
+    return size;
+  }
+
+  /// Returns an array that owns the data, and empty this builder.
+  Array release() {
+    Array array(type<T>(), data, size, Array::Free);
+    data = nullptr;
+    size = 0;
+    capacity = 0;
+    return array;
+  }
+
+private:
+  T* data;
+  size_t size;
+  size_t capacity;
+
+  ArrayBuilder(const ArrayBuilder&) = delete;
+  ArrayBuilder& operator=(const ArrayBuilder&) = delete;
+};
+
+}
+#endif
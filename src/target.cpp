@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "taco/target.h"
+#include "taco/util/env.h"
 
 using namespace std;
 
@@ -76,6 +77,10 @@ bool Target::validateTargetString(const string &s) {
 }
 
 Target getTargetFromEnvironment() {
-  return Target(Target::Arch::C99, Target::OS::MacOS);
+  Target target(Target::Arch::C99, Target::OS::MacOS);
+  if (util::getFromEnv("TACO_JIT", "") == "tcc") {
+    target.jit = Target::LibTCC;
+  }
+  return target;
 }
 } // namespace taco
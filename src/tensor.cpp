@@ -1,6 +1,8 @@
 #include "taco/tensor.h"
 
 #include <set>
+#include <algorithm>
+#include <numeric>
 #include <cstring>
 #include <fstream>
 #include <sstream>
@@ -9,6 +11,11 @@
 #include <vector>
 #include <utility>
 #include <mutex>
+#include <list>
+#include <array>
+#include <unordered_map>
+#include <future>
+#include <chrono>
 
 #include "taco/cuda.h"
 #include "taco/format.h"
@@ -24,6 +31,7 @@
 #include "taco/index_notation/transformations.h"
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_printer.h"
+#include "taco/ir/ir_interpreter.h"
 #include "taco/lower/lower.h"
 #include "taco/storage/storage.h"
 #include "taco/storage/index.h"
@@ -32,8 +40,11 @@
 #include "taco/storage/file_io_tns.h"
 #include "taco/storage/file_io_mtx.h"
 #include "taco/storage/file_io_rb.h"
+#include "taco/storage/file_io_ttb.h"
 #include "taco/storage/typed_vector.h"
 #include "taco/util/collections.h"
+#include "taco/util/env.h"
+#include "taco/util/hash.h"
 #include "taco/util/strings.h"
 #include "taco/util/timers.h"
 #include "taco/util/name_generator.h"
@@ -91,6 +102,12 @@ static Format initFormat(Format format) {
       } else if (modeType.getName() == Singleton.getName()) {
         arrayTypes.push_back(Int32);
         arrayTypes.push_back(Int32);
+      } else if (modeType.getName() == Hashed.getName()) {
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(Int32);
+      } else if (modeType.getName() == Bitmap.getName()) {
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(UInt64);
       } else {
         taco_not_supported_yet;
       }
@@ -117,12 +134,19 @@ TensorBase::TensorBase(string name, Datatype ctype, vector<int> dimensions,
     if (format.getModeFormats()[i].getName() == Dense.getName()) {
       const size_t idx = format.getModeOrdering()[i];
       modeIndices[i] = ModeIndex({makeArray({content->dimensions[idx]})});
+    } else if (format.getModeFormats()[i].getName() == Hashed.getName()) {
+      int tableSize = format.getModeFormats()[i].getTableSize();
+      modeIndices[i] = ModeIndex({makeArray({tableSize})});
     }
   }
   content->storage.setIndex(Index(format, modeIndices));
 
   content->assembleWhileCompute = false;
   content->module = make_shared<Module>();
+  content->assembleFuncName = "assemble";
+  content->computeFuncName = "compute";
+  content->executionMode = ExecutionMode::Compiled;
+  content->kernelExecution = ExecutionMode::Compiled;
 
   content->neverPacked = true;
   content->needsPack = true;
@@ -157,6 +181,50 @@ void TensorBase::reserve(size_t numCoordinates) {
   content->coordinateBuffer->resize(newSize);
 }
 
+static Array copyArray(const Array& array) {
+  if (array.getPolicy() != Array::UserOwns) {
+    return array;
+  }
+  Array copy = makeArray(array.getType(), array.getSize());
+  memcpy(copy.getData(), array.getData(),
+         array.getSize() * array.getType().getNumBytes());
+  return copy;
+}
+
+void TensorBase::insertComponents(const std::vector<Array>& coordinates,
+                                  const Array& values) {
+  taco_uassert(coordinates.size() == (size_t)getOrder()) <<
+      "Wrong number of coordinate arrays";
+  taco_uassert(values.getType() == getComponentType()) <<
+      "Cannot insert values of type '" << values.getType() << "' " <<
+      "into a tensor with component type " << getComponentType();
+  for (auto& coordinateArray : coordinates) {
+    taco_uassert(coordinateArray.getType() == Int32) <<
+        "Coordinates must be of type " << Int32;
+    taco_uassert(coordinateArray.getSize() == values.getSize()) <<
+        "Coordinate and value arrays have different sizes";
+  }
+  for (int mode = 0; mode < getOrder(); mode++) {
+    const int* modeCoordinates =
+        static_cast<const int*>(coordinates[mode].getData());
+    const int dimension = getDimension(mode);
+    for (size_t i = 0; i < coordinates[mode].getSize(); i++) {
+      if (modeCoordinates[i] < 0 || modeCoordinates[i] >= dimension) {
+        taco_uerror << "Coordinate " << modeCoordinates[i] << " of mode " <<
+            mode << " is out of bounds for dimension " << dimension;
+      }
+    }
+  }
+  syncDependentTensors();
+
+  std::vector<Array> coordinateArrays;
+  for (auto& coordinateArray : coordinates) {
+    coordinateArrays.push_back(copyArray(coordinateArray));
+  }
+  content->componentArrays.push_back({coordinateArrays, copyArray(values)});
+  setNeedsPack(true);
+}
+
 int TensorBase::getDimension(int mode) const {
   taco_uassert(mode < getOrder()) << "Invalid mode";
   return content->dimensions[mode];
@@ -234,15 +302,34 @@ void TensorBase::setAssembleWhileCompute(bool assembleWhileCompute) {
   content->assembleWhileCompute = assembleWhileCompute;
 }
 
-static size_t numIntegersToCompare = 0;
-static int lexicographicalCmp(const void* a, const void* b) {
-  for (size_t i = 0; i < numIntegersToCompare; i++) {
-    int diff = ((int*)a)[i] - ((int*)b)[i];
-    if (diff != 0) {
-      return diff;
-    }
+void TensorBase::setExecutionMode(ExecutionMode mode) {
+  content->executionMode = mode;
+}
+
+ExecutionMode TensorBase::getExecutionMode() const {
+  return content->executionMode;
+}
+
+template <typename T>
+static ptrdiff_t loadIndexTyped(const Array& array, ptrdiff_t i) {
+  return (ptrdiff_t)static_cast<const T*>(array.getData())[i];
+}
+
+static ptrdiff_t loadIndex(const Array& array, ptrdiff_t i) {
+  switch (array.getType().getKind()) {
+    case Datatype::UInt8:  return loadIndexTyped<uint8_t>(array, i);
+    case Datatype::UInt16: return loadIndexTyped<uint16_t>(array, i);
+    case Datatype::UInt32: return loadIndexTyped<uint32_t>(array, i);
+    case Datatype::UInt64: return loadIndexTyped<uint64_t>(array, i);
+    case Datatype::Int8:   return loadIndexTyped<int8_t>(array, i);
+    case Datatype::Int16:  return loadIndexTyped<int16_t>(array, i);
+    case Datatype::Int32:  return loadIndexTyped<int32_t>(array, i);
+    case Datatype::Int64:  return loadIndexTyped<int64_t>(array, i);
+    default:
+      taco_ierror << "Index arrays of type " << array.getType() <<
+                     " are not supported";
+      return 0;
   }
-  return 0;
 }
 
 static size_t unpackTensorData(const taco_tensor_t& tensorData,
@@ -259,14 +346,49 @@ static size_t unpackTensorData(const taco_tensor_t& tensorData,
       modeIndices.push_back(ModeIndex({size}));
       numVals *= ((int*)tensorData.indices[i][0])[0];
     } else if (modeType.getName() == Sparse.getName()) {
-      auto size = ((int*)tensorData.indices[i][0])[numVals];
-      Array pos = Array(type<int>(), tensorData.indices[i][0], numVals+1, Array::UserOwns);
-      Array idx = Array(type<int>(), tensorData.indices[i][1], size, Array::UserOwns);
+      Array pos = Array(format.getCoordinateTypePos(i), tensorData.indices[i][0],
+                        numVals+1, Array::UserOwns);
+      auto size = pos.get(numVals).getAsIndex();
+      Array idx = Array(format.getCoordinateTypeIdx(i), tensorData.indices[i][1],
+                        size, Array::UserOwns);
       modeIndices.push_back(ModeIndex({pos, idx}));
       numVals = size;
     } else if (modeType.getName() == Singleton.getName()) {
-      Array idx = Array(type<int>(), tensorData.indices[i][1], numVals, Array::UserOwns);
-      modeIndices.push_back(ModeIndex({makeArray(type<int>(), 0), idx}));
+      Array idx = Array(format.getCoordinateTypeIdx(i), tensorData.indices[i][1],
+                        numVals, Array::UserOwns);
+      modeIndices.push_back(ModeIndex({makeArray(format.getCoordinateTypePos(i),
+                                                 0), idx}));
+    } else if (modeType.getName() == Hashed.getName()) {
+      int tableSize = *(int*)tensorData.indices[i][0];
+      size_t size = numVals * tableSize;
+      Array idx = Array(format.getCoordinateTypeIdx(i), tensorData.indices[i][1],
+                        size, Array::UserOwns);
+      // Kernels stop probing full tables after visiting every slot, so
+      // coordinates that did not fit were dropped or overwrote others
+      for (size_t table = 0; table < numVals; table++) {
+        size_t slot = table * tableSize;
+        while (slot < (table + 1) * tableSize && loadIndex(idx, slot) >= 0) {
+          slot++;
+        }
+        if (slot == (table + 1) * tableSize) {
+          taco_uerror << "A hash table of level " << i << " of " <<
+              tensor.getName() << " is full; the tables of hashed modes must "
+              "have more than " << tableSize << " slots to store these "
+              "coordinates";
+        }
+      }
+      modeIndices.push_back(ModeIndex({makeArray({tableSize}), idx}));
+      numVals = size;
+    } else if (modeType.getName() == Bitmap.getName()) {
+      int dimension = tensorData.dimensions[format.getModeOrdering()[i]];
+      size_t numWords = numVals * ((dimension + 63) / 64);
+      Array rank = Array(format.getCoordinateTypePos(i),
+                         tensorData.indices[i][0], numWords + 1,
+                         Array::UserOwns);
+      Array bitmap = Array(format.getCoordinateTypeIdx(i),
+                           tensorData.indices[i][1], numWords, Array::UserOwns);
+      modeIndices.push_back(ModeIndex({rank, bitmap}));
+      numVals = rank.get(numWords).getAsIndex();
     } else {
       taco_not_supported_yet;
     }
@@ -276,6 +398,37 @@ static size_t unpackTensorData(const taco_tensor_t& tensorData,
   return numVals;
 }
 
+/// Returns the type of the positions of the COO buffers that tensors of the
+/// format are packed from and extracted into.
+static Datatype getBufferPositionType(const Format& format) {
+  return (format.getPositionType().getNumBits() > 32) ? Int64 : Int32;
+}
+
+/// Returns the format of the COO buffers that tensors of the format are packed
+/// from and extracted into, whose positions are wide enough for all the
+/// components the format can hold.
+static Format getBufferFormat(const Format& format) {
+  Format bufferFormat = COO(format.getOrder(), false, true, false,
+                            format.getModeOrdering());
+  const Datatype positionType = getBufferPositionType(format);
+  if (positionType != Int32) {
+    bufferFormat.setLevelArrayTypes(
+        vector<vector<Datatype>>(format.getOrder(), {positionType, Int32}));
+  }
+  return bufferFormat;
+}
+
+/// Returns the pos array of a COO buffer of `numComponents` components.
+static Array makeBufferPos(const Format& format, size_t numComponents) {
+  if (getBufferPositionType(format) == Int64) {
+    return makeArray<int64_t>({0, (int64_t)numComponents});
+  }
+  taco_uassert(numComponents <= INT_MAX) << "Cannot pack " << numComponents <<
+      " components into a format with 32-bit positions; use Int64 position " <<
+      "arrays (Format::setLevelArrayTypes) to store more than " << INT_MAX;
+  return makeArray<int32_t>({0, (int32_t)numComponents});
+}
+
 /// Pack coordinates into a data structure given by the tensor format.
 void TensorBase::pack() {
   if (!needsPack()) {
@@ -343,14 +496,33 @@ void TensorBase::pack() {
   const int csize = getComponentType().getNumBytes();
   const std::vector<int>& dimensions = getDimensions();
 
-  taco_iassert((content->coordinateBufferUsed % content->coordinateSize) == 0);
-  const size_t numCoordinates = content->coordinateBufferUsed / content->coordinateSize;
+  // Scalars are packed straight from the coordinate buffer, which only holds
+  // values, so append the values inserted in bulk to it
+  if (order == 0) {
+    for (auto& components : content->componentArrays) {
+      const Array& componentValues = components.second;
+      size_t numBytes = componentValues.getSize() * csize;
+      content->coordinateBuffer->resize(content->coordinateBufferUsed +
+                                        numBytes);
+      memcpy(&content->coordinateBuffer->data()[content->coordinateBufferUsed],
+             componentValues.getData(), numBytes);
+      content->coordinateBufferUsed += numBytes;
+    }
+    content->componentArrays.clear();
+  }
 
-  const auto helperFuncs = getHelperFunctions(getFormat(), getComponentType(),
-                                              dimensions);
+  taco_iassert((content->coordinateBufferUsed % content->coordinateSize) == 0);
+  const size_t numBufferedCoordinates =
+      content->coordinateBufferUsed / content->coordinateSize;
+  size_t numCoordinates = numBufferedCoordinates;
+  for (auto& components : content->componentArrays) {
+    numCoordinates += components.second.getSize();
+  }
 
   // Pack scalars
   if (order == 0) {
+    const auto helperFuncs = getHelperFunctions(getFormat(), getComponentType(),
+                                                dimensions);
     Array array = makeArray(getComponentType(), 1);
 
     std::vector<taco_mode_t> bufferModeType = {taco_mode_sparse};
@@ -360,8 +532,8 @@ void TensorBase::pack() {
     taco_tensor_t* bufferStorage = init_taco_tensor_t(1, csize,
         (int32_t*)bufferDim.data(), (int32_t*)bufferModeOrdering.data(),
         (taco_mode_t*)bufferModeType.data());
-    std::vector<int> pos = {0, (int)numCoordinates};
-    bufferStorage->indices[0][0] = (uint8_t*)pos.data();
+    Array pos = makeBufferPos(getFormat(), numCoordinates);
+    bufferStorage->indices[0][0] = (uint8_t*)pos.getData();
     bufferStorage->indices[0][1] = (uint8_t*)bufferCoords.data();
     bufferStorage->vals = (uint8_t*)content->coordinateBuffer->data();
 
@@ -371,67 +543,93 @@ void TensorBase::pack() {
 
     deinit_taco_tensor_t(bufferStorage);
     content->coordinateBuffer->clear();
+    content->coordinateBufferUsed = 0;
     return;
   }
 
-  // Permute the coordinates according to the storage mode ordering.
-  // This is a workaround since the current pack code only packs tensors in the
-  // ordering of the modes.
+  // Sort the coordinates in the storage mode ordering, since the pack code
+  // only packs tensors in the ordering of the modes, and split them into one
+  // array per mode.
   taco_iassert(getFormat().getOrder() == order);
   std::vector<int> permutation = getFormat().getModeOrdering();
-  std::vector<int> permutedDimensions(order);
-  for (int i = 0; i < order; ++i) {
-    permutedDimensions[i] = dimensions[permutation[i]];
-  }
-
-  const size_t coordSize = content->coordinateSize;
-  char* coordinatesPtr = content->coordinateBuffer->data();
-  vector<int> permuteBuffer(order);
-  for (size_t i = 0; i < numCoordinates; ++i) {
-    int* coordinate = (int*)coordinatesPtr;
-    for (int j = 0; j < order; j++) {
-      permuteBuffer[j] = coordinate[permutation[j]];
-    }
-    for (int j = 0; j < order; j++) {
-      coordinate[j] = permuteBuffer[j];
-    }
-    coordinatesPtr += content->coordinateSize;
-  }
-  coordinatesPtr = content->coordinateBuffer->data();
-
-  // The pack code expects the coordinates to be sorted
-  numIntegersToCompare = order;
-  qsort(coordinatesPtr, numCoordinates, coordSize, lexicographicalCmp);
-
-
-  // Move coords into separate arrays
   std::vector<std::vector<int>> coordinates(order);
+  std::vector<int*> coordinatePtrs(order);
   for (int i = 0; i < order; ++i) {
     coordinates[i] = std::vector<int>(numCoordinates);
+    coordinatePtrs[i] = coordinates[i].data();
   }
   char* values = (char*) malloc(numCoordinates * csize);
-  for (size_t i = 0; i < numCoordinates; ++i) {
-    int* coordLoc = (int*)&coordinatesPtr[i * coordSize];
-    for (int d = 0; d < order; ++d) {
-      coordinates[d][i] = *coordLoc;
-      coordLoc++;
+  if (content->componentArrays.empty()) {
+    sortCoordinates(content->coordinateBuffer->data(), numCoordinates,
+                    permutation, csize, coordinatePtrs, values);
+  } else if (numBufferedCoordinates == 0 &&
+             content->componentArrays.size() == 1) {
+    auto& components = content->componentArrays[0];
+    std::vector<const int*> componentCoordinates;
+    for (auto& coordinateArray : components.first) {
+      componentCoordinates.push_back((const int*)coordinateArray.getData());
+    }
+    sortCoordinates(componentCoordinates,
+                    (const char*)components.second.getData(), numCoordinates,
+                    permutation, csize, coordinatePtrs, values);
+  } else {
+    // Concatenate the buffered components and all arrays of components
+    std::vector<std::vector<int>> allCoordinates(order);
+    std::vector<const int*> allCoordinatePtrs(order);
+    for (int i = 0; i < order; ++i) {
+      allCoordinates[i] = std::vector<int>(numCoordinates);
+      allCoordinatePtrs[i] = allCoordinates[i].data();
+    }
+    std::vector<char> allValues(numCoordinates * csize);
+    const char* buffer = content->coordinateBuffer->data();
+    for (size_t i = 0; i < numBufferedCoordinates; ++i) {
+      const int* coordLoc = (const int*)&buffer[i * content->coordinateSize];
+      for (int d = 0; d < order; ++d) {
+        allCoordinates[d][i] = coordLoc[d];
+      }
+      memcpy(&allValues[i * csize], &coordLoc[order], csize);
     }
-    memcpy(&values[i * csize], coordLoc, csize);
+    size_t offset = numBufferedCoordinates;
+    for (auto& components : content->componentArrays) {
+      size_t size = components.second.getSize();
+      for (int d = 0; d < order; ++d) {
+        memcpy(&allCoordinates[d][offset], components.first[d].getData(),
+               size * sizeof(int));
+      }
+      memcpy(&allValues[offset * csize], components.second.getData(),
+             size * csize);
+      offset += size;
+    }
+    sortCoordinates(allCoordinatePtrs, allValues.data(), numCoordinates,
+                    permutation, csize, coordinatePtrs, values);
   }
 
-
   content->coordinateBuffer->clear();
   content->coordinateBufferUsed = 0;
+  content->componentArrays.clear();
+
+  packSortedComponents(coordinatePtrs, values, numCoordinates);
+  free(values);
+}
 
+void TensorBase::packSortedComponents(const std::vector<int*>& coordinates,
+                                      const char* values,
+                                      size_t numComponents) {
+  const int order = getOrder();
+  const int csize = getComponentType().getNumBytes();
+  const std::vector<int>& dimensions = getDimensions();
+  const std::vector<int>& modeOrdering = getFormat().getModeOrdering();
+  const auto helperFuncs = getHelperFunctions(getFormat(), getComponentType(),
+                                              dimensions);
 
   std::vector<taco_mode_t> bufferModeTypes(order, taco_mode_sparse);
   taco_tensor_t* bufferStorage = init_taco_tensor_t(order, csize,
-      (int32_t*)dimensions.data(), (int32_t*)permutation.data(),
+      (int32_t*)dimensions.data(), (int32_t*)modeOrdering.data(),
       (taco_mode_t*)bufferModeTypes.data());
-  std::vector<int> pos = {0, (int)numCoordinates};
-  bufferStorage->indices[0][0] = (uint8_t*)pos.data();
+  Array pos = makeBufferPos(getFormat(), numComponents);
+  bufferStorage->indices[0][0] = (uint8_t*)pos.getData();
   for (int i = 0; i < order; ++i) {
-    bufferStorage->indices[i][1] = (uint8_t*)coordinates[i].data();
+    bufferStorage->indices[i][1] = (uint8_t*)coordinates[i];
   }
   bufferStorage->vals = (uint8_t*)values;
 
@@ -440,10 +638,212 @@ void TensorBase::pack() {
   helperFuncs->callFuncPacked("pack", arguments.data());
   content->valuesSize = unpackTensorData(*((taco_tensor_t*)arguments[0]), *this);
 
-  free(values);
   deinit_taco_tensor_t(bufferStorage);
 }
 
+/// Returns how many of the last modes of `modeOrdering` the components of a
+/// tensor with the source format are sorted by when they are extracted in its
+/// storage order, which are the leading modes of the source up to its first
+/// unordered level.
+static size_t getNumSortedModes(const Format& sourceFormat,
+                                const vector<int>& modeOrdering) {
+  const vector<int>& sourceModeOrdering = sourceFormat.getModeOrdering();
+  size_t numOrderedLevels = 0;
+  for (auto& modeFormat : sourceFormat.getModeFormats()) {
+    if (!modeFormat.isOrdered()) {
+      break;
+    }
+    numOrderedLevels++;
+  }
+
+  const size_t order = modeOrdering.size();
+  for (size_t numSorted = std::min(order, numOrderedLevels); numSorted > 0;
+       numSorted--) {
+    if (std::equal(modeOrdering.end() - numSorted, modeOrdering.end(),
+                   sourceModeOrdering.begin())) {
+      return numSorted;
+    }
+  }
+  return 0;
+}
+
+/// Extracts the components of `source` with a compiled kernel, drops those
+/// whose values are zero if `removeZeros` is set, and sorts them by the modes
+/// of `levelModes`. The sorted components are stored as one coordinate array
+/// per level in `coordinates` and as values in `values`, and their number is
+/// returned.
+static size_t sortComponents(const TensorBase& source,
+                             const vector<int>& levelModes, bool removeZeros,
+                             vector<vector<int>>* coordinates,
+                             vector<char>* values) {
+  const int order = source.getOrder();
+  const Datatype ctype = source.getComponentType();
+  const Format& sourceFormat = source.getFormat();
+
+  // Extract the components in the order they are stored, as one coordinate
+  // array per mode
+  TensorBase extracted(ctype, source.getDimensions(),
+                       getBufferFormat(sourceFormat));
+  vector<IndexVar> indexVars(order);
+  extracted(indexVars) = source(indexVars);
+  extracted.evaluate();
+  const Index& index = extracted.getStorage().getIndex();
+  size_t numComponents = extracted.getStorage().getValues().getSize();
+  vector<const int*> componentCoordinates(order);
+  for (int level = 0; level < order; level++) {
+    const Array& crd = index.getModeIndex(level).getIndexArray(1);
+    taco_iassert(crd.getType() == Int32);
+    componentCoordinates[sourceFormat.getModeOrdering()[level]] =
+        static_cast<const int*>(crd.getData());
+  }
+  const char* componentValues =
+      static_cast<const char*>(extracted.getStorage().getValues().getData());
+
+  const size_t csize = ctype.getNumBytes();
+  vector<vector<int>> nonzeroCoordinates;
+  vector<char> nonzeroValues;
+  if (removeZeros) {
+    nonzeroCoordinates.assign(order, vector<int>(numComponents));
+    nonzeroValues.resize(numComponents * csize);
+    vector<int*> nonzeroCoordinatePtrs(order);
+    for (int mode = 0; mode < order; mode++) {
+      nonzeroCoordinatePtrs[mode] = nonzeroCoordinates[mode].data();
+    }
+    numComponents = removeZeroComponents(componentCoordinates, componentValues,
+                                         numComponents, ctype,
+                                         nonzeroCoordinatePtrs,
+                                         nonzeroValues.data());
+    for (int mode = 0; mode < order; mode++) {
+      componentCoordinates[mode] = nonzeroCoordinates[mode].data();
+    }
+    componentValues = nonzeroValues.data();
+  }
+
+  // Sort the components by the modes whose order changes
+  coordinates->assign(order, vector<int>(numComponents));
+  vector<int*> coordinatePtrs(order);
+  for (int level = 0; level < order; level++) {
+    coordinatePtrs[level] = (*coordinates)[level].data();
+  }
+  values->resize(numComponents * csize);
+  sortCoordinates(componentCoordinates, componentValues, numComponents,
+                  levelModes, csize, coordinatePtrs, values->data(),
+                  getNumSortedModes(sourceFormat, levelModes));
+  return numComponents;
+}
+
+/// Returns pointers to the coordinate arrays of each level.
+static vector<int*> getCoordinatePtrs(vector<vector<int>>& coordinates) {
+  vector<int*> coordinatePtrs;
+  for (auto& levelCoordinates : coordinates) {
+    coordinatePtrs.push_back(levelCoordinates.data());
+  }
+  return coordinatePtrs;
+}
+
+TensorBase convert(const TensorBase& tensor, const Format& format) {
+  vector<int> modeOrdering(tensor.getOrder());
+  std::iota(modeOrdering.begin(), modeOrdering.end(), 0);
+  return convert(tensor, modeOrdering, format);
+}
+
+TensorBase convert(const TensorBase& tensor, const vector<int>& modeOrdering,
+                   const Format& format) {
+  const int order = tensor.getOrder();
+  taco_uassert(format.getOrder() == order) <<
+      "Cannot convert a tensor of order " << order << " to a format of " <<
+      "order " << format.getOrder();
+  vector<int> sortedModes = modeOrdering;
+  std::sort(sortedModes.begin(), sortedModes.end());
+  taco_uassert((int)modeOrdering.size() == order &&
+               (order == 0 || (sortedModes[0] == 0 &&
+                               sortedModes[order - 1] == order - 1 &&
+                               std::adjacent_find(sortedModes.begin(),
+                                                  sortedModes.end()) ==
+                                   sortedModes.end()))) <<
+      "The mode ordering (" << util::join(modeOrdering) << ") is not a " <<
+      "permutation of the modes of a tensor of order " << order;
+
+  TensorBase source = tensor;
+  source.syncValues();
+  const Datatype ctype = source.getComponentType();
+  const Format& sourceFormat = source.getFormat();
+
+  // Convert to a format with the levels of the new format, but over the modes
+  // of the tensor, whose storage is the storage of the permuted tensor
+  vector<int> levelModes(order);
+  for (int level = 0; level < order; level++) {
+    levelModes[level] = modeOrdering[format.getModeOrdering()[level]];
+  }
+  Format convertedFormat(format.getModeFormatPacks(), levelModes);
+  convertedFormat.setLevelArrayTypes(format.getLevelArrayTypes());
+  TensorBase converted(util::uniqueName('A'), ctype, source.getDimensions(),
+                       convertedFormat);
+  vector<IndexVar> indexVars(order);
+
+  bool isOrdered = true;
+  for (auto& modeFormat : sourceFormat.getModeFormats()) {
+    isOrdered &= modeFormat.isOrdered();
+  }
+  if (levelModes == sourceFormat.getModeOrdering() && isOrdered) {
+    // The components are copied in the order they are stored
+    converted(indexVars) = source(indexVars);
+    converted.evaluate();
+  }
+  else {
+    vector<vector<int>> coordinates;
+    vector<char> values;
+    size_t numComponents = sortComponents(source, levelModes, false,
+                                          &coordinates, &values);
+    converted.packSortedComponents(getCoordinatePtrs(coordinates),
+                                   values.data(), numComponents);
+  }
+  converted.unsetNeverPacked();
+
+  if (levelModes == format.getModeOrdering()) {
+    return converted;
+  }
+
+  // Relabel the modes of the converted tensor
+  vector<int> dimensions(order);
+  for (int mode = 0; mode < order; mode++) {
+    dimensions[mode] = source.getDimension(modeOrdering[mode]);
+  }
+  TensorBase permuted(util::uniqueName('A'), ctype, dimensions, format);
+  const Index& convertedIndex = converted.getStorage().getIndex();
+  vector<ModeIndex> modeIndices;
+  for (int level = 0; level < order; level++) {
+    modeIndices.push_back(convertedIndex.getModeIndex(level));
+  }
+  TensorStorage storage = permuted.getStorage();
+  storage.setIndex(Index(format, modeIndices));
+  storage.setValues(converted.getStorage().getValues());
+  permuted.content->valuesSize = converted.content->valuesSize;
+  permuted.unsetNeverPacked();
+  return permuted;
+}
+
+TensorBase removeExplicitZeros(const TensorBase& tensor, const Format& format) {
+  taco_uassert(format.getOrder() == tensor.getOrder()) <<
+      "Cannot store a tensor of order " << tensor.getOrder() << " in a " <<
+      "format of order " << format.getOrder();
+  TensorBase source = tensor;
+  source.syncValues();
+  TensorBase result(util::uniqueName('A'), source.getComponentType(),
+                    source.getDimensions(), format);
+
+  // The zeros are dropped between extracting and packing the components,
+  // which compiled kernels cannot do on their own
+  vector<vector<int>> coordinates;
+  vector<char> values;
+  size_t numComponents = sortComponents(source, format.getModeOrdering(), true,
+                                        &coordinates, &values);
+  result.packSortedComponents(getCoordinatePtrs(coordinates), values.data(),
+                              numComponents);
+  result.unsetNeverPacked();
+  return result;
+}
+
 void TensorBase::setStorage(TensorStorage storage) {
   // TODO(pnoyola): figure out all possible interactions between
   // setStorage and automatic compilation machinery.
@@ -510,69 +910,295 @@ const Access TensorBase::operator()() const {
   return this->operator()(std::vector<IndexVar>());
 }
 
-TensorBase::KernelsCache TensorBase::computeKernels;
-std::mutex TensorBase::computeKernelsMutex;
-
-std::shared_ptr<Module> TensorBase::getComputeKernel(const IndexStmt stmt) {
-  computeKernelsMutex.lock();
-  const auto computeKernelsReverse =
-      util::ReverseConstIterable<TensorBase::KernelsCache>(computeKernels);
-  for (const auto& computeKernel : computeKernelsReverse) {
-    if (isomorphic(stmt, computeKernel.first)) {
-      const auto kernelModule = computeKernel.second;
-      computeKernelsMutex.unlock();
-      return kernelModule;
+namespace {
+
+/// Cache of the compute kernels compiled by all tensors. Kernels are indexed by
+/// the structural hash of the concrete index statement they were compiled from,
+/// with `isomorphic` breaking ties, and the cache is split into independently
+/// locked shards so that concurrent lookups rarely contend.  Each shard keeps
+/// its kernels in least recently used order and drops the least recently used
+/// kernel when full.  A dropped kernel's library is unloaded as soon as no
+/// tensor refers to it anymore.
+class ComputeKernelCache {
+public:
+  /// Create a cache that holds up to `capacity` kernels.
+  ComputeKernelCache(size_t capacity)
+      : shardCapacity(std::max<size_t>((capacity + numShards - 1) / numShards,
+                                       1)) {
+  }
+
+  std::shared_ptr<Module> get(const IndexStmt& stmt) {
+    const size_t hash = structuralHash(stmt);
+    Shard& shard = shards[hash % numShards];
+    lock_guard<mutex> lock(shard.entriesMutex);
+    auto candidates = shard.index.equal_range(hash);
+    for (auto it = candidates.first; it != candidates.second; ++it) {
+      if (isomorphic(stmt, it->second->stmt)) {
+        // Move the kernel to the front of the shard's recency list
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return it->second->kernel;
+      }
+    }
+    return nullptr;
+  }
+
+  void insert(const IndexStmt& stmt, std::shared_ptr<Module> kernel) {
+    const size_t hash = structuralHash(stmt);
+    Shard& shard = shards[hash % numShards];
+    lock_guard<mutex> lock(shard.entriesMutex);
+    shard.entries.push_front({hash, stmt, kernel});
+    shard.index.insert({hash, shard.entries.begin()});
+    while (shard.entries.size() > shardCapacity) {
+      auto lru = std::prev(shard.entries.end());
+      auto candidates = shard.index.equal_range(lru->hash);
+      for (auto it = candidates.first; it != candidates.second; ++it) {
+        if (it->second == lru) {
+          shard.index.erase(it);
+          break;
+        }
+      }
+      shard.entries.erase(lru);
     }
   }
-  computeKernelsMutex.unlock();
-  return nullptr;
+
+private:
+  struct Entry {
+    size_t hash;
+    IndexStmt stmt;
+    std::shared_ptr<Module> kernel;
+  };
+
+  struct Shard {
+    mutex entriesMutex;
+    list<Entry> entries;
+    unordered_multimap<size_t, list<Entry>::iterator> index;
+  };
+
+  static const size_t numShards = 16;
+  std::array<Shard, numShards> shards;
+  const size_t shardCapacity;
+};
+
+/// Returns the kernel cache, which holds up to TACO_KERNEL_CACHE_SIZE kernels
+/// (1024 by default).
+ComputeKernelCache& getComputeKernelCache() {
+  static ComputeKernelCache computeKernels(
+      atol(util::getFromEnv("TACO_KERNEL_CACHE_SIZE", "1024").c_str()));
+  return computeKernels;
+}
+
+} // anonymous namespace
+
+std::shared_ptr<Module> TensorBase::getComputeKernel(const IndexStmt stmt) {
+  return getComputeKernelCache().get(stmt);
 }
 
 void TensorBase::cacheComputeKernel(const IndexStmt stmt,
                                     const std::shared_ptr<Module> kernel) {
-  computeKernelsMutex.lock();
-  computeKernels.emplace_back(stmt, kernel);
-  computeKernelsMutex.unlock();
+  getComputeKernelCache().insert(stmt, kernel);
+}
+
+static IndexStmt makeDefaultSchedule(Assignment assignment) {
+  // Workspaces are sized from the numbers of nonzeros of the operands whose
+  // values are known
+  map<TensorVar,size_t> nonzeros;
+  for (auto& operand : getTensors(assignment.getRhs())) {
+    TensorBase tensor = operand.second;
+    if (!tensor.needsPack() && !tensor.needsCompute()) {
+      nonzeros.insert({operand.first,
+                       tensor.getStorage().getValues().getSize()});
+    }
+  }
+
+  IndexStmt stmt = makeConcreteNotation(makeReductionNotation(assignment));
+  stmt = reorderLoopsTopologically(stmt);
+  stmt = insertTemporaries(stmt, nonzeros);
+  stmt = parallelizeOuterLoop(stmt);
+  return stmt;
+}
+
+static std::shared_future<std::shared_ptr<Module>>
+makeReadyFuture(std::shared_ptr<Module> module) {
+  std::promise<std::shared_ptr<Module>> promise;
+  promise.set_value(module);
+  return promise.get_future().share();
 }
 
 void TensorBase::compile() {
   Assignment assignment = getAssignment();
   taco_uassert(assignment.defined())
       << error::compile_without_expr;
-
-  IndexStmt stmt = makeConcreteNotation(makeReductionNotation(assignment));
-  stmt = reorderLoopsTopologically(stmt);
-  stmt = insertTemporaries(stmt);
-  stmt = parallelizeOuterLoop(stmt);
-  compile(stmt, content->assembleWhileCompute);
+  compile(makeDefaultSchedule(assignment), content->assembleWhileCompute);
 }
+
 void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
+  compile(stmt, assembleWhileCompute, false);
+}
+
+std::shared_future<std::shared_ptr<Module>> TensorBase::compileAsync() {
+  Assignment assignment = getAssignment();
+  taco_uassert(assignment.defined())
+      << error::compile_without_expr;
+  return compileAsync(makeDefaultSchedule(assignment),
+                      content->assembleWhileCompute);
+}
+
+std::shared_future<std::shared_ptr<Module>>
+TensorBase::compileAsync(IndexStmt stmt, bool assembleWhileCompute) {
+  compile(stmt, assembleWhileCompute, true);
+  return content->pendingModule.valid() ? content->pendingModule
+                                        : makeReadyFuture(content->module);
+}
+
+void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute,
+                         bool inBackground) {
   if (!needsCompile()) {
     return;
   }
   setNeedsCompile(false);
 
+  // Drops kernels still compiling for a previous expression. Unless the caller
+  // of compileAsync kept the future, this waits for the compiler to finish,
+  // since releasing the last reference to an std::async future blocks.
+  content->pendingModule = {};
+
+  // Compile into a fresh module since the current one may be shared with other
+  // tensors through the kernel cache. Interpreted kernels bypass the cache so
+  // they are never replaced by compiled kernels.
+  const ExecutionMode mode = content->executionMode;
+  std::shared_ptr<Module> module = make_shared<Module>();
+  if (!lowerKernels(stmt, assembleWhileCompute, module, "",
+                    mode != ExecutionMode::Interpreted)) {
+    return;
+  }
+
+  // Kernels can only be interpreted if they run on the host
+  const bool interpretable = !should_use_CUDA_codegen() &&
+                             canInterpret(content->assembleFunc) &&
+                             canInterpret(content->computeFunc);
+
+  if (inBackground && interpretable) {
+    // Compilation errors are stored in the future instead of being reported
+    // on the background thread
+    content->pendingModule = std::async(std::launch::async, [module]() {
+      string error;
+      module->compile(&error);
+      if (!error.empty()) {
+        throw TacoException(error);
+      }
+      return module;
+    }).share();
+    return;
+  }
+
+  if (interpretable && mode != ExecutionMode::Compiled) {
+    content->kernelExecution = mode;
+    return;
+  }
+
+  module->compile();
+  cacheComputeKernel(content->kernelStmt, module);
+}
+
+/// Lower the tensor's kernels into `module`, with `suffix` appended to their
+/// names. Returns false, and uses the cached module instead, if the kernels
+/// have already been compiled for an identical statement.
+bool TensorBase::lowerKernels(IndexStmt stmt, bool assembleWhileCompute,
+                              std::shared_ptr<Module> module,
+                              const std::string& suffix, bool useCache) {
   IndexStmt concretizedAssign = stmt;
   IndexStmt stmtToCompile = stmt.concretize();
   stmtToCompile = scalarPromote(stmtToCompile);
+  content->kernelExecution = ExecutionMode::Compiled;
 
-  if (!std::getenv("CACHE_KERNELS") ||
-      std::string(std::getenv("CACHE_KERNELS")) != "0") {
+  if (useCache && (!std::getenv("CACHE_KERNELS") ||
+                   std::string(std::getenv("CACHE_KERNELS")) != "0")) {
     concretizedAssign = stmtToCompile;
     const auto cachedKernel = getComputeKernel(concretizedAssign);
     if (cachedKernel) {
       content->module = cachedKernel;
-      return;
+      content->assembleFuncName = "assemble";
+      content->computeFuncName = "compute";
+      return false;
     }
   }
 
-  content->assembleFunc = lower(stmtToCompile, "assemble", true, false);
-  content->computeFunc = lower(stmtToCompile, "compute",  assembleWhileCompute, true);
-  content->module->reset();
-  content->module->addFunction(content->assembleFunc);
-  content->module->addFunction(content->computeFunc);
-  content->module->compile();
-  cacheComputeKernel(concretizedAssign, content->module);
+  content->assembleFuncName = "assemble" + suffix;
+  content->computeFuncName = "compute" + suffix;
+  content->assembleFunc = lower(stmtToCompile, content->assembleFuncName,
+                                true, false);
+  content->computeFunc = lower(stmtToCompile, content->computeFuncName,
+                               assembleWhileCompute, true);
+  content->kernelStmt = concretizedAssign;
+  content->module = module;
+  module->addFunction(content->assembleFunc);
+  module->addFunction(content->computeFunc);
+  return true;
+}
+
+void compile(std::vector<TensorBase> tensors) {
+  std::shared_ptr<Module> module = make_shared<Module>();
+  int numLowered = 0;
+  for (auto& tensor : tensors) {
+    if (!tensor.needsCompile()) {
+      continue;
+    }
+    Assignment assignment = tensor.getAssignment();
+    taco_uassert(assignment.defined())
+        << error::compile_without_expr;
+    tensor.setNeedsCompile(false);
+    tensor.content->pendingModule = {};
+
+    string suffix = "_" + to_string(numLowered);
+    if (tensor.lowerKernels(makeDefaultSchedule(assignment),
+                            tensor.content->assembleWhileCompute, module,
+                            suffix)) {
+      numLowered++;
+    }
+  }
+
+  // The module is not added to the kernel cache, since the names of its
+  // kernels depend on the batch
+  if (numLowered > 0) {
+    module->compile();
+  }
+}
+
+void TensorBase::finishCompile() {
+  if (!content->pendingModule.valid()) {
+    return;
+  }
+  auto pendingModule = content->pendingModule;
+  content->pendingModule = {};
+  try {
+    content->module = pendingModule.get();
+  }
+  catch (const TacoException& e) {
+    taco_uerror << e.what();
+  }
+  cacheComputeKernel(content->kernelStmt, content->module);
+}
+
+void TensorBase::callKernel(const std::string& name, void** arguments) {
+  bool interpret = (content->kernelExecution == ExecutionMode::Interpreted);
+  if (content->pendingModule.valid()) {
+    if (content->pendingModule.wait_for(std::chrono::seconds(0)) ==
+        std::future_status::ready) {
+      finishCompile();
+    } else {
+      interpret = true;
+    }
+  }
+
+  if (interpret) {
+    taco_iassert(name == content->assembleFuncName ||
+                 name == content->computeFuncName);
+    ir::interpret(name == content->assembleFuncName ? content->assembleFunc
+                                                    : content->computeFunc,
+                  arguments);
+    return;
+  }
+  content->module->callFuncPacked(name, arguments);
 }
 
 taco_tensor_t* TensorBase::getTacoTensorT() {
@@ -589,6 +1215,235 @@ void TensorBase::syncValues() {
   }
 }
 
+// The positions found in the levels of a tensor by the previous lookup, which
+// batched lookups resume from
+namespace {
+struct ValueSearchCache {
+  ValueSearchCache(int order) : coordinates(order), begins(order),
+                                ends(order), lowerBounds(order) {}
+
+  std::vector<int> coordinates;
+  std::vector<ptrdiff_t> begins;
+  std::vector<ptrdiff_t> ends;
+  std::vector<ptrdiff_t> lowerBounds;
+  int depth = 0;
+};
+}
+
+template <typename T>
+static ptrdiff_t lowerBoundTyped(const Array& array, ptrdiff_t begin,
+                                 ptrdiff_t end, int coordinate) {
+  const T* crd = static_cast<const T*>(array.getData());
+  return std::lower_bound(crd + begin, crd + end, coordinate,
+                          [](T a, int b) { return (int64_t)a < b; }) - crd;
+}
+
+// Returns the first position in [begin, end) whose coordinate is not less
+// than the coordinate
+static ptrdiff_t lowerBound(const Array& array, ptrdiff_t begin, ptrdiff_t end,
+                            int coordinate) {
+  switch (array.getType().getKind()) {
+    case Datatype::UInt8:
+      return lowerBoundTyped<uint8_t>(array, begin, end, coordinate);
+    case Datatype::UInt16:
+      return lowerBoundTyped<uint16_t>(array, begin, end, coordinate);
+    case Datatype::Int32:
+      return lowerBoundTyped<int32_t>(array, begin, end, coordinate);
+    case Datatype::Int64:
+      return lowerBoundTyped<int64_t>(array, begin, end, coordinate);
+    default:
+      while (begin < end && loadIndex(array, begin) < coordinate) {
+        begin++;
+      }
+      return begin;
+  }
+}
+
+// Returns the position of the component at the coordinate in the values array
+// of the storage, or -1 if it is not stored
+static ptrdiff_t findValuePosition(const TensorStorage& storage,
+                                   const int* coordinate,
+                                   ValueSearchCache* cache) {
+  const Format& format = storage.getFormat();
+  const std::vector<int>& modeOrdering = format.getModeOrdering();
+  const std::vector<int>& dimensions = storage.getDimensions();
+  const Index& index = storage.getIndex();
+
+  // The positions of the components whose coordinates match the coordinate
+  // in the levels visited so far
+  ptrdiff_t begin = 0;
+  ptrdiff_t end = 1;
+  bool cached = (cache != nullptr);
+  int level = 0;
+  for (auto& modeFormatPack : format.getModeFormatPacks()) {
+    for (auto& modeFormat : modeFormatPack.getModeFormats()) {
+      const int mode = modeOrdering[level];
+      const int coord = coordinate[mode];
+      if (coord < 0 || coord >= dimensions[mode]) {
+        return -1;
+      }
+      if (cached && level < cache->depth &&
+          cache->coordinates[level] == coord) {
+        begin = cache->begins[level];
+        end = cache->ends[level];
+        level++;
+        continue;
+      }
+
+      // Binary searches resume from the previous lookup if it had the same
+      // parent and a smaller coordinate
+      const bool resume = cached && level < cache->depth &&
+                          cache->coordinates[level] < coord;
+      cached = false;
+
+      const ModeIndex& modeIndex = index.getModeIndex(level);
+      const std::string name = modeFormat.getName();
+      ptrdiff_t lowerBoundPos = begin;
+      bool found = true;
+      if (name == Dense.getName()) {
+        begin = begin * dimensions[mode] + coord;
+        end = begin + 1;
+      }
+      else if (name == Compressed.getName() || name == Singleton.getName()) {
+        const Array& crd = modeIndex.getIndexArray(1);
+        if (name == Compressed.getName()) {
+          const Array& pos = modeIndex.getIndexArray(0);
+          ptrdiff_t posEnd = loadIndex(pos, end);
+          begin = loadIndex(pos, begin);
+          end = posEnd;
+        }
+        if (modeFormat.isOrdered()) {
+          if (resume) {
+            begin = std::max(begin, cache->lowerBounds[level]);
+          }
+          lowerBoundPos = lowerBound(crd, begin, end, coord);
+        }
+        else {
+          lowerBoundPos = begin;
+          while (lowerBoundPos < end &&
+                 loadIndex(crd, lowerBoundPos) != coord) {
+            lowerBoundPos++;
+          }
+        }
+        found = lowerBoundPos < end && loadIndex(crd, lowerBoundPos) == coord;
+        begin = lowerBoundPos;
+        if (found) {
+          ptrdiff_t last = begin + 1;
+          while (!modeFormat.isUnique() && last < end &&
+                 loadIndex(crd, last) == coord) {
+            last++;
+          }
+          end = last;
+        }
+      }
+      else if (name == Hashed.getName()) {
+        // Probe the hash table like generated kernels do
+        const Array& crd = modeIndex.getIndexArray(1);
+        const int tableSize = modeFormat.getTableSize();
+        int bits = 0;
+        while ((1 << bits) < tableSize) {
+          bits++;
+        }
+        const ptrdiff_t base = begin * tableSize;
+        ptrdiff_t slot = util::fibonacciHash(coord, 32 - bits);
+        found = false;
+        for (int probe = 0; probe < tableSize; probe++) {
+          ptrdiff_t stored = loadIndex(crd, base + slot);
+          if (stored == coord) {
+            found = true;
+            break;
+          }
+          if (stored < 0) {
+            break;
+          }
+          slot = (slot + 1) & (tableSize - 1);
+        }
+        begin = base + slot;
+        end = begin + 1;
+      }
+      else if (name == Bitmap.getName()) {
+        const Array& rank = modeIndex.getIndexArray(0);
+        const Array& bitmap = modeIndex.getIndexArray(1);
+        const ptrdiff_t numWords = (dimensions[mode] + 63) / 64;
+        const ptrdiff_t wordPos = begin * numWords + coord / 64;
+        const uint64_t word =
+            static_cast<const uint64_t*>(bitmap.getData())[wordPos];
+        const uint64_t bit = (uint64_t)1 << (coord % 64);
+        found = (word & bit) != 0;
+        begin = loadIndex(rank, wordPos) + __builtin_popcountll(word & (bit-1));
+        end = begin + 1;
+      }
+      else {
+        taco_ierror << "Cannot search " << name << " levels";
+      }
+
+      if (cache != nullptr) {
+        cache->coordinates[level] = coord;
+        cache->begins[level] = begin;
+        cache->ends[level] = end;
+        cache->lowerBounds[level] = lowerBoundPos;
+        cache->depth = found ? level + 1 : level;
+      }
+      if (!found) {
+        return -1;
+      }
+      level++;
+    }
+  }
+  return begin;
+}
+
+bool TensorBase::hasSearchableFormat() const {
+  for (auto& modeFormat : getFormat().getModeFormats()) {
+    // Tile levels are as wide as their tiles rather than their modes
+    if (modeFormat.hasFixedSize()) {
+      return false;
+    }
+    const std::string name = modeFormat.getName();
+    if (name != Dense.getName() && name != Compressed.getName() &&
+        name != Singleton.getName() && name != Hashed.getName() &&
+        name != Bitmap.getName()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ptrdiff_t TensorBase::findValue(const std::vector<int>& coordinate) const {
+  taco_uassert(coordinate.size() == (size_t)getOrder()) <<
+    "Wrong number of indices";
+  return findValuePosition(getStorage(), coordinate.data(), nullptr);
+}
+
+std::vector<ptrdiff_t>
+TensorBase::findValues(const std::vector<std::vector<int>>& coordinates) const {
+  for (auto& coordinate : coordinates) {
+    taco_uassert(coordinate.size() == (size_t)getOrder()) <<
+      "Wrong number of indices";
+  }
+
+  // Look the coordinates up in the order the tensor stores its components
+  const std::vector<int>& modeOrdering = getFormat().getModeOrdering();
+  std::vector<size_t> order(coordinates.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    for (int mode : modeOrdering) {
+      if (coordinates[a][mode] != coordinates[b][mode]) {
+        return coordinates[a][mode] < coordinates[b][mode];
+      }
+    }
+    return false;
+  });
+
+  std::vector<ptrdiff_t> positions(coordinates.size());
+  ValueSearchCache cache(getOrder());
+  for (size_t i : order) {
+    positions[i] = findValuePosition(getStorage(), coordinates[i].data(),
+                                     &cache);
+  }
+  return positions;
+}
+
 void TensorBase::addDependentTensor(TensorBase& tensor) {
   content->dependentTensors.push_back(tensor.content);
 }
@@ -682,6 +1537,48 @@ vector<void*> packArguments(const TensorBase& tensor) {
   return arguments;
 }
 
+// The number of components stored by a tensor, or that it will store if it is
+// dense and has not been computed yet.
+static size_t getNumComponents(const TensorBase& tensor) {
+  for (auto& modeFormat : tensor.getFormat().getModeFormats()) {
+    if (modeFormat.getName() != Dense.getName()) {
+      return tensor.getStorage().getValues().getSize();
+    }
+  }
+  size_t numComponents = 1;
+  for (int dimension : tensor.getDimensions()) {
+    numComponents *= dimension;
+  }
+  return numComponents;
+}
+
+static size_t getInterpretThreshold() {
+  static const size_t threshold =
+      std::stoull(util::getFromEnv("TACO_INTERPRET_THRESHOLD", "10000"));
+  return threshold;
+}
+
+void TensorBase::selectKernelExecution() {
+  if (content->kernelExecution != ExecutionMode::Auto) {
+    return;
+  }
+
+  // Interpret kernels whose inputs and outputs are so small that compiling
+  // them takes longer than interpreting them
+  size_t numComponents = getNumComponents(*this);
+  for (auto& operand : getTensors(getAssignment().getRhs())) {
+    numComponents += getNumComponents(operand.second);
+  }
+  if (numComponents <= getInterpretThreshold()) {
+    content->kernelExecution = ExecutionMode::Interpreted;
+    return;
+  }
+
+  content->kernelExecution = ExecutionMode::Compiled;
+  content->module->compile();
+  cacheComputeKernel(content->kernelStmt, content->module);
+}
+
 void TensorBase::assemble() {
   taco_uassert(!needsCompile()) << error::assemble_without_compile;
   if (!needsAssemble()) {
@@ -693,8 +1590,9 @@ void TensorBase::assemble() {
     operand.second.syncValues();
   }
 
+  selectKernelExecution();
   auto arguments = packArguments(*this);
-  content->module->callFuncPacked("assemble", arguments.data());
+  callKernel(content->assembleFuncName, arguments.data());
 
   if (!content->assembleWhileCompute) {
     setNeedsAssemble(false);
@@ -716,8 +1614,9 @@ void TensorBase::compute() {
     operand.second.removeDependentTensor(*this);
   }
 
+  selectKernelExecution();
   auto arguments = packArguments(*this);
-  this->content->module->callFuncPacked("compute", arguments.data());
+  callKernel(content->computeFuncName, arguments.data());
 
   if (content->assembleWhileCompute) {
     setNeedsAssemble(false);
@@ -734,6 +1633,113 @@ void TensorBase::evaluate() {
   this->compute();
 }
 
+PreparedKernel::PreparedKernel(TensorBase result) {
+  Assignment assignment = result.getAssignment();
+  taco_uassert(assignment.defined()) << error::compile_without_expr;
+  result.compile();
+
+  // Wait for kernels compiled in the background, and compile kernels that
+  // would otherwise be interpreted
+  result.finishCompile();
+  if (result.content->kernelExecution != ExecutionMode::Compiled) {
+    result.content->kernelExecution = ExecutionMode::Compiled;
+    result.content->module->compile();
+    TensorBase::cacheComputeKernel(result.content->kernelStmt,
+                                   result.content->module);
+  }
+  module = result.content->module;
+  assembleFunc = module->getFuncPtr("_shim_" +
+                                    result.content->assembleFuncName);
+  computeFunc = module->getFuncPtr("_shim_" + result.content->computeFuncName);
+  taco_iassert(assembleFunc != nullptr && computeFunc != nullptr);
+  assembleWhileCompute = result.content->assembleWhileCompute;
+  parallel = module->hasParallelLoops();
+
+  auto operands = getTensors(assignment.getRhs());
+  for (auto& operand : operands) {
+    operand.second.syncValues();
+    operand.second.removeDependentTensor(result);
+  }
+
+  tensorVars.push_back(assignment.getLhs().getTensorVar());
+  tensors.push_back(result);
+  for (auto& operand : getArguments(makeConcreteNotation(assignment))) {
+    taco_iassert(util::contains(operands, operand));
+    tensorVars.push_back(operand);
+    tensors.push_back(operands.at(operand));
+  }
+  for (auto& tensor : tensors) {
+    arguments.push_back(tensor.getStorage());
+  }
+}
+
+void PreparedKernel::bind(const TensorVar& tensorVar,
+                          const TensorBase& tensor) {
+  size_t i = getArgumentIndex(tensorVar);
+  taco_uassert(tensor.getFormat() == tensors[i].getFormat() &&
+               tensor.getComponentType() == tensors[i].getComponentType() &&
+               tensor.getDimensions() == tensors[i].getDimensions())
+      << "Cannot bind " << tensor.getName() << " to " << tensorVar.getName()
+      << ", since it has a different format, component type or dimensions";
+
+  tensors[i] = tensor;
+  if (i == 0) {
+    // The result's storage is replaced by the kernels
+    tensors[i].setNeedsPack(false);
+  } else {
+    tensors[i].syncValues();
+  }
+  arguments[i] = tensors[i].getStorage();
+}
+
+TensorBase PreparedKernel::getTensor(const TensorVar& tensorVar) const {
+  return tensors[getArgumentIndex(tensorVar)];
+}
+
+void PreparedKernel::assemble() {
+  call(assembleFunc);
+  if (!assembleWhileCompute) {
+    tensors[0].setNeedsAssemble(false);
+    unpackResult();
+  }
+}
+
+void PreparedKernel::compute() {
+  call(computeFunc);
+  tensors[0].setNeedsCompute(false);
+  if (assembleWhileCompute) {
+    tensors[0].setNeedsAssemble(false);
+    unpackResult();
+  }
+}
+
+size_t PreparedKernel::getArgumentIndex(const TensorVar& tensorVar) const {
+  for (size_t i = 0; i < tensorVars.size(); i++) {
+    if (tensorVars[i] == tensorVar) {
+      return i;
+    }
+  }
+  taco_uerror << tensorVar.getName() << " is not an argument of the kernel";
+  return 0;
+}
+
+void PreparedKernel::call(void* kernel) {
+  // Parallel kernels run with taco's OpenMP schedule and number of threads
+  if (parallel) {
+    Module::callFuncPackedRaw(kernel, arguments.data());
+    return;
+  }
+  int (*func)(void**);
+  *reinterpret_cast<void**>(&func) = kernel;
+  func(arguments.data());
+}
+
+void PreparedKernel::unpackResult() {
+  TensorBase& result = tensors[0];
+  result.content->valuesSize =
+      unpackTensorData(*((taco_tensor_t*)arguments[0]), result);
+}
+
 void TensorBase::operator=(const IndexExpr& expr) {
   taco_uassert(getOrder() == 0)
       << "Must use index variable on the left-hand-side when assigning an "
@@ -776,6 +1782,11 @@ void TensorBase::printAssembleIR(ostream& os, bool color, bool simplify) const {
 }
 
 string TensorBase::getSource() const {
+  // The source of kernels compiling in the background is written by the
+  // compiler thread, into the module that lowerKernels installed
+  if (content->pendingModule.valid()) {
+    content->pendingModule.wait();
+  }
   return content->module->getSource();
 }
 
@@ -783,10 +1794,11 @@ void TensorBase::compileSource(std::string source) {
   taco_iassert(getAssignment().getRhs().defined())
       << error::compile_without_expr;
 
-  IndexStmt stmt = makeConcreteNotation(makeReductionNotation(getAssignment()));
-  stmt = reorderLoopsTopologically(stmt);
-  stmt = insertTemporaries(stmt);
-  stmt = parallelizeOuterLoop(stmt);
+  content->pendingModule = {};
+  IndexStmt stmt = makeDefaultSchedule(getAssignment());
+  content->assembleFuncName = "assemble";
+  content->computeFuncName = "compute";
+  content->kernelExecution = ExecutionMode::Compiled;
   content->assembleFunc = lower(stmt, "assemble", true, false);
   content->computeFunc = lower(stmt, "compute",  false, true);
 
@@ -801,8 +1813,10 @@ void TensorBase::compileSource(std::string source) {
     ss << endl;
     CodeGen_C::generateShim(content->computeFunc, ss);
   }
+  content->module = make_shared<Module>();
   content->module->setSource(source + "\n" + ss.str());
   content->module->compile();
+  setNeedsCompile(false);
 }
 
 TensorBase::HelperFuncsCache TensorBase::helperFunctions;
@@ -835,8 +1849,7 @@ TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
   const auto dims = util::map(dimensions, getDim);
 
   if (format.getOrder() > 0) {
-    const Format bufferFormat = COO(format.getOrder(), false, true, false,
-                                    format.getModeOrdering());
+    const Format bufferFormat = getBufferFormat(format);
     TensorVar bufferTensor(Type(ctype, Shape(dims)), bufferFormat);
     TensorVar packedTensor(Type(ctype, Shape(dims)), format);
 
@@ -962,6 +1975,54 @@ bool equalsTyped(const TensorBase& a, const TensorBase& b) {
   return (ait == at.end() && bit == bt.end());
 }
 
+/// Returns the nonzero components of a tensor sorted by their coordinates,
+/// which is needed to compare tensors with unordered modes.
+template<typename T>
+vector<pair<vector<int>,T>> getSortedComponents(const TensorBase& tensor) {
+  vector<pair<vector<int>,T>> components;
+  for (auto& component : iterate<T>(tensor)) {
+    if (!isZero(component.second)) {
+      components.push_back({component.first.toVector(), component.second});
+    }
+  }
+  std::sort(components.begin(), components.end(),
+            [](const pair<vector<int>,T>& x, const pair<vector<int>,T>& y) {
+              return x.first < y.first;
+            });
+  return components;
+}
+
+static bool hasUnorderedModes(const Format& format) {
+  for (auto& modeFormat : format.getModeFormats()) {
+    if (!modeFormat.isOrdered()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename T>
+bool equalsUnorderedTyped(const TensorBase& a, const TensorBase& b) {
+  auto acomponents = getSortedComponents<T>(a);
+  auto bcomponents = getSortedComponents<T>(b);
+  if (acomponents.size() != bcomponents.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < acomponents.size(); i++) {
+    if (acomponents[i].first != bcomponents[i].first ||
+        !scalarEquals(acomponents[i].second, bcomponents[i].second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template<typename T>
+bool equalsTyped(const TensorBase& a, const TensorBase& b,
+                 bool unordered) {
+  return unordered ? equalsUnorderedTyped<T>(a, b) : equalsTyped<T>(a, b);
+}
+
 bool equals(const TensorBase& a, const TensorBase& b) {
   // Component type must be the same
   if (a.getComponentType() != b.getComponentType()) {
@@ -980,23 +2041,26 @@ bool equals(const TensorBase& a, const TensorBase& b) {
     }
   }
 
-  // Values must be the same
+  // Values must be the same. Tensors with unordered modes, like hashed modes,
+  // are compared by their sorted components.
+  bool unordered = hasUnorderedModes(a.getFormat()) ||
+                   hasUnorderedModes(b.getFormat());
   switch(a.getComponentType().getKind()) {
     case Datatype::Bool: taco_ierror; return false;
-    case Datatype::UInt8: return equalsTyped<uint8_t>(a, b);
-    case Datatype::UInt16: return equalsTyped<uint16_t>(a, b);
-    case Datatype::UInt32: return equalsTyped<uint32_t>(a, b);
-    case Datatype::UInt64: return equalsTyped<uint64_t>(a, b);
-    case Datatype::UInt128: return equalsTyped<unsigned long long>(a, b);
-    case Datatype::Int8: return equalsTyped<int8_t>(a, b);
-    case Datatype::Int16: return equalsTyped<int16_t>(a, b);
-    case Datatype::Int32: return equalsTyped<int32_t>(a, b);
-    case Datatype::Int64: return equalsTyped<int64_t>(a, b);
-    case Datatype::Int128: return equalsTyped<long long>(a, b);
-    case Datatype::Float32: return equalsTyped<float>(a, b);
-    case Datatype::Float64: return equalsTyped<double>(a, b);
-    case Datatype::Complex64: return equalsTyped<std::complex<float>>(a, b);
-    case Datatype::Complex128: return equalsTyped<std::complex<double>>(a, b);
+    case Datatype::UInt8: return equalsTyped<uint8_t>(a, b, unordered);
+    case Datatype::UInt16: return equalsTyped<uint16_t>(a, b, unordered);
+    case Datatype::UInt32: return equalsTyped<uint32_t>(a, b, unordered);
+    case Datatype::UInt64: return equalsTyped<uint64_t>(a, b, unordered);
+    case Datatype::UInt128: return equalsTyped<unsigned long long>(a, b, unordered);
+    case Datatype::Int8: return equalsTyped<int8_t>(a, b, unordered);
+    case Datatype::Int16: return equalsTyped<int16_t>(a, b, unordered);
+    case Datatype::Int32: return equalsTyped<int32_t>(a, b, unordered);
+    case Datatype::Int64: return equalsTyped<int64_t>(a, b, unordered);
+    case Datatype::Int128: return equalsTyped<long long>(a, b, unordered);
+    case Datatype::Float32: return equalsTyped<float>(a, b, unordered);
+    case Datatype::Float64: return equalsTyped<double>(a, b, unordered);
+    case Datatype::Complex64: return equalsTyped<std::complex<float>>(a, b, unordered);
+    case Datatype::Complex128: return equalsTyped<std::complex<double>>(a, b, unordered);
     case Datatype::Undefined: taco_ierror << "Undefined data type";
   }
   taco_unreachable;
@@ -1124,6 +2188,10 @@ TensorBase dispatchRead(T& file, FileType filetype, U format, bool pack) {
     case FileType::rb:
       tensor = readRB(file, format, pack);
       break;
+    case FileType::ttb:
+      // ttb files store packed tensors
+      tensor = readTTB(file, format);
+      break;
   }
   return tensor;
 }
@@ -1145,6 +2213,9 @@ TensorBase dispatchRead(std::string filename, U format, bool pack) {
   else if (extension == "rb") {
     tensor = dispatchRead(filename, FileType::rb, format, pack);
   }
+  else if (extension == "ttb") {
+    tensor = dispatchRead(filename, FileType::ttb, format, pack);
+  }
   else {
     taco_uerror << "File extension not recognized: " << filename << std::endl;
   }
@@ -1196,6 +2267,9 @@ void dispatchWrite(T& file, const TensorBase& tensor, FileType filetype) {
     case FileType::rb:
       writeRB(file, tensor);
       break;
+    case FileType::ttb:
+      writeTTB(file, tensor);
+      break;
   }
 }
 
@@ -1216,6 +2290,9 @@ void write(string filename, const TensorBase& tensor) {
   else if (extension == "rb") {
     dispatchWrite(filename, tensor, FileType::rb);
   }
+  else if (extension == "ttb") {
+    dispatchWrite(filename, tensor, FileType::ttb);
+  }
   else {
     taco_uerror << "File extension not recognized: " << filename << std::endl;
   }
@@ -1229,6 +2306,94 @@ void write(ofstream& stream, FileType filetype, const TensorBase& tensor) {
   dispatchWrite(stream, tensor, filetype);
 }
 
+TensorBase makeSELL(const std::string& name, const TensorBase& matrix,
+                    int chunkSize, int sigma, std::vector<int>* rows) {
+  taco_uassert(matrix.getFormat() == CSR) <<
+      "The tensor " << matrix.getName() << " is not defined in the CSR format";
+  taco_uassert(chunkSize > 0 && sigma > 0) <<
+      "The slice size and sorting window of a SELL tensor must be positive";
+  auto storage = matrix.getStorage();
+  auto index = storage.getIndex();
+  auto posArr = index.getModeIndex(1).getIndexArray(0);
+  auto crdArr = index.getModeIndex(1).getIndexArray(1);
+  taco_uassert(posArr.getType() == type<int>()) << error::type_mismatch;
+  taco_uassert(crdArr.getType() == type<int>()) << error::type_mismatch;
+  const int* pos = static_cast<const int*>(posArr.getData());
+  const int* crd = static_cast<const int*>(crdArr.getData());
+  const char* vals = static_cast<const char*>(storage.getValues().getData());
+  const size_t valSize = matrix.getComponentType().getNumBytes();
+
+  const int numRows = matrix.getDimension(0);
+  const int numSlices = (numRows + chunkSize - 1) / chunkSize;
+  auto rowLength = [&](int row) {
+    return (row < numRows) ? pos[row+1] - pos[row] : 0;
+  };
+
+  // Sort the rows by decreasing length within each window of sigma rows
+  vector<int> order(numSlices * chunkSize);
+  std::iota(order.begin(), order.end(), 0);
+  for (int window = 0; window < numRows; window += sigma) {
+    std::stable_sort(order.begin() + window,
+                     order.begin() + std::min(window + sigma, numRows),
+                     [&](int a, int b) { return rowLength(a) > rowLength(b); });
+  }
+
+  // Pad the rows of each slice to the length of its longest row
+  Array slicePosArr = makeArray(type<int>(), numSlices + 1);
+  int* slicePos = static_cast<int*>(slicePosArr.getData());
+  slicePos[0] = 0;
+  int maxLength = 1;
+  for (int s = 0; s < numSlices; s++) {
+    int length = 0;
+    for (int r = 0; r < chunkSize; r++) {
+      length = std::max(length, rowLength(order[s*chunkSize + r]));
+    }
+    slicePos[s+1] = slicePos[s] + length;
+    maxLength = std::max(maxLength, length);
+  }
+  const size_t numPositions = slicePos[numSlices];
+  const size_t numEntries = numPositions * chunkSize;
+
+  Array sliceCrdArr = makeArray(type<int>(), numPositions);
+  Array laneCrdArr = makeArray(type<int>(), numEntries);
+  Array sellVals = makeArray(matrix.getComponentType(), numEntries);
+  int* sliceCrd = static_cast<int*>(sliceCrdArr.getData());
+  int* laneCrd = static_cast<int*>(laneCrdArr.getData());
+  char* laneVals = static_cast<char*>(sellVals.getData());
+  memset(laneCrd, 0, numEntries * sizeof(int));
+  memset(laneVals, 0, numEntries * valSize);
+  for (int s = 0; s < numSlices; s++) {
+    for (int k = 0; k < slicePos[s+1] - slicePos[s]; k++) {
+      sliceCrd[slicePos[s] + k] = k;
+    }
+    for (int r = 0; r < chunkSize; r++) {
+      const int row = order[s*chunkSize + r];
+      for (int k = 0; k < rowLength(row); k++) {
+        const size_t p = (size_t)(slicePos[s] + k) * chunkSize + r;
+        laneCrd[p] = crd[pos[row] + k];
+        memcpy(&laneVals[p * valSize], &vals[(pos[row] + k) * valSize],
+               valSize);
+      }
+    }
+  }
+
+  TensorBase sell(name, matrix.getComponentType(),
+                  {numSlices, maxLength, chunkSize, matrix.getDimension(1)},
+                  SELL);
+  auto sellStorage = sell.getStorage();
+  sellStorage.setIndex(Index(sell.getFormat(),
+      {ModeIndex({makeArray({numSlices})}),
+       ModeIndex({slicePosArr, sliceCrdArr}),
+       ModeIndex({makeArray({chunkSize})}),
+       ModeIndex({makeArray(type<int>(), 0), laneCrdArr})}));
+  sellStorage.setValues(sellVals);
+  sell.setStorage(sellStorage);
+  if (rows != nullptr) {
+    *rows = order;
+  }
+  return sell;
+}
+
 void packOperands(const TensorBase& tensor) {
   auto operands = getArguments(makeConcreteNotation(tensor.getAssignment()));
 
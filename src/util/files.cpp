@@ -5,6 +5,12 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -24,4 +30,60 @@ void openStream(std::fstream& stream, std::string path, fstream::openmode mode)
   taco_uassert(stream.is_open()) << "Error opening file: " << path;
 }
 
+MappedFile::MappedFile(std::string path) : window(nullptr), windowSize(0) {
+  fd = open(sanitizePath(path).c_str(), O_RDONLY);
+  taco_uassert(fd != -1) << "Error opening file: " << path;
+  struct stat status;
+  if (fstat(fd, &status) != 0) {
+    close(fd);
+    taco_uerror << "Error reading file: " << path;
+  }
+  size = status.st_size;
+}
+
+MappedFile::~MappedFile() {
+  unmap();
+  close(fd);
+}
+
+size_t MappedFile::getSize() const {
+  return size;
+}
+
+const char* MappedFile::map(size_t offset, size_t size) {
+  const char* mapped = mapWindow(offset, size, PROT_READ);
+  if (window != nullptr) {
+    madvise(window, windowSize, MADV_SEQUENTIAL);
+  }
+  return mapped;
+}
+
+char* MappedFile::mapPrivate(size_t offset, size_t size) {
+  return mapWindow(offset, size, PROT_READ | PROT_WRITE);
+}
+
+char* MappedFile::mapWindow(size_t offset, size_t size, int protection) {
+  unmap();
+  if (size == 0) {
+    return nullptr;
+  }
+
+  // Mappings must start at a page boundary
+  size_t pageOffset = offset % sysconf(_SC_PAGESIZE);
+  void* mapped = mmap(nullptr, size + pageOffset, protection, MAP_PRIVATE, fd,
+                      offset - pageOffset);
+  taco_uassert(mapped != MAP_FAILED) << "Error mapping file: " <<
+                                        strerror(errno);
+  window = mapped;
+  windowSize = size + pageOffset;
+  return (char*)window + pageOffset;
+}
+
+void MappedFile::unmap() {
+  if (window != nullptr) {
+    munmap(window, windowSize);
+    window = nullptr;
+  }
+}
+
 }}
@@ -5,6 +5,7 @@
 
 #include "taco/tensor.h"
 #include "taco/format.h"
+#include "taco/lower/mode_format_hashed.h"
 #include "taco/index_notation/index_notation.h"
 #include "taco/storage/storage.h"
 #include "taco/util/strings.h"
@@ -72,3 +73,204 @@ TEST(format, dense) {
   A.pack();
   ASSERT_COMPONENTS_EQUALS({{{3}}, {{3}}}, {0,2,0, 0,0,0, 3,0,4}, A);
 }
+
+TEST(format, bcsr) {
+  // A 4x6 matrix with 2x3 blocks, stored as A(ib,jb,ii,ji)
+  Tensor<double> A("A", {4, 6}, CSR);
+  Tensor<double> B("B", {2, 2, 2, 3}, BCSR);
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 6; j++) {
+      // Only blocks (0,0), (0,1) and (1,1) are nonzero
+      if (i / 2 == 1 && j / 3 == 0) {
+        continue;
+      }
+      double value = (i * 6 + j) % 5;
+      A.insert({i, j}, value);
+      B.insert({i / 2, j / 3, i % 2, j % 3}, value);
+    }
+  }
+  A.pack();
+  B.pack();
+  ASSERT_EQ(3u, B.getStorage().getIndex().getModeIndex(1).getIndexArray(1)
+                 .getSize());
+
+  Tensor<double> x("x", {6}, Format({Dense}));
+  Tensor<double> X("X", {2, 3}, Format({Dense, Tile}));
+  for (int j = 0; j < 6; j++) {
+    x.insert({j}, j + 1.0);
+    X.insert({j / 3, j % 3}, j + 1.0);
+  }
+  x.pack();
+  X.pack();
+
+  IndexVar i, j, ib, jb, ii, ji;
+  Tensor<double> expected("expected", {4}, Format({Dense}));
+  expected(i) = A(i,j) * x(j);
+  expected.evaluate();
+
+  Tensor<double> Y("Y", {2, 2}, Format({Dense, Tile}));
+  Y(ib,ii) = B(ib,jb,ii,ji) * X(jb,ji);
+  Y.evaluate();
+
+  // The loops over the tiles have constant bounds and are unrolled
+  std::string source = Y.getSource();
+  ASSERT_NE(std::string::npos, source.find("#pragma GCC unroll 2"));
+  ASSERT_NE(std::string::npos, source.find("#pragma GCC unroll 3"));
+
+  for (int i = 0; i < 4; i++) {
+    ASSERT_DOUBLE_EQ(expected(i), Y(i / 2, i % 2));
+  }
+}
+
+TEST(format, sell) {
+  // Rows of lengths 1, 3, 0, 2, 4 and 1
+  Tensor<double> A("A", {6, 5}, CSR);
+  std::vector<std::vector<int>> columns = {{2}, {0,1,4}, {}, {1,3},
+                                           {0,1,2,3}, {4}};
+  for (int i = 0; i < 6; i++) {
+    for (int j : columns[i]) {
+      A.insert({i, j}, i + j + 1.0);
+    }
+  }
+  A.pack();
+
+  std::vector<int> rows;
+  TensorBase S = makeSELL("S", A, 4, 4, &rows);
+  ASSERT_EQ(SELL, S.getFormat());
+  ASSERT_EQ(std::vector<int>({1, 3, 0, 2, 4, 5, 6, 7}), rows);
+  // Slice 0 is padded to 3 entries per row and slice 1 to 4
+  ASSERT_EQ(28u, S.getStorage().getValues().getSize());
+
+  Tensor<double> x("x", {5}, Format({Dense}));
+  for (int j = 0; j < 5; j++) {
+    x.insert({j}, j - 2.0);
+  }
+  x.pack();
+
+  IndexVar i, j, s, k, r;
+  Tensor<double> expected("expected", {6}, Format({Dense}));
+  expected(i) = A(i,j) * x(j);
+  expected.evaluate();
+
+  Tensor<double> y("y", {2, 4}, Format({Dense, Tile}));
+  y(s,r) = S(s,k,r,j) * x(j);
+  y.evaluate();
+  for (int p = 0; p < 8; p++) {
+    if (rows[p] < 6) {
+      ASSERT_DOUBLE_EQ(expected(rows[p]), y(p / 4, p % 4));
+    }
+  }
+}
+
+TEST(format, hashed) {
+  Format hashed({Dense, ModeFormat(std::make_shared<HashedModeFormat>(8))});
+  ASSERT_EQ(8, hashed.getModeFormats()[1].getTableSize());
+
+  Tensor<double> B("B", {4, 5}, CSR);
+  Tensor<double> C("C", {5, 6}, CSR);
+  Tensor<double> H("H", {5, 6}, hashed);
+  std::vector<std::vector<int>> columns = {{1}, {0,3,5}, {}, {2,3}, {0,1,4,5}};
+  for (int k = 0; k < 5; k++) {
+    B.insert({k % 4, k}, k + 1.0);
+    for (int j : columns[k]) {
+      C.insert({k, j}, k + j + 1.0);
+      H.insert({k, j}, k + j + 1.0);
+    }
+  }
+  B.pack();
+  C.pack();
+  H.pack();
+  ASSERT_EQ(40u, H.getStorage().getValues().getSize());
+  ASSERT_TRUE(equals(C, H));
+
+  // Locate into a hashed operand skips coordinates it does not store
+  IndexVar i, j, k;
+  Tensor<double> expected("expected", {5, 6}, CSR);
+  expected(k,j) = C(k,j) * C(k,j);
+  expected.evaluate();
+  Tensor<double> A("A", {5, 6}, CSR);
+  A(k,j) = C(k,j) * H(k,j);
+  A.evaluate();
+  ASSERT_TRUE(equals(expected, A));
+
+  // Hashed results are assembled without dense workspaces
+  Tensor<double> expectedProduct("expectedProduct", {4, 6}, {Dense, Dense});
+  expectedProduct(i,j) = B(i,k) * C(k,j);
+  expectedProduct.evaluate();
+  Tensor<double> product("product", {4, 6}, hashed);
+  product(i,j) = B(i,k) * C(k,j);
+  product.evaluate();
+  ASSERT_TRUE(equals(expectedProduct, product));
+
+  // Packing reports tables that run out of empty slots
+  Format small({Dense, ModeFormat(std::make_shared<HashedModeFormat>(4))});
+  Tensor<double> full("full", {2, 6}, small);
+  for (int j = 0; j < 5; j++) {
+    full.insert({1, j}, j + 1.0);
+  }
+#ifdef PYTHON
+  ASSERT_THROW(full.pack(), taco::TacoException);
+#else
+  ASSERT_DEATH(full.pack(), "is full");
+#endif
+}
+
+TEST(format, bitmap) {
+  Format bitmap({Dense, Bitmap});
+  Tensor<double> B("B", {3, 130}, bitmap);
+  Tensor<double> C("C", {3, 130}, bitmap);
+  Tensor<double> Bcsr("Bcsr", {3, 130}, CSR);
+  Tensor<double> Ccsr("Ccsr", {3, 130}, CSR);
+  for (int i = 0; i < 3; i++) {
+    for (int j = i; j < 130; j += 3 + i) {
+      B.insert({i, j}, i + j + 1.0);
+      Bcsr.insert({i, j}, i + j + 1.0);
+    }
+    for (int j = 2*i; j < 130; j += 5) {
+      C.insert({i, j}, i * j + 1.0);
+      Ccsr.insert({i, j}, i * j + 1.0);
+    }
+  }
+  B.pack();
+  C.pack();
+  Bcsr.pack();
+  Ccsr.pack();
+  ASSERT_EQ(Bcsr.getStorage().getValues().getSize(),
+            B.getStorage().getValues().getSize());
+  ASSERT_TRUE(equals(Bcsr, B));
+
+  // Intersections and unions of bitmaps are computed a word at a time
+  IndexVar i, j;
+  Tensor<double> expected("expected", {3, 130}, CSR);
+  expected(i,j) = Bcsr(i,j) * Ccsr(i,j);
+  expected.evaluate();
+  Tensor<double> A("A", {3, 130}, bitmap);
+  A(i,j) = B(i,j) * C(i,j);
+  A.evaluate();
+  ASSERT_TRUE(equals(expected, A));
+
+  expected(i,j) = Bcsr(i,j) + Ccsr(i,j);
+  expected.evaluate();
+  A(i,j) = B(i,j) + C(i,j);
+  A.evaluate();
+  ASSERT_TRUE(equals(expected, A));
+
+  // Bitmap operands can be located into from loops over other formats
+  Tensor<double> D("D", {3, 130}, {Dense, Dense});
+  D(i,j) = B(i,j) + Ccsr(i,j);
+  D.evaluate();
+  ASSERT_TRUE(equals(expected, D));
+
+  Tensor<double> x("x", {130}, {Dense});
+  for (int j = 0; j < 130; j++) {
+    x.insert({j}, j + 2.0);
+  }
+  x.pack();
+  Tensor<double> expectedY("expectedY", {3}, {Dense});
+  expectedY(i) = Bcsr(i,j) * x(j);
+  expectedY.evaluate();
+  Tensor<double> y("y", {3}, {Dense});
+  y(i) = B(i,j) * x(j);
+  y.evaluate();
+  ASSERT_TRUE(equals(expectedY, y));
+}
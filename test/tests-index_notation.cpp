@@ -153,6 +153,25 @@ TEST(notation, isomorphic) {
   ASSERT_FALSE(isomorphic(sum(j, B(i,j) + C(i,j)), sum(j, B(j,i) + C(j,i))));
 }
 
+TEST(notation, structuralHash) {
+  ASSERT_EQ(structuralHash(A(i,j) = B(i,j) + C(i,j)),
+            structuralHash(B(i,j) = C(i,j) + A(i,j)));
+  ASSERT_EQ(structuralHash(A(i,j) = B(i,j) + C(i,j)),
+            structuralHash(A(j,i) = B(j,i) + C(j,i)));
+  ASSERT_EQ(structuralHash(forall(i, forall(j, A(i,j) = B(i,j) + C(i,j)))),
+            structuralHash(forall(j, forall(i, A(j,i) = B(j,i) + C(j,i)))));
+  ASSERT_EQ(structuralHash(sum(j, B(i,j) + C(i,j))),
+            structuralHash(sum(i, B(j,i) + C(j,i))));
+  ASSERT_NE(structuralHash(A(i,j) = B(i,j) + C(i,j)),
+            structuralHash(A(i,k) = B(i,k) + C(k,i)));
+  ASSERT_NE(structuralHash(A(i,j) = B(i,j) + C(i,j)),
+            structuralHash(A(i,j) = B(i,j) * C(i,j)));
+  ASSERT_NE(structuralHash(A(i,j) = B(i,j) + C(i,j)),
+            structuralHash(D(i,j) = E(i,j) + F(i,j)));
+  ASSERT_NE(structuralHash(D(i,j) = E(i,j) + F(i,j)),
+            structuralHash(D(i,j) = E(i,j) + G(i,j)));
+}
+
 TEST(notation, generatePackCOOStmt) {
   ModeFormat compressedNU = ModeFormat::Compressed(ModeFormat::NOT_UNIQUE);
   ModeFormat singletonNU = ModeFormat::Singleton(ModeFormat::NOT_UNIQUE);
@@ -1,6 +1,15 @@
 #include "test.h"
 
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
 #include "taco/tensor.h"
+#include "taco/storage/file_io_mtx.h"
+#include "taco/storage/file_io_tns.h"
+#include "taco/storage/file_io_ttb.h"
+#include "taco/util/env.h"
+#include "storage/text_parser.h"
 
 using namespace taco;
 
@@ -127,3 +136,210 @@ TEST(io, mtxsymmetric) {
 
   ASSERT_TRUE(equals(expected, tensor));
 }
+
+TEST(io, tnsStream) {
+  std::string tns = "# comment\r\n"
+                    "1 2 3 1.5\r\n"
+                    "\n"
+                    "  2\t1 3 -2.5e-3\n"
+                    "2 4 1 1e400\n"
+                    "1 2 3 .5";
+
+  TensorBase expected(Float64, {2,4,3}, Sparse);
+  expected.insert({0, 1, 2}, 2.0);
+  expected.insert({1, 0, 2}, -2.5e-3);
+  expected.insert({1, 3, 0}, HUGE_VAL);
+  expected.pack();
+
+  std::istringstream stream(tns);
+  TensorBase tensor = readTNS(stream, Sparse);
+  ASSERT_TRUE(equals(expected, tensor));
+
+  std::string filename = util::getTmpdir() + "stream.tns";
+  std::ofstream file(filename);
+  file << tns;
+  file.close();
+  ASSERT_TRUE(equals(expected, readTNS(filename, Sparse)));
+}
+
+TEST(io, parseDouble) {
+  for (std::string number : {"0", "-0.0", "1.1", "3.14159265358979", "1e22",
+                             "123456789012345678", "1.7976931348623157e308",
+                             "4.9e-324", "0.1e-5", "-12.5E+2", "inf", "nan",
+                             "2.2250738585072011e-308", "9007199254740993"}) {
+    const char* p = number.data();
+    double value;
+    ASSERT_TRUE(parseDouble(p, number.data() + number.size(), value));
+    ASSERT_EQ(number.data() + number.size(), p);
+    double expected = strtod(number.c_str(), nullptr);
+    if (expected != expected) {
+      ASSERT_NE(value, value);
+    } else {
+      ASSERT_EQ(expected, value) << number;
+    }
+  }
+  for (std::string malformed : {"x", "1.5abc", "2x", "1e5e", "nanx"}) {
+    const char* p = malformed.data();
+    double value;
+    ASSERT_FALSE(parseDouble(p, p + malformed.size(), value)) << malformed;
+  }
+
+  // Numbers end at spaces, which are left for the next token
+  std::string delimited = "1.5\t2";
+  const char* p = delimited.data();
+  double value;
+  ASSERT_TRUE(parseDouble(p, p + delimited.size(), value));
+  ASSERT_EQ(1.5, value);
+  ASSERT_EQ('\t', *p);
+}
+
+TEST(io, mtxFields) {
+  std::istringstream pattern("%%MatrixMarket matrix coordinate pattern symmetric\n"
+                             "% comment\n"
+                             "3 3 2\n"
+                             "2 1\n"
+                             "3 3\n");
+  TensorBase expectedPattern(Float64, {3,3}, Sparse);
+  expectedPattern.insert({1, 0}, 1.0);
+  expectedPattern.insert({0, 1}, 1.0);
+  expectedPattern.insert({2, 2}, 1.0);
+  expectedPattern.pack();
+  ASSERT_TRUE(equals(expectedPattern, readMTX(pattern, Sparse)));
+
+  std::istringstream skew("%%MatrixMarket matrix coordinate integer skew-symmetric\n"
+                          "3 3 2\n"
+                          "2 1 4\n"
+                          "3 2 -7\n");
+  TensorBase expectedSkew(Float64, {3,3}, Sparse);
+  expectedSkew.insert({1, 0}, 4.0);
+  expectedSkew.insert({0, 1}, -4.0);
+  expectedSkew.insert({2, 1}, -7.0);
+  expectedSkew.insert({1, 2}, 7.0);
+  expectedSkew.pack();
+  ASSERT_TRUE(equals(expectedSkew, readMTX(skew, Sparse)));
+
+  // Symmetric arrays store the lower triangle in column-major order
+  std::istringstream array("%%MatrixMarket matrix array real symmetric\n"
+                           "2 2\n"
+                           "1.5\n"
+                           "2\n"
+                           "3\n");
+  TensorBase expectedArray(Float64, {2,2}, Dense);
+  expectedArray.insert({0, 0}, 1.5);
+  expectedArray.insert({1, 0}, 2.0);
+  expectedArray.insert({0, 1}, 2.0);
+  expectedArray.insert({1, 1}, 3.0);
+  expectedArray.pack();
+  ASSERT_TRUE(equals(expectedArray, readMTX(array, Dense)));
+
+  std::istringstream missing("%%MatrixMarket matrix coordinate real general\n"
+                             "3 3 2\n"
+                             "2 1 1.0\n");
+#ifdef PYTHON
+  ASSERT_THROW(readMTX(missing, Sparse), TacoException);
+#else
+  ASSERT_DEATH(readMTX(missing, Sparse), "1 components instead of 2");
+#endif
+
+  std::istringstream empty("%%MatrixMarket matrix coordinate real general\n"
+                           "5 5 0\n");
+  TensorBase emptyTensor = readMTX(empty, Sparse);
+  ASSERT_EQ(vector<int>({5, 5}), emptyTensor.getDimensions());
+  ASSERT_TRUE(equals(TensorBase(Float64, {5,5}, Sparse), emptyTensor));
+}
+
+TEST(io, ttb) {
+  Tensor<double> B("B", {5, 300}, CSR);
+  B.insert({0, 1}, 1.0);
+  B.insert({0, 299}, 2.0);
+  B.insert({3, 7}, -3.5);
+  B.insert({4, 0}, 4.25);
+  B.pack();
+
+  // Tensors are read back by mapping their arrays
+  std::string filename = util::getTmpdir() + "B.ttb";
+  write(filename, B);
+  TensorBase mapped = read(filename, CSR);
+  ASSERT_EQ(CSR, mapped.getFormat());
+  ASSERT_EQ(Array::Mmap, mapped.getStorage().getValues().getPolicy());
+  ASSERT_TRUE(equals(B, mapped));
+
+  // Level array types are kept
+  Format narrowCSR = narrowCoordinateTypes(CSR, {5, 300});
+  Tensor<double> C("C", {5, 300}, narrowCSR);
+  IndexVar i, j;
+  C(i, j) = B(i, j);
+  C.evaluate();
+  std::stringstream stream;
+  writeTTB(stream, C);
+  TensorBase streamed = readTTB(stream, CSR);
+  ASSERT_EQ(UInt16, streamed.getFormat().getCoordinateTypeIdx(1));
+  ASSERT_EQ(UInt16, streamed.getStorage().getIndex().getModeIndex(1)
+                        .getIndexArray(1).getType());
+  ASSERT_TRUE(equals(B, streamed));
+
+  // Kernels compute with mapped tensors
+  Tensor<double> x("x", {300}, Dense);
+  x.insert({299}, 2.0);
+  x.insert({7}, 1.0);
+  x.pack();
+  Tensor<double> expected("expected", {5}, Dense);
+  expected.insert({0}, 4.0);
+  expected.insert({3}, -3.5);
+  expected.pack();
+  Tensor<double> y("y", {5}, Dense);
+  Tensor<double> M = mapped;
+  y(i) = M(i, j) * x(j);
+  y.evaluate();
+  ASSERT_TRUE(equals(expected, y));
+
+#ifdef PYTHON
+  ASSERT_THROW(read(filename, Dense), TacoException);
+#else
+  ASSERT_DEATH(read(filename, Dense), "cannot be read in the format");
+#endif
+
+  // Pos arrays that point past their crd arrays are rejected
+  std::stringstream written;
+  writeTTB(written, B);
+  std::string bytes = written.str();
+  const int32_t pos[] = {0, 2, 2, 2, 3, 4};
+  size_t offset = bytes.find(std::string((const char*)pos, sizeof(pos)));
+  ASSERT_NE(std::string::npos, offset);
+  const int32_t end = 100;
+  bytes.replace(offset + 5 * sizeof(int32_t), sizeof(end),
+                (const char*)&end, sizeof(end));
+  std::stringstream corrupted(bytes);
+#ifdef PYTHON
+  ASSERT_THROW(readTTB(corrupted, CSR), TacoException);
+#else
+  ASSERT_DEATH(readTTB(corrupted, CSR), "points past its crd array");
+#endif
+
+  // Arrays whose types differ from those of the format are rejected before
+  // they are mapped
+  auto retype = [&](Datatype from, Datatype to, uint64_t size) {
+    uint32_t fromKind = from.getKind();
+    uint32_t toKind = to.getKind();
+    std::string array = std::string((const char*)&fromKind, sizeof(fromKind)) +
+                        std::string((const char*)&size, sizeof(size));
+    std::string retyped = written.str();
+    size_t offset = retyped.find(array);
+    EXPECT_NE(std::string::npos, offset);
+    retyped.replace(offset, sizeof(toKind), (const char*)&toKind,
+                    sizeof(toKind));
+    std::string retypedFilename = util::getTmpdir() + "retyped_" +
+                                  util::toString(to) + ".ttb";
+    std::ofstream(retypedFilename, std::ios::binary) << retyped;
+    return retypedFilename;
+  };
+  std::string retypedValues = retype(Float64, Int64, 4);
+  std::string retypedCrd = retype(Int32, UInt32, 4);
+#ifdef PYTHON
+  ASSERT_THROW(read(retypedValues, CSR), TacoException);
+  ASSERT_THROW(read(retypedCrd, CSR), TacoException);
+#else
+  ASSERT_DEATH(read(retypedValues, CSR), "rather than its component type");
+  ASSERT_DEATH(read(retypedCrd, CSR), "do not have the types of its format");
+#endif
+}
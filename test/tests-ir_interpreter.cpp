@@ -0,0 +1,157 @@
+#include "test.h"
+#include "test_tensors.h"
+
+#include <cstdlib>
+
+#include "taco/tensor.h"
+#include "taco/ir/ir_interpreter.h"
+#include "taco/lower/lower.h"
+
+using namespace taco;
+
+TEST(interpreter, spmv) {
+  Tensor<double> B("B", {3, 4}, CSR);
+  B.insert({0, 1}, 1.0);
+  B.insert({0, 3}, 2.0);
+  B.insert({2, 0}, 3.0);
+  B.insert({2, 2}, 4.0);
+  B.pack();
+
+  Tensor<double> c("c", {4}, Format({Dense}));
+  c.insert({0}, 1.0);
+  c.insert({1}, 2.0);
+  c.insert({2}, 3.0);
+  c.insert({3}, 4.0);
+  c.pack();
+
+  Tensor<double> a("a", {3}, Format({Dense}));
+  IndexVar i, j;
+  a(i) = B(i,j) * c(j);
+
+  ir::Stmt compute = lower(makeConcreteNotation(a.getAssignment()), "compute",
+                           true, true);
+  ASSERT_TRUE(ir::canInterpret(compute));
+
+  taco_tensor_t* result = a.getTacoTensorT();
+  void* args[] = {result, B.getTacoTensorT(), c.getTacoTensorT()};
+  ASSERT_EQ(0, ir::interpret(compute, args));
+
+  // The interpreter allocates the values of the result, like compiled code
+  const double* vals = (const double*)result->vals;
+  ASSERT_DOUBLE_EQ(10.0, vals[0]);
+  ASSERT_DOUBLE_EQ(0.0,  vals[1]);
+  ASSERT_DOUBLE_EQ(15.0, vals[2]);
+  free(result->vals);
+  result->vals = nullptr;
+}
+
+TEST(interpreter, compileAsync) {
+  Tensor<double> B("B", {3, 3}, CSR);
+  B.insert({0, 0}, 1.0);
+  B.insert({1, 2}, 2.0);
+  B.pack();
+
+  Tensor<double> C("C", {3, 3}, CSR);
+  C.insert({0, 0}, 3.0);
+  C.insert({2, 1}, 4.0);
+  C.pack();
+
+  Tensor<double> expected("expected", {3, 3}, CSR);
+  expected.insert({0, 0}, 4.0);
+  expected.insert({1, 2}, 2.0);
+  expected.insert({2, 1}, 4.0);
+  expected.pack();
+
+  IndexVar i, j;
+  Tensor<double> A("A", {3, 3}, CSR);
+  A(i,j) = B(i,j) + C(i,j);
+
+  // Evaluates with the interpreter or the compiled kernels, depending on
+  // whether the compiler has finished
+  auto compiled = A.compileAsync();
+  A.assemble();
+  A.compute();
+  ASSERT_TRUE(equals(expected, A));
+
+  ASSERT_NE(nullptr, compiled.get());
+  A(i,j) = B(i,j) + C(i,j);
+  A.compileAsync();
+  A.assemble();
+  A.compute();
+  ASSERT_TRUE(equals(expected, A));
+}
+
+TEST(interpreter, compileAsyncError) {
+  Tensor<double> b("b", {3}, Format({Dense}));
+  b.insert({1}, 2.0);
+  b.pack();
+
+  // Compile with a command that always fails
+  IndexVar i;
+  Tensor<double> a("a", {3}, Format({Dense}));
+  a(i) = b(i) * b(i) - b(i);
+  const char* cc = getenv("TACO_CC");
+  const string oldCC = cc ? cc : "";
+  setenv("TACO_CC", "false", 1);
+  auto compiled = a.compileAsync();
+  compiled.wait();
+  if (cc) {
+    setenv("TACO_CC", oldCC.c_str(), 1);
+  } else {
+    unsetenv("TACO_CC");
+  }
+
+  ASSERT_THROW(compiled.get(), taco::TacoException);
+#ifdef PYTHON
+  ASSERT_THROW({a.assemble(); a.compute();}, taco::TacoException);
+#else
+  ASSERT_DEATH({a.assemble(); a.compute();}, "Compilation command failed");
+#endif
+}
+
+TEST(interpreter, executionMode) {
+  Tensor<double> B("B", {4, 5}, CSR);
+  Tensor<double> C("C", {5, 4}, CSR);
+  for (int i = 0; i < 4; ++i) {
+    B.insert({i, (2*i) % 5}, i + 1.0);
+    B.insert({i, (3*i + 1) % 5}, -2.0);
+    C.insert({(i + 2) % 5, i}, 0.5 * i);
+    C.insert({(2*i) % 5, (i + 1) % 4}, 3.0);
+  }
+  B.pack();
+  C.pack();
+
+  Tensor<double> d("d", {4}, Format({Dense}));
+  for (int i = 0; i < 4; ++i) {
+    d.insert({i}, 2.0 - i);
+  }
+  d.pack();
+
+  IndexVar i, j, k;
+  auto define = [&](Tensor<double>& A, Tensor<double>& a, Tensor<double>& e) {
+    A(i,j) = B(i,k) * C(k,j);
+    a(i) = A(i,j) * d(j);
+    e(i) = sqrt(abs(a(i))) + d(i);
+  };
+
+  Tensor<double> expectedA("expectedA", {4, 4}, CSR);
+  Tensor<double> expecteda("expecteda", {4}, Format({Sparse}));
+  Tensor<double> expectede("expectede", {4}, Format({Dense}));
+  define(expectedA, expecteda, expectede);
+  expectede.evaluate();
+
+  for (auto mode : {ExecutionMode::Interpreted, ExecutionMode::Auto}) {
+    Tensor<double> A("A", {4, 4}, CSR);
+    Tensor<double> a("a", {4}, Format({Sparse}));
+    Tensor<double> e("e", {4}, Format({Dense}));
+    A.setExecutionMode(mode);
+    a.setExecutionMode(mode);
+    e.setExecutionMode(mode);
+    ASSERT_EQ(mode, A.getExecutionMode());
+    define(A, a, e);
+    e.evaluate();
+    ASSERT_TRUE(equals(expectedA, A));
+    ASSERT_TRUE(equals(expecteda, a));
+    ASSERT_TRUE(equals(expectede, e));
+  }
+}
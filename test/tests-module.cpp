@@ -0,0 +1,162 @@
+#include "test.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include <utime.h>
+
+#include "taco/codegen/module.h"
+#include "taco/ir/ir.h"
+#include "taco/util/env.h"
+#include "codegen/tcc_compiler.h"
+
+using namespace taco;
+using taco::ir::Module;
+
+/// Sets an environment variable until the end of the scope, and then restores
+/// its previous value.
+struct ScopedEnv {
+  ScopedEnv(const char* name, const string& value) : name(name) {
+    const char* oldValue = getenv(name);
+    wasSet = (oldValue != nullptr);
+    if (wasSet) {
+      this->oldValue = oldValue;
+    }
+    setenv(name, value.c_str(), 1);
+  }
+  ~ScopedEnv() {
+    if (wasSet) {
+      setenv(name, oldValue.c_str(), 1);
+    } else {
+      unsetenv(name);
+    }
+  }
+  const char* name;
+  bool wasSet;
+  string oldValue;
+};
+
+TEST(module, persistentCache) {
+  // Missing parents of the cache directory are created
+  string cachedir = util::getTmpdir() + "kernel_cache/nested/";
+  ScopedEnv env("TACO_CACHE_DIR", cachedir);
+
+  string source = "int forty_two(void** args) { return 42; }\n";
+
+  Module first;
+  first.setSource(source);
+  string firstPath = first.compile();
+  ASSERT_NE(cachedir, firstPath.substr(0, cachedir.size()));
+
+  // An identical library must be loaded from the cache instead of rebuilt
+  Module second;
+  second.setSource(source);
+  string secondPath = second.compile();
+  ASSERT_EQ(cachedir, secondPath.substr(0, cachedir.size()));
+  ASSERT_EQ(42, second.callFuncPackedRaw("forty_two", nullptr));
+
+  // A different library must not hit the same entry
+  Module third;
+  third.setSource("int forty_three(void** args) { return 43; }\n");
+  string thirdPath = third.compile();
+  ASSERT_NE(cachedir, thirdPath.substr(0, cachedir.size()));
+  ASSERT_EQ(43, third.callFuncPackedRaw("forty_three", nullptr));
+
+  // Threads that build the same library store it without clobbering each
+  // other's temporary files
+  vector<int> results(4);
+  vector<std::thread> threads;
+  for (int t = 0; t < (int)results.size(); t++) {
+    threads.emplace_back([&results, t]() {
+      Module concurrent;
+      concurrent.setSource("int forty_four(void** args) { return 44; }\n");
+      concurrent.compile();
+      results[t] = concurrent.callFuncPackedRaw("forty_four", nullptr);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int result : results) {
+    ASSERT_EQ(44, result);
+  }
+  Module cached;
+  cached.setSource("int forty_four(void** args) { return 44; }\n");
+  ASSERT_EQ(cachedir, cached.compile().substr(0, cachedir.size()));
+
+  // Temporary files of stores that crashed are removed once they are stale,
+  // while those of stores that may still be running are kept
+  string staleTmpPath = cachedir + "stale.so.tmpABCDEF";
+  string recentTmpPath = cachedir + "recent.so.tmpABCDEF";
+  std::ofstream(staleTmpPath) << "stale";
+  std::ofstream(recentTmpPath) << "recent";
+  struct utimbuf times;
+  times.actime = times.modtime = time(nullptr) - 2 * 60 * 60;
+  ASSERT_EQ(0, utime(staleTmpPath.c_str(), &times));
+  Module evicting;
+  evicting.setSource("int forty_five(void** args) { return 45; }\n");
+  evicting.compile();
+  ASSERT_NE(0, access(staleTmpPath.c_str(), F_OK));
+  ASSERT_EQ(0, access(recentTmpPath.c_str(), F_OK));
+  remove(recentTmpPath.c_str());
+}
+
+TEST(module, libtcc) {
+  Target target = getTargetFromEnvironment();
+  target.jit = Target::LibTCC;
+
+  // Compiles into memory if libtcc is installed, and falls back to the
+  // external compiler otherwise
+  Module module(target);
+  module.setSource("int forty_two(void** args) { return 42; }\n");
+  string path = module.compile();
+  ASSERT_EQ(ir::TCCCompiler::isAvailable(), path.empty());
+  ASSERT_EQ(42, module.callFuncPackedRaw("forty_two", nullptr));
+
+  // Code that libtcc rejects is built by the external compiler
+  Module rejected(target);
+  rejected.setSource("#include <complex.h>\n"
+                     "int forty_three(void** args) {\n"
+                     "  double _Complex c = 43.0 + 1.0 * I;\n"
+                     "  return (int)creal(c * conj(c) / c);\n"
+                     "}\n");
+  ASSERT_NE("", rejected.compile());
+  ASSERT_EQ(43, rejected.callFuncPackedRaw("forty_three", nullptr));
+
+  // Modules may be compiled concurrently, as compileAsync does
+  vector<int> results(4);
+  vector<std::thread> threads;
+  for (int t = 0; t < (int)results.size(); t++) {
+    threads.emplace_back([&target, &results, t]() {
+      Module concurrent(target);
+      concurrent.setSource("int value(void** args) { return " +
+                           std::to_string(t) + "; }\n");
+      concurrent.compile();
+      results[t] = concurrent.callFuncPackedRaw("value", nullptr);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < (int)results.size(); t++) {
+    ASSERT_EQ(t, results[t]);
+  }
+}
+
+TEST(module, hasParallelLoops) {
+  ir::Expr i = ir::Var::make("i", Int32);
+  ir::Expr a = ir::Var::make("a", Float64, true);
+  ir::Stmt body = ir::Store::make(a, i, ir::Literal::make(1.0));
+
+  // Vectorized loops run on a single thread
+  Module vectorized;
+  vectorized.addFunction(ir::Function::make("vectorized", {a}, {},
+      ir::For::make(i, 0, 8, 1, body, ir::LoopKind::Vectorized)));
+  ASSERT_FALSE(vectorized.hasParallelLoops());
+
+  Module parallel;
+  parallel.addFunction(ir::Function::make("parallel", {a}, {},
+      ir::For::make(i, 0, 8, 1, body, ir::LoopKind::Static_Chunked)));
+  ASSERT_TRUE(parallel.hasParallelLoops());
+}
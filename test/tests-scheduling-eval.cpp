@@ -582,6 +582,132 @@ TEST(scheduling_eval, spmvCPU) {
   ASSERT_TENSOR_EQ(expected, y);
 }
 
+TEST(scheduling_eval, spmvVectorizedCPU) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  int NUM_I = 1021/10;
+  int NUM_J = 1039/10;
+  float SPARSITY = .3;
+  Tensor<double> A("A", {NUM_I, NUM_J}, CSR);
+  Tensor<double> x("x", {NUM_J}, {Dense});
+  Tensor<double> y("y", {NUM_I}, {Dense});
+
+  srand(120);
+  for (int i = 0; i < NUM_I; i++) {
+    for (int j = 0; j < NUM_J; j++) {
+      float rand_float = (float)rand()/(float)(RAND_MAX);
+      if (rand_float < SPARSITY) {
+        A.insert({i, j}, (double) ((int) (rand_float * 3 / SPARSITY)));
+      }
+    }
+  }
+
+  for (int j = 0; j < NUM_J; j++) {
+    float rand_float = (float)rand()/(float)(RAND_MAX);
+    x.insert({j}, (double) ((int) (rand_float*3/SPARSITY)));
+  }
+
+  x.pack();
+  A.pack();
+
+  y(i) = A(i, j) * x(j);
+
+  // The vectorized loops over full and partial vectors of each row reduce
+  // into a promoted scalar
+  IndexVar jpos("jpos"), jpos0("jpos0"), jpos1("jpos1");
+  IndexStmt stmt = y.getAssignment().concretize();
+  stmt = stmt.pos(j, jpos, A(i,j))
+             .split(jpos, jpos0, jpos1, 8)
+             .parallelize(jpos1, ParallelUnit::CPUVector,
+                          OutputRaceStrategy::ParallelReduction);
+  stmt = scalarPromote(stmt);
+
+  stringstream source;
+  std::shared_ptr<ir::CodeGen> codegen = ir::CodeGen::init_default(source, ir::CodeGen::ImplementationGen);
+  codegen->compile(lower(stmt, "compute", false, true), false);
+  size_t simd = source.str().find("#pragma omp simd reduction(+:");
+  ASSERT_NE(string::npos, simd);
+  ASSERT_NE(string::npos,
+            source.str().find("#pragma omp simd reduction(+:", simd + 1));
+
+  y.setExecutionMode(ExecutionMode::Compiled);
+  y.compile(stmt);
+  y.assemble();
+  y.compute();
+
+  Tensor<double> expected("expected", {NUM_I}, {Dense});
+  expected(i) = A(i, j) * x(j);
+  expected.compile();
+  expected.assemble();
+  expected.compute();
+  ASSERT_TENSOR_EQ(expected, y);
+
+  // Scatters through the coordinates of A could update an element of z twice
+  // in one vector, so they are left to Clang's hint
+  Tensor<double> z("z", {NUM_J}, {Dense});
+  z(j) = A(i, j) * y(i);
+  IndexStmt scatter = z.getAssignment().concretize().reorder(j, i);
+  scatter = scatter.pos(j, jpos, A(i,j))
+                   .split(jpos, jpos0, jpos1, 8)
+                   .parallelize(jpos1, ParallelUnit::CPUVector,
+                                OutputRaceStrategy::IgnoreRaces);
+  stringstream scatterSource;
+  codegen = ir::CodeGen::init_default(scatterSource,
+                                      ir::CodeGen::ImplementationGen);
+  codegen->compile(lower(scatter, "compute", false, true), false);
+  ASSERT_EQ(string::npos, scatterSource.str().find("#pragma omp simd"));
+  ASSERT_NE(string::npos, scatterSource.str().find("#pragma clang loop"));
+
+  // Iterations that accumulate into the same component are not vectorized
+  // explicitly
+  stmt = y.getAssignment().concretize();
+  stmt = stmt.pos(j, jpos, A(i,j))
+             .split(jpos, jpos0, jpos1, 8)
+             .parallelize(jpos1, ParallelUnit::CPUVector,
+                          OutputRaceStrategy::ParallelReduction);
+  stringstream reductionSource;
+  codegen = ir::CodeGen::init_default(reductionSource,
+                                      ir::CodeGen::ImplementationGen);
+  codegen->compile(lower(stmt, "compute", false, true), false);
+  ASSERT_NE(string::npos, reductionSource.str().find("#pragma clang loop"));
+  ASSERT_EQ(string::npos, reductionSource.str().find("#pragma omp simd"));
+}
+
+TEST(scheduling_eval, vectorizedNestedStore) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  ir::Expr i = ir::Var::make("i", Int32);
+  ir::Expr k = ir::Var::make("k", Int32);
+  ir::Expr a = ir::Var::make("a", Float64, true);
+  ir::Expr b = ir::Var::make("b", Float64, true);
+
+  // Each iteration of i only updates a[i], however often it does so
+  ir::Stmt accumulate = ir::Store::make(a, i,
+      ir::Add::make(ir::Load::make(a, i), ir::Load::make(b, k)));
+  stringstream source;
+  std::shared_ptr<ir::CodeGen> codegen =
+      ir::CodeGen::init_default(source, ir::CodeGen::ImplementationGen);
+  codegen->compile(ir::Function::make("accumulate", {a}, {b},
+      ir::For::make(i, 0, 8, 1, ir::For::make(k, 0, 4, 1, accumulate),
+                    ir::LoopKind::Vectorized)), false);
+  ASSERT_NE(string::npos, source.str().find("#pragma omp simd"));
+
+  // Iterations i and i+1 both update a[i+1] when offset by the inner loop
+  ir::Expr loc = ir::Add::make(i, k);
+  ir::Stmt overlap = ir::Store::make(a, loc,
+      ir::Add::make(ir::Load::make(a, loc), ir::Load::make(b, k)));
+  stringstream overlapSource;
+  codegen = ir::CodeGen::init_default(overlapSource,
+                                      ir::CodeGen::ImplementationGen);
+  codegen->compile(ir::Function::make("overlap", {a}, {b},
+      ir::For::make(i, 0, 8, 1, ir::For::make(k, 0, 4, 1, overlap),
+                    ir::LoopKind::Vectorized)), false);
+  ASSERT_EQ(string::npos, overlapSource.str().find("#pragma omp simd"));
+  ASSERT_NE(string::npos, overlapSource.str().find("#pragma clang loop"));
+}
+
 TEST(scheduling_eval, ttvCPU) {
   if (should_use_CUDA_codegen()) {
     return;
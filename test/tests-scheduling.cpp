@@ -7,6 +7,7 @@
 #include "taco/index_notation/index_notation.h"
 #include "codegen/codegen.h"
 #include "taco/lower/lower.h"
+#include "taco/lower/mode_format_hashed.h"
 
 using namespace taco;
 const IndexVar i("i"), j("j"), k("k");
@@ -411,6 +412,222 @@ TEST(scheduling, parallelizeTemporaryReduction) {
 //  codegen->compile(compute, true);
 }
 
+TEST(scheduling, parallelizeTemporaryScatter) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  Tensor<double> A("A", {16, 8}, CSR);
+  Tensor<double> x("x", {16}, {Dense});
+  for (int i = 0; i < 16; i++) {
+    for (int j = 0; j < 8; j++) {
+      if ((i + 2 * j) % 3 == 0) {
+        A.insert({i, j}, (double) i + j);
+      }
+    }
+    x.insert({i}, (double) i);
+  }
+  A.pack();
+  x.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> y("y", {8}, {Dense});
+  y(j) = A(i, j) * x(i);
+
+  IndexStmt stmt = y.getAssignment().concretize().reorder({i, j});
+  stmt = stmt.parallelize(i, ParallelUnit::CPUThread,
+                          OutputRaceStrategy::Temporary);
+  ASSERT_TRUE(isa<Forall>(stmt));
+  ASSERT_EQ(OutputRaceStrategy::Temporary,
+            to<Forall>(stmt).getOutputRaceStrategy());
+
+  y.compile(stmt);
+  y.assemble();
+  y.compute();
+
+  Tensor<double> expected("expected", {8}, {Dense});
+  expected(j) = A(i, j) * x(i);
+  expected.evaluate();
+  ASSERT_TENSOR_EQ(expected, y);
+
+  // Results too large to copy per thread are updated with atomics
+  TensorVar B("B", Type(Float64, {16, 1 << 21}), CSR);
+  TensorVar z("z", Type(Float64, {1 << 21}), {Dense});
+  IndexStmt large = forall(i, forall(j, z(j) += B(i, j) * x(i)));
+  large = large.parallelize(i, ParallelUnit::CPUThread,
+                            OutputRaceStrategy::Temporary);
+  ASSERT_TRUE(isa<Forall>(large));
+  ASSERT_EQ(OutputRaceStrategy::Atomics,
+            to<Forall>(large).getOutputRaceStrategy());
+}
+
+TEST(scheduling, parallelizeSparseOutput) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  Tensor<double> A("A", {8, 16}, CSR);
+  Tensor<double> B("B", {8, 16}, CSR);
+  for (int i = 0; i < 8; i++) {
+    for (int j = 0; j < 16; j++) {
+      if ((i + j) % 3 == 0) {
+        A.insert({i, j}, (double) i + j);
+      }
+      if (i != 5 && (i * j) % 4 == 1) {
+        B.insert({i, j}, (double) j);
+      }
+    }
+  }
+  A.pack();
+  B.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> expected("expected", {8, 16}, CSR);
+  expected(i, j) = A(i, j) + B(i, j);
+  expected.evaluate();
+
+  for (bool assembleWhileCompute : {false, true}) {
+    Tensor<double> C("C", {8, 16}, CSR);
+    C(i, j) = A(i, j) + B(i, j);
+
+    IndexStmt stmt = C.getAssignment().concretize();
+    stmt = stmt.parallelize(i, ParallelUnit::CPUThread,
+                            OutputRaceStrategy::NoRaces);
+
+    C.compile(stmt, assembleWhileCompute);
+    C.assemble();
+    C.compute();
+    ASSERT_TENSOR_EQ(expected, C);
+  }
+
+  // The assembly loops run twice over the rows in parallel, once to count the
+  // coordinates of the rows and once to store them, and the counts are
+  // scanned into the pos array in parallel between the two passes
+  Tensor<double> D("D", {8, 16}, CSR);
+  D(i, j) = A(i, j) + B(i, j);
+  D.setExecutionMode(ExecutionMode::Compiled);
+  D.compile(D.getAssignment().concretize()
+                 .parallelize(i, ParallelUnit::CPUThread,
+                              OutputRaceStrategy::NoRaces));
+  std::string source = D.getSource();
+  size_t assemble = source.find("int assemble(");
+  std::string assembleSource = source.substr(assemble,
+                                             source.find("int compute(") -
+                                             assemble);
+  auto count = [&](const std::string& pattern) {
+    int occurrences = 0;
+    for (size_t pos = assembleSource.find(pattern); pos != std::string::npos;
+         pos = assembleSource.find(pattern, pos + 1)) {
+      occurrences++;
+    }
+    return occurrences;
+  };
+  ASSERT_EQ(2, count("#pragma omp parallel for schedule(runtime)"));
+  ASSERT_EQ(2, count("#pragma omp parallel for schedule(static, 1)"));
+  ASSERT_NE(std::string::npos, assembleSource.find("TACO_NUM_THREADS()"));
+  D.assemble();
+  D.compute();
+  ASSERT_TENSOR_EQ(expected, D);
+
+  Tensor<double> X("X", {4, 3, 16}, {Dense, Dense, Sparse});
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 3; j++) {
+      for (int k = 0; k < 16; k++) {
+        if ((i + j + k) % 5 == 0) {
+          X.insert({i, j, k}, (double) k);
+        }
+      }
+    }
+  }
+  X.pack();
+
+  IndexVar k("k");
+  Tensor<double> expected3("expected", {4, 3, 16}, {Dense, Dense, Sparse});
+  expected3(i, j, k) = X(i, j, k) * 2;
+  expected3.evaluate();
+
+  Tensor<double> Y("Y", {4, 3, 16}, {Dense, Dense, Sparse});
+  Y(i, j, k) = X(i, j, k) * 2;
+  IndexStmt stmt = Y.getAssignment().concretize();
+  stmt = stmt.parallelize(i, ParallelUnit::CPUThread,
+                          OutputRaceStrategy::NoRaces);
+  Y.compile(stmt);
+  Y.assemble();
+  Y.compute();
+  ASSERT_TENSOR_EQ(expected3, Y);
+}
+
+TEST(scheduling, hashedWorkspace) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  Tensor<double> A("A", {8, 16}, CSR);
+  Tensor<double> B("B", {16, 16}, CSR);
+  for (int i = 0; i < 16; i++) {
+    for (int j = 0; j < 16; j++) {
+      if (i < 8 && (i + 2 * j) % 5 == 0) {
+        A.insert({i, j}, (double) i + j);
+      }
+      if ((3 * i + j) % 7 == 1) {
+        B.insert({i, j}, (double) j - i);
+      }
+    }
+  }
+  A.pack();
+  B.pack();
+
+  IndexVar i("i"), j("j"), k("k");
+  Tensor<double> expected("expected", {8, 16}, {Dense, Dense});
+  expected(i, j) = A(i, k) * B(k, j);
+  expected.evaluate();
+
+  // A table of two slots is grown while rows are accumulated into it
+  Tensor<double> C("C", {8, 16}, CSR);
+  TensorVar w("w", Type(Float64, {16}),
+              Format({ModeFormat(std::make_shared<HashedModeFormat>(2))}));
+  IndexStmt stmt = forall(i, where(forall(j, C(i, j) = w(j)),
+                                   forall(k, forall(j,
+                                       w(j) += A(i, k) * B(k, j)))));
+  C(i, j) = A(i, k) * B(k, j);
+  C.compile(stmt);
+  C.assemble();
+  C.compute();
+  ASSERT_TENSOR_EQ(expected, C);
+
+  // The default schedule of a product of sparse matrices with long rows of
+  // few nonzeros accumulates them in hashed workspaces, which only hold the
+  // nonzeros of the rows
+  const int N = 1 << 17;
+  Tensor<double> D("D", {8, N}, CSR);
+  Tensor<double> E("E", {N, N}, CSR);
+  std::map<std::pair<int,int>,double> products;
+  for (int k = 0; k < N; k++) {
+    E.insert({k, (7 * k) % N}, 2.0);
+  }
+  for (int i = 0; i < 8; i++) {
+    for (int k = i; k < N; k += N / 4) {
+      D.insert({i, k}, (double) k);
+      products[{i, (7 * k) % N}] += 2.0 * k;
+    }
+  }
+  D.pack();
+  E.pack();
+
+  Tensor<double> expectedF("expected", {8, N}, CSR);
+  for (auto& product : products) {
+    expectedF.insert({product.first.first, product.first.second},
+                     product.second);
+  }
+  expectedF.pack();
+
+  Tensor<double> F("F", {8, N}, CSR);
+  F(i, j) = D(i, k) * E(k, j);
+  F.evaluate();
+  ASSERT_EQ(products.size(), F.getStorage().getValues().getSize());
+  ASSERT_TENSOR_EQ(expectedF, F);
+}
+
 TEST(scheduling, multilevel_tiling) {
   Tensor<double> A("A", {8}, {Sparse});
   Tensor<double> B("B", {8}, {Sparse});
@@ -823,3 +1040,60 @@ TEST(scheduling_eval_test, spmv_fuse) {
   expected.compute();
   ASSERT_TENSOR_EQ(expected, y);
 }
+
+TEST(scheduling, blockIntersect) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  // Rows whose coordinates rarely coincide, so that long runs of them are
+  // skipped a block at a time
+  const int N = 200;
+  Tensor<double> A("A", {4, N}, CSR);
+  Tensor<double> B("B", {4, N}, CSR);
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < N; j++) {
+      if (j % (i + 2) == 0) {
+        A.insert({i, j}, (double) i + j);
+      }
+      if (j % 23 == i) {
+        B.insert({i, j}, (double) j - i);
+      }
+    }
+  }
+  A.pack();
+  B.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> expected("expected", {4, N}, CSR);
+  expected(i, j) = A(i, j) * B(i, j);
+  expected.evaluate();
+
+  for (auto mode : {ExecutionMode::Interpreted, ExecutionMode::Compiled}) {
+    Tensor<double> C("C", {4, N}, CSR);
+    C(i, j) = A(i, j) * B(i, j);
+    IndexStmt stmt = C.getAssignment().concretize()
+                                      .mergeby(j, MergeStrategy::BlockIntersect);
+    C.setExecutionMode(mode);
+    C.compile(stmt);
+    // The SIMD hint in the search helpers must not mark serial kernels as
+    // parallel
+    ASSERT_EQ(std::string::npos, C.getSource().find("#pragma omp"));
+    C.assemble();
+    C.compute();
+    ASSERT_TENSOR_EQ(expected, C);
+  }
+
+  // Unions are merged coordinate by coordinate
+  Tensor<double> expectedSum("expected", {4, N}, CSR);
+  expectedSum(i, j) = A(i, j) + B(i, j);
+  expectedSum.evaluate();
+
+  Tensor<double> D("D", {4, N}, CSR);
+  D(i, j) = A(i, j) + B(i, j);
+  D.compile(D.getAssignment().concretize()
+                             .mergeby(j, MergeStrategy::BlockIntersect));
+  D.assemble();
+  D.compute();
+  ASSERT_TENSOR_EQ(expectedSum, D);
+}
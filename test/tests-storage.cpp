@@ -5,6 +5,7 @@
 
 #include "taco/tensor.h"
 #include "taco/format.h"
+#include "taco/storage/pack.h"
 #include "taco/util/strings.h"
 
 typedef int                     IndexType;
@@ -487,3 +488,22 @@ INSTANTIATE_TEST_CASE_P(tensor3, storage,
                     )
            )
 );
+
+TEST(storage, sortCoordinates) {
+  // Components of a 3x4 matrix with row-major ordering {1,0}: columns first
+  struct Component { int i, j; double val; };
+  vector<Component> components = {
+    {2, 3, 1.0}, {0, 1, 2.0}, {1, 1, 3.0}, {0, 1, 4.0}, {2, 0, 5.0}
+  };
+  vector<int> i(components.size());
+  vector<int> j(components.size());
+  vector<double> vals(components.size());
+  taco::sortCoordinates((const char*)components.data(), components.size(),
+                        {1, 0}, sizeof(double), {j.data(), i.data()},
+                        (char*)vals.data());
+  ASSERT_EQ(vector<int>({0, 1, 1, 1, 3}), j);
+  ASSERT_EQ(vector<int>({2, 0, 0, 1, 2}), i);
+
+  // Duplicates keep the order in which they were inserted
+  ASSERT_EQ(vector<double>({5.0, 2.0, 4.0, 3.0, 1.0}), vals);
+}
@@ -114,6 +114,114 @@ TEST(tensor, transpose) {
   ASSERT_TRUE(equals(tensor.transpose({0,1,2}), tensor));
 }
 
+TEST(tensor, convert) {
+  const std::vector<int> dims = {7, 5, 9};
+  std::vector<std::pair<std::vector<int>, double>> components;
+  for (int i = 0; i < dims[0]; i++) {
+    for (int j = 0; j < dims[1]; j++) {
+      for (int k = 0; k < dims[2]; k++) {
+        if ((i * 5 + j * 7 + k * 3) % 4 == 0) {
+          components.push_back({{i, j, k}, i * 100.0 + j * 10.0 + k + 1});
+        }
+      }
+    }
+  }
+
+  std::vector<Format> formats = {
+      Format({Sparse, Sparse, Sparse}),
+      Format({Sparse, Sparse, Sparse}, {2, 0, 1}),
+      Format({Dense, Sparse, Sparse}, {1, 2, 0}),
+      Format({Dense, Dense, Sparse}, {2, 1, 0}),
+      Format({Dense, Dense, Dense}, {0, 2, 1}),
+      Format({Dense, Dense, Hashed}, {1, 0, 2}),
+      Format({Dense, Dense, Bitmap}, {2, 0, 1}),
+      COO(3, false, true, false, {1, 0, 2})};
+  std::vector<std::vector<int>> modeOrderings = {{0, 1, 2}, {2, 0, 1},
+                                                 {1, 2, 0}};
+  for (size_t i = 0; i < formats.size(); i++) {
+    const Format& sourceFormat = formats[i];
+    Tensor<double> source("source", dims, sourceFormat);
+    for (auto& component : components) {
+      source.insert(component.first, component.second);
+    }
+    source.pack();
+    for (size_t offset : {0, 1, 3}) {
+      const Format& format = formats[(i + offset) % formats.size()];
+      for (auto& modeOrdering : modeOrderings) {
+        SCOPED_TRACE(util::toString(sourceFormat) + " to " +
+                     util::toString(format) + " with modes (" +
+                     util::join(modeOrdering) + ")");
+        std::vector<int> permutedDims;
+        for (int mode : modeOrdering) {
+          permutedDims.push_back(dims[mode]);
+        }
+        Tensor<double> expected("expected", permutedDims, format);
+        for (auto& component : components) {
+          std::vector<int> coordinate;
+          for (int mode : modeOrdering) {
+            coordinate.push_back(component.first[mode]);
+          }
+          expected.insert(coordinate, component.second);
+        }
+        expected.pack();
+
+        TensorBase converted = convert(source, modeOrdering, format);
+        ASSERT_EQ(format, converted.getFormat());
+        ASSERT_EQ(permutedDims, converted.getDimensions());
+        ASSERT_TRUE(equals(expected, converted));
+      }
+    }
+  }
+
+  Tensor<double> B("B", {4, 3}, CSR);
+  B.insert({0, 1}, 1.0);
+  B.insert({3, 0}, 2.0);
+  B.insert({2, 1}, 3.0);
+  Tensor<double> expected("expected", {4, 3}, CSC);
+  expected.insert({0, 1}, 1.0);
+  expected.insert({3, 0}, 2.0);
+  expected.insert({2, 1}, 3.0);
+  expected.pack();
+  Tensor<double> C = convert(B, CSC);
+  ASSERT_EQ(CSC, C.getFormat());
+  ASSERT_TRUE(equals(expected, C));
+}
+
+TEST(tensor, removeExplicitZeros) {
+  Tensor<double> A("A", {4, 3}, CSR);
+  A.insert({0, 1}, 1.0);
+  A.insert({1, 2}, 0.0);
+  A.insert({3, 0}, 2.0);
+  A.insert({2, 2}, 0.0);
+  A.pack();
+  Tensor<double> expected("expected", {4, 3}, CSC);
+  expected.insert({0, 1}, 1.0);
+  expected.insert({3, 0}, 2.0);
+  expected.pack();
+  Tensor<double> B = A.removeExplicitZeros(CSC);
+  ASSERT_EQ(CSC, B.getFormat());
+  ASSERT_TRUE(equals(expected, B));
+  ASSERT_EQ(2u, B.getStorage().getIndex().getSize());
+
+  // Enough components to be compacted by several threads
+  const int n = 1 << 18;
+  Tensor<double> C("C", {n, 8}, CSR);
+  Tensor<double> expectedC("expectedC", {n, 8}, CSR);
+  for (int i = 0; i < n; i++) {
+    double value = (i % 3 == 0) ? 0.0 : (double)i;
+    C.insert({i, i % 8}, value);
+    if (value != 0.0) {
+      expectedC.insert({i, i % 8}, value);
+    }
+  }
+  C.pack();
+  expectedC.pack();
+  Tensor<double> D = C.removeExplicitZeros(CSR);
+  ASSERT_TRUE(equals(expectedC, D));
+  ASSERT_EQ(expectedC.getStorage().getIndex().getSize(),
+            D.getStorage().getIndex().getSize());
+}
+
 TEST(tensor, operator_parens_insertion) {
   Tensor<double> a({5,5}, Sparse);
   a(1,2) = 42.0;
@@ -139,6 +247,47 @@ TEST(tensor, get_value) {
   ASSERT_EQ(val2, (double)a(2,2));
 }
 
+TEST(tensor, get_values) {
+  const std::vector<int> dims = {6, 70};
+  std::vector<std::vector<int>> coordinates;
+  for (int i = 0; i < dims[0]; i++) {
+    for (int j = 0; j < dims[1]; j++) {
+      coordinates.push_back({i, j});
+    }
+  }
+  coordinates.push_back({6, 0});
+  coordinates.push_back({0, -1});
+
+  std::vector<Format> formats = {CSR, CSC, DCSR, Format({Dense, Dense}),
+                                 COO(2), Format({Dense, Hashed}),
+                                 Format({Dense, Bitmap})};
+  for (auto& format : formats) {
+    Tensor<double> b("b", dims, format);
+    std::vector<double> expected;
+    for (auto& coordinate : coordinates) {
+      const int i = coordinate[0];
+      const int j = coordinate[1];
+      const bool stored = i < dims[0] && j >= 0 && (i * 7 + j * 3) % 5 == 0;
+      expected.push_back(stored ? i * 100 + j + 1 : 0.0);
+      if (stored) {
+        b.insert(coordinate, expected.back());
+      }
+    }
+    b.pack();
+    SCOPED_TRACE(util::toString(format));
+    for (size_t k = 0; k < coordinates.size() - 2; k++) {
+      ASSERT_EQ(expected[k], b.at(coordinates[k]));
+    }
+    std::vector<std::vector<int>> reversed(coordinates.rbegin(),
+                                           coordinates.rend());
+    std::vector<double> values = b.at(reversed);
+    ASSERT_EQ(std::vector<double>(expected.rbegin(), expected.rend()), values);
+  }
+
+  Tensor<double> empty("empty", dims, CSR);
+  ASSERT_EQ(0.0, empty.at({1, 2}));
+}
+
 TEST(tensor, set_from_components) {
   typedef Component<2, double> C;
 
@@ -479,3 +628,195 @@ TEST(tensor, recompile) {
   ASSERT_TRUE(c.needsCompile());
   ASSERT_EQ(c.begin()->second, 42.0);
 }
+
+TEST(tensor, compileTogether) {
+  Tensor<double> b({4}, Format({Dense}));
+  Tensor<double> c({4}, Format({Dense}));
+  for (int i = 0; i < 4; ++i) {
+    b.insert({i}, (double)i);
+    c.insert({i}, 10.0);
+  }
+  b.pack();
+  c.pack();
+
+  IndexVar i;
+  Tensor<double> x({4}, Format({Dense}));
+  Tensor<double> y({4}, Format({Dense}));
+  Tensor<double> z;
+  x(i) = b(i) * c(i) + b(i);
+  y(i) = b(i) * c(i) - c(i);
+  z = x(i) * c(i);
+
+  compile({x, y, z});
+  ASSERT_FALSE(x.needsCompile());
+  ASSERT_FALSE(y.needsCompile());
+  ASSERT_FALSE(z.needsCompile());
+
+  // All kernels live in one module
+  ASSERT_EQ(x.getSource(), y.getSource());
+  ASSERT_EQ(x.getSource(), z.getSource());
+
+  x.assemble();
+  x.compute();
+  y.assemble();
+  y.compute();
+  z.assemble();
+  z.compute();
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_DOUBLE_EQ(11.0 * i, x(i));
+    ASSERT_DOUBLE_EQ(10.0 * i - 10.0, y(i));
+  }
+  ASSERT_DOUBLE_EQ(660.0, z.begin()->second);
+}
+
+TEST(tensor, pack_unsorted) {
+  // Coordinates that need more than 64 bits are sorted over several keys
+  Format format({Sparse, Dense, Sparse, Sparse}, {2, 1, 0, 3});
+  Tensor<double> a({1 << 30, 3, 1 << 30, 1 << 20}, format);
+  map<vector<int>,double> vals;
+  unsigned seed = 42;
+  auto next = [&seed](int bound) {
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 8) % bound);
+  };
+  for (int n = 0; n < 2000; ++n) {
+    vector<int> coord = {next(1 << 30), next(3), next(64), next(1 << 20)};
+    if (n % 5 == 0) {
+      coord[0] = 7;
+      coord[3] = 3;
+    }
+    a.insert(coord, 1.0 + n);
+    vals[coord] += 1.0 + n;
+  }
+  a.pack();
+
+  vector<int> prev;
+  size_t numNonzeros = 0;
+  for (auto val = a.beginTyped<int>(); val != a.endTyped<int>(); ++val) {
+    vector<int> coord = val->first.toVector();
+    if (val->second == 0.0) {
+      continue;
+    }
+    vector<int> permuted = {coord[2], coord[1], coord[0], coord[3]};
+    ASSERT_TRUE(prev < permuted);
+    ASSERT_TRUE(util::contains(vals, coord));
+    ASSERT_EQ(vals.at(coord), val->second);
+    prev = permuted;
+    numNonzeros++;
+  }
+  ASSERT_EQ(vals.size(), numNonzeros);
+}
+
+TEST(tensor, insertComponents) {
+  Tensor<double> a({4, 5}, Format({Dense, Sparse}, {1, 0}));
+  a.insert({3, 4}, 1.0);
+
+  // Copied arrays may be reused once inserted
+  vector<int> i = {2, 0, 3, 2};
+  vector<int> j = {1, 4, 4, 1};
+  vector<double> vals = {2.0, 3.0, 4.0, 5.0};
+  a.insertComponents({makeArray(i.data(), i.size()),
+                      makeArray(j.data(), j.size())},
+                     makeArray(vals.data(), vals.size()));
+  i[0] = 1;
+
+  // Adopted arrays are freed by the tensor
+  int* k = new int[2]{0, 1};
+  int* l = new int[2]{0, 0};
+  double* adoptedVals = new double[2]{6.0, 7.0};
+  a.insertComponents({makeArray(k, 2, Array::Delete),
+                      makeArray(l, 2, Array::Delete)},
+                     makeArray(adoptedVals, 2, Array::Delete));
+
+  Tensor<double> expected({4, 5}, Format({Dense, Sparse}, {1, 0}));
+  expected.insert({0, 0}, 6.0);
+  expected.insert({1, 0}, 7.0);
+  expected.insert({2, 1}, 7.0);
+  expected.insert({0, 4}, 3.0);
+  expected.insert({3, 4}, 5.0);
+  expected.pack();
+  a.pack();
+  ASSERT_TRUE(equals(expected, a));
+
+  // Components inserted after packing are added to the packed components
+  vector<int> m = {0};
+  vector<int> n = {0};
+  vector<double> more = {1.0};
+  a.insertComponents({makeArray(m), makeArray(n)}, makeArray(more));
+  expected.insert({0, 0}, 1.0);
+  ASSERT_TRUE(equals(expected, a));
+
+  vector<int> negative = {-1};
+  vector<int> tooLarge = {5};
+#ifdef PYTHON
+  ASSERT_THROW(a.insertComponents({makeArray(negative), makeArray(n)},
+                                  makeArray(more)), TacoException);
+  ASSERT_THROW(a.insertComponents({makeArray(m), makeArray(tooLarge)},
+                                  makeArray(more)), TacoException);
+#else
+  ASSERT_DEATH(a.insertComponents({makeArray(negative), makeArray(n)},
+                                  makeArray(more)), "out of bounds");
+  ASSERT_DEATH(a.insertComponents({makeArray(m), makeArray(tooLarge)},
+                                  makeArray(more)), "out of bounds");
+#endif
+}
+
+TEST(tensor, preparedKernel) {
+  Tensor<double> B("B", {3, 4}, CSR);
+  B.insert({0, 1}, 1.0);
+  B.insert({2, 0}, 2.0);
+  B.insert({2, 3}, 3.0);
+  B.pack();
+
+  Tensor<double> c("c", {4}, Format({Dense}));
+  for (int j = 0; j < 4; ++j) {
+    c.insert({j}, j + 1.0);
+  }
+  c.pack();
+
+  IndexVar i, j;
+  Tensor<double> a("a", {3}, Format({Sparse}));
+  a.setExecutionMode(ExecutionMode::Interpreted);
+  a(i) = B(i,j) * c(j);
+
+  Tensor<double> expected("expected", {3}, Format({Sparse}));
+  expected.insert({0}, 2.0);
+  expected.insert({2}, 14.0);
+  expected.pack();
+
+  PreparedKernel kernel(a);
+  for (int n = 0; n < 3; ++n) {
+    kernel.assemble();
+    kernel.compute();
+    ASSERT_TRUE(equals(expected, a));
+  }
+  ASSERT_FALSE(a.needsAssemble());
+  ASSERT_FALSE(a.needsCompute());
+
+  // Rebound operands must have the same format, but may differ in structure
+  Tensor<double> B2("B2", {3, 4}, CSR);
+  B2.insert({1, 0}, 1.0);
+  B2.insert({1, 2}, -1.0);
+  B2.insert({2, 1}, 0.5);
+  kernel.bind(B.getTensorVar(), B2);
+  ASSERT_EQ(B2, kernel.getTensor(B.getTensorVar()));
+
+  Tensor<double> a2("a2", {3}, Format({Sparse}));
+  kernel.bind(a.getTensorVar(), a2);
+  kernel.assemble();
+  kernel.compute();
+
+  Tensor<double> expected2("expected2", {3}, Format({Sparse}));
+  expected2.insert({1}, -2.0);
+  expected2.insert({2}, 1.0);
+  expected2.pack();
+  ASSERT_TRUE(equals(expected2, a2));
+  ASSERT_TRUE(equals(expected, a));
+
+  Tensor<double> C("C", {3, 4}, Format({Dense, Dense}));
+#ifdef PYTHON
+  ASSERT_THROW(kernel.bind(B.getTensorVar(), C), TacoException);
+#else
+  ASSERT_DEATH(kernel.bind(B.getTensorVar(), C), "different format");
+#endif
+}
@@ -45,7 +45,7 @@ TYPED_TEST_P(VectorTensorTest, types) {
   ASSERT_EQ(t, a.getComponentType());
   ASSERT_EQ(1, a.getOrder());
   ASSERT_EQ(5, a.getDimension(0));
-  map<vector<int>,TypeParam> vals = {{{0}, 1.0}, {{2}, 2.0}};
+  map<vector<int>,TypeParam> vals = {{{0}, (TypeParam)1.0}, {{2}, (TypeParam)2.0}};
   for (auto& val : vals) {
     a.insert(val.first, val.second);
   }
@@ -379,7 +379,7 @@ TEST(tensor_types, int_float_promotion) {
   ASSERT_TRUE(equalsExact(a, expected));
 }
 
-TEST(DISABLED_tensor_types, coordinate_types) {
+TEST(tensor_types, coordinate_types) {
   TensorData<double> testData = TensorData<double>({5, 3, 2}, {
     {{0,0,0}, 0.0},
     {{0,0,1}, 1.0},
@@ -421,3 +421,184 @@ TEST(DISABLED_tensor_types, coordinate_types) {
   }
 
 }
+
+TEST(tensor_types, int64_positions) {
+  Format csr64({Dense, Sparse});
+  csr64.setLevelArrayTypes({{Int32}, {Int64, Int32}});
+  ASSERT_EQ(Int64, csr64.getPositionType());
+  ASSERT_EQ(Int32, CSR.getPositionType());
+  ASSERT_NE(csr64, CSR);
+
+  Tensor<double> B("B", {4, 5}, csr64);
+  Tensor<double> B32("B32", {4, 5}, CSR);
+  Tensor<double> C("C", {4, 5}, csr64);
+  Tensor<double> expected("expected", {4, 5}, CSR);
+  for (int n = 0; n < 4; n++) {
+    B.insert({n, (2*n) % 5}, n + 1.0);
+    B32.insert({n, (2*n) % 5}, n + 1.0);
+    C.insert({n, (3*n + 1) % 5}, 2.0);
+    expected.insert({n, (2*n) % 5}, n + 1.0);
+    expected.insert({n, (3*n + 1) % 5}, 2.0);
+  }
+  B.pack();
+  B32.pack();
+  C.pack();
+  expected.pack();
+  const Index& index = B.getStorage().getIndex();
+  ASSERT_EQ(Int64, index.getModeIndex(1).getIndexArray(0).getType());
+  ASSERT_EQ(Int32, index.getModeIndex(1).getIndexArray(1).getType());
+
+  Tensor<double> c("c", {5}, Format({Dense}));
+  for (int n = 0; n < 5; n++) {
+    c.insert({n}, n + 1.0);
+  }
+  c.pack();
+
+  for (auto mode : {ExecutionMode::Compiled, ExecutionMode::Interpreted}) {
+    // Assembled results get 64-bit position arrays
+    Tensor<double> A("A", {4, 5}, csr64);
+    A.setExecutionMode(mode);
+    A(i,j) = B(i,j) + C(i,j);
+    A.evaluate();
+    ASSERT_EQ(Int64, A.getStorage().getIndex().getModeIndex(1)
+                      .getIndexArray(0).getType());
+    ASSERT_TRUE(equals(expected, A));
+
+    Tensor<double> a("a", {4}, Format({Dense}));
+    Tensor<double> a32("a32", {4}, Format({Dense}));
+    a.setExecutionMode(mode);
+    a(i) = B(i,j) * c(j);
+    a32(i) = B32(i,j) * c(j);
+    a.evaluate();
+    a32.evaluate();
+    ASSERT_TRUE(equals(a32, a));
+    if (mode == ExecutionMode::Compiled) {
+      ASSERT_NE(std::string::npos, a.getSource().find("int64_t*"));
+      // The runtime header's search helpers take 64-bit positions
+      std::string source = a32.getSource();
+      size_t kernels = source.find("deinit_taco_tensor_t");
+      ASSERT_NE(std::string::npos, kernels);
+      ASSERT_EQ(std::string::npos, source.find("int64_t", kernels));
+    }
+  }
+
+  // Components are packed from and extracted into buffers with 64-bit
+  // positions
+  Tensor<double> D("D", {4, 5}, csr64);
+  vector<int> rows = {3, 0, 2, 1};
+  vector<int> cols = {1, 0, 4, 4};
+  vector<double> vals = {1.0, 2.0, 0.0, 3.0};
+  D.insertComponents({makeArray(rows), makeArray(cols)}, makeArray(vals));
+  D.pack();
+  Tensor<double> expectedD("expectedD", {4, 5}, CSR);
+  for (size_t n = 0; n < rows.size(); n++) {
+    expectedD.insert({rows[n], cols[n]}, vals[n]);
+  }
+  expectedD.pack();
+  ASSERT_TRUE(equals(expectedD, D));
+
+  Format csc64({Dense, Sparse}, {1, 0});
+  csc64.setLevelArrayTypes({{Int32}, {Int64, Int32}});
+  Tensor<double> E = convert(D, csc64);
+  ASSERT_EQ(Int64, E.getStorage().getIndex().getModeIndex(1)
+                    .getIndexArray(0).getType());
+  ASSERT_TRUE(equals(convert(expectedD, CSC), E));
+  Tensor<double> F = D.removeExplicitZeros(csc64);
+  ASSERT_EQ(3u, F.getStorage().getIndex().getSize());
+}
+
+TEST(tensor_types, narrow_coordinates) {
+  Format dcsr = narrowCoordinateTypes(DCSR, {200, 70000});
+  ASSERT_EQ(UInt8, dcsr.getCoordinateTypeIdx(0));
+  ASSERT_EQ(Int32, dcsr.getCoordinateTypeIdx(1));
+  Format csr = narrowCoordinateTypes(CSR, {70000, 300});
+  ASSERT_EQ(UInt16, csr.getCoordinateTypeIdx(1));
+  ASSERT_EQ(Int32, csr.getCoordinateTypePos(1));
+  csr = narrowCoordinateTypes(CSR, {300, 60000});
+  ASSERT_EQ(UInt16, csr.getCoordinateTypeIdx(1));
+
+  Tensor<double> B("B", {300, 60000}, csr);
+  Tensor<double> C("C", {300, 60000}, narrowCoordinateTypes(DCSR, {300, 60000}));
+  Tensor<double> expected("expected", {300, 60000}, CSR);
+  Tensor<double> c("c", {60000}, Format({Dense}));
+  for (int n = 0; n < 300; n += 7) {
+    B.insert({n, (n * 199) % 60000}, n + 1.0);
+    C.insert({n, (n * 211 + 59000) % 60000}, 2.0);
+    expected.insert({n, (n * 199) % 60000}, n + 1.0);
+    expected.insert({n, (n * 211 + 59000) % 60000}, 2.0);
+  }
+  for (int n = 0; n < 60000; n += 100) {
+    c.insert({n}, 0.5 * n);
+  }
+  B.pack();
+  C.pack();
+  expected.pack();
+  c.pack();
+  ASSERT_EQ(UInt16, B.getStorage().getIndex().getModeIndex(1)
+                     .getIndexArray(1).getType());
+
+  for (auto mode : {ExecutionMode::Compiled, ExecutionMode::Interpreted}) {
+    Tensor<double> A("A", {300, 60000}, csr);
+    A.setExecutionMode(mode);
+    A(i,j) = B(i,j) + C(i,j);
+    A.evaluate();
+    ASSERT_EQ(UInt16, A.getStorage().getIndex().getModeIndex(1)
+                       .getIndexArray(1).getType());
+    ASSERT_TRUE(equals(expected, A));
+
+    Tensor<double> a("a", {300}, Format({Dense}));
+    Tensor<double> expecteda("expecteda", {300}, Format({Dense}));
+    a.setExecutionMode(mode);
+    a(i) = A(i,j) * c(j);
+    expecteda(i) = expected(i,j) * c(j);
+    a.evaluate();
+    expecteda.evaluate();
+    ASSERT_TRUE(equals(expecteda, a));
+
+    // Narrow coordinate arrays are searched with helpers of their type
+    Tensor<double> d("d", {300, 60000}, csr);
+    Tensor<double> expectedd("expectedd", {300, 60000}, CSR);
+    d.setExecutionMode(mode);
+    d(i,j) = A(i,j) * B(i,j);
+    expectedd(i,j) = expected(i,j) * B(i,j);
+    d.compile(d.getAssignment().concretize()
+                               .mergeby(j, MergeStrategy::BlockIntersect));
+    d.assemble();
+    d.compute();
+    expectedd.evaluate();
+    ASSERT_TRUE(equals(expectedd, d));
+    if (mode == ExecutionMode::Compiled) {
+      ASSERT_NE(std::string::npos,
+                d.getSource().find("taco_intersectAdvance_uint16("));
+    }
+
+    // As are 64-bit position arrays
+    Format csr64 = csr;
+    csr64.setLevelArrayTypes({{Int32}, {Int64, UInt16}});
+    Tensor<double> B64("B64", {300, 60000}, csr64);
+    for (auto& value : iterate<double>(B)) {
+      B64.insert({value.first[0], value.first[1]}, value.second);
+    }
+    B64.pack();
+    IndexVar f("f"), fpos("fpos"), f0("f0"), f1("f1");
+    Tensor<double> b("b", {300}, Format({Dense}));
+    Tensor<double> expectedb("expectedb", {300}, Format({Dense}));
+    b.setExecutionMode(mode);
+    b(i) = B64(i,j) * c(j);
+    expectedb(i) = B(i,j) * c(j);
+    b.compile(b.getAssignment().concretize()
+                               .fuse(i, j, f)
+                               .pos(f, fpos, B64(i,j))
+                               .split(fpos, f0, f1, 4)
+                               .parallelize(f0, ParallelUnit::CPUThread,
+                                            OutputRaceStrategy::Atomics));
+    b.assemble();
+    b.compute();
+    expectedb.evaluate();
+    ASSERT_TRUE(equals(expectedb, b));
+    if (mode == ExecutionMode::Compiled) {
+      ASSERT_NE(std::string::npos,
+                b.getSource().find("taco_binarySearchBefore_int64("));
+    }
+  }
+}
@@ -186,6 +186,11 @@ static void printUsageInfo() {
   cout << endl;
   printFlag("cuda", "Generate CUDA code for NVIDIA GPUs");
   cout << endl;
+  printFlag("interpret",
+            "Interpret the kernels instead of compiling them. Compare the "
+            "-time results with and without this option to find the problem "
+            "size at which compiling kernels pays off.");
+  cout << endl;
   printFlag("schedule", "Specify parallel execution schedule");
   cout << endl;
   printFlag("nthreads", "Specify number of threads for parallel execution");
@@ -453,6 +458,23 @@ static bool setSchedulingCommands(istream& in, parser::Parser& parser, IndexStmt
 
       stmt = stmt.parallelize(findVar(i), parallel_unit, output_race_strategy);
 
+    } else if (command == "mergeby") {
+      string i, strategy;
+      in >> i;
+      in >> strategy;
+
+      MergeStrategy merge_strategy;
+      if (strategy == "TwoFinger") {
+        merge_strategy = MergeStrategy::TwoFinger;
+      } else if (strategy == "BlockIntersect") {
+        merge_strategy = MergeStrategy::BlockIntersect;
+      } else {
+        taco_uerror << "Merge strategy not defined.";
+        goto end;
+      }
+
+      stmt = stmt.mergeby(findVar(i), merge_strategy);
+
     } else {
       break; 
     }
@@ -489,6 +511,7 @@ int main(int argc, char* argv[]) {
   bool color               = true;
   bool readKernels         = false;
   bool cuda                = false;
+  bool interpret           = false;
 
   bool setSchedule         = false; 
 
@@ -777,6 +800,9 @@ int main(int argc, char* argv[]) {
     else if ("-cuda" == argName) {
       cuda = true;
     }
+    else if ("-interpret" == argName) {
+      interpret = true;
+    }
     else if ("-schedule" == argName) {
       vector<string> descriptor = util::split(argValue, ",");
       if (descriptor.size() > 2 || descriptor.empty()) {
@@ -954,25 +980,37 @@ int main(int argc, char* argv[]) {
   if (benchmark) {
     if (time) cout << endl;
 
-    shared_ptr<ir::Module> module(new ir::Module);
+    if (interpret) {
+      // Interpreted kernels only have to be lowered
+      tensor.setExecutionMode(ExecutionMode::Interpreted);
+      TOOL_BENCHMARK_TIMER(tensor.compile(stmt, computeWithAssemble),
+                           "Compile: ", compileTime);
 
-    TOOL_BENCHMARK_TIMER(
       compute = lower(stmt, "compute",  computeWithAssemble, true);
       assemble = lower(stmt, "assemble", true, false);
       evaluate = lower(stmt, "evaluate", true, true);
+    }
+    else {
+      shared_ptr<ir::Module> module(new ir::Module);
 
-      module->addFunction(compute);
-      module->addFunction(assemble);
-      module->addFunction(evaluate);
-      module->compile();
-    , "Compile: ", compileTime);
-      
-    void* compute  = module->getFuncPtr("compute");
-    void* assemble = module->getFuncPtr("assemble");
-    void* evaluate = module->getFuncPtr("evaluate");
-    kernel = Kernel(stmt, module, evaluate, assemble, compute);
+      TOOL_BENCHMARK_TIMER(
+        compute = lower(stmt, "compute",  computeWithAssemble, true);
+        assemble = lower(stmt, "assemble", true, false);
+        evaluate = lower(stmt, "evaluate", true, true);
 
-    tensor.compileSource(util::toString(kernel));
+        module->addFunction(compute);
+        module->addFunction(assemble);
+        module->addFunction(evaluate);
+        module->compile();
+      , "Compile: ", compileTime);
+
+      void* compute  = module->getFuncPtr("compute");
+      void* assemble = module->getFuncPtr("assemble");
+      void* evaluate = module->getFuncPtr("evaluate");
+      kernel = Kernel(stmt, module, evaluate, assemble, compute);
+
+      tensor.compileSource(util::toString(kernel));
+    }
 
     TOOL_BENCHMARK_TIMER(tensor.assemble(),"Assemble:",assembleTime);
     if (repeat == 1) {